@@ -0,0 +1,101 @@
+/**
+* IMCA is a analyzing tool for unbounded reachability probabilities, expected-
+* time, and long-run averages for Interactive Markov Chains and Markov Automata.
+* Copyright (C) RWTH Aachen, 2012
+*				UTwente, 2013
+* 	Author: Dennis Guck
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*
+* @file backward.cpp
+* @brief Backward graph searches over the predecessor choices of the MA
+* @author Dennis Guck
+* @version 1.0
+*
+*/
+
+#ifndef BACKWARD_H
+#define BACKWARD_H
+
+#include "sparse.h"
+
+/**
+* Finds the states which reach @a target with positive probability under
+* some scheduler.
+*
+* @param ma the MA
+* @param target the target states
+* @param inside the states the paths may pass, all if NULL
+* @param choice_ok the choices the paths may take, all if NULL
+* @param result the states reaching @a target
+*/
+extern void reach_some(SparseMatrix *ma, const bool *target, const bool *inside, const bool *choice_ok, bool *result);
+
+/**
+* Finds the states which reach @a target with positive probability under
+* every scheduler.
+*
+* @param ma the MA
+* @param target the target states
+* @param result the states reaching @a target
+*/
+extern void reach_all(SparseMatrix *ma, const bool *target, bool *result);
+
+/**
+* Finds the states which reach the goal states with probability 1 under
+* some scheduler: the largest set of states which reach a goal state by
+* choices that do not leave the set.
+*
+* @param ma the MA
+* @param result the states reaching a goal state almost surely
+*/
+extern void reach_surely_some(SparseMatrix *ma, bool *result);
+
+/**
+* Finds the states which reach the goal states with probability 1 under
+* every scheduler: the states which cannot reach a state of probability 0
+* before a goal state.
+*
+* @param ma the MA
+* @param positive the states which reach a goal state with positive probability under every scheduler
+* @param result the states reaching a goal state almost surely
+*/
+extern void reach_surely_all(SparseMatrix *ma, const bool *positive, bool *result);
+
+/**
+* Extends @a set by every state outside @a fixed of which all choices (or
+* at least one choice) only lead to states of @a set, until no state is
+* added. A state without choices is added if @a every_choice is set.
+*
+* @param ma the MA
+* @param fixed the states never added
+* @param every_choice all choices/some choice has to stay in @a set
+* @param set the states, extended
+*/
+extern void close_backward(SparseMatrix *ma, const bool *fixed, bool every_choice, bool *set);
+
+/**
+* Extends @a set by its attractor: every state which is not bad and of which
+* each choice that is not bad has a transition to a state of @a set which is
+* not bad, until no state is added.
+*
+* @param ma the MA
+* @param bad_states the states which are neither added nor attract
+* @param bad_transitions the choices which are ignored
+* @param set the states, extended
+*/
+extern void attractor(SparseMatrix *ma, const bool *bad_states, const bool *bad_transitions, bool *set);
+
+#endif
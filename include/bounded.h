@@ -31,10 +31,41 @@
 #define BOUNDED_H
 
 #include "sparse.h"
+#include "result_sink.h"
 #include "soplex.h"
+#include <vector>
 
 using namespace soplex;
 
-extern Real compute_time_bounded_reachability(SparseMatrix* ma, bool max, Real epsilon, Real ta, Real tb, bool is_imc, Real interval,Real interval_start);
+/* the adaptive discretisation starts with this fraction of the steps of the fixed one */
+#define ADAPTIVE_FIRST_STEP_DIVISOR 64
+
+typedef struct InteractiveClosure InteractiveClosure;
+
+/**
+* The Markovian and goal states each state reaches by interactive transitions
+* only, used for the value iteration of IMCs. Stored as one flat array like
+* the MECs. States of the same strongly connected component share a closure.
+*/
+struct InteractiveClosure
+{
+	unsigned long n;			/* # of closures */
+	sparse_index *cols;			/* reachable Markovian and goal states */
+	sparse_index *row_starts;		/* first state of each closure */
+	sparse_index *rows;			/* closure of each state */
+};
+
+extern SparseMatrix* discretize_model(SparseMatrix* ma, Real tau);
+
+extern Real compute_time_bounded_reachability(SparseMatrix* ma, bool max, Real epsilon, Real ta, Real tb, bool is_imc, Real interval,Real interval_start, ResultSink *sink);
+
+extern void compute_time_bounded_reachability_both(SparseMatrix* ma, Real epsilon, Real ta, Real tb, bool is_imc, Real interval,Real interval_start, Real *max_prob, Real *min_prob, ResultSink *sink);
+extern Real compute_time_bounded_reachability_adaptive(SparseMatrix* ma, bool max, Real epsilon, Real tb, bool is_imc, ResultSink *sink);
+
+extern InteractiveClosure* interactiveReachability(SparseMatrix* ma);
+extern void InteractiveClosure_free(InteractiveClosure *reach);
+
+extern void compute_time_bounded_reachability_sweep(SparseMatrix* ma, Real epsilon, const std::vector<Real>& tbs, bool is_imc, bool max, bool min,
+		std::vector<Real>& max_probs, std::vector<Real>& min_probs, std::vector<double>& max_times, std::vector<double>& min_times);
 
 #endif
@@ -0,0 +1,80 @@
+/**
+* IMCA is a analyzing tool for unbounded reachability probabilities, expected-
+* time, and long-run averages for Interactive Markov Chains and Markov Automata.
+* Copyright (C) RWTH Aachen, 2012
+*				UTwente, 2013
+* 	Author: Dennis Guck
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*
+* @file interval_iteration.cpp
+* @brief Sound value iteration with lower and upper bounds for unbounded
+*	reachability, expected time and expected reward
+* @author Dennis Guck
+* @version 1.0
+*
+*/
+
+#ifndef INTERVAL_ITERATION_H
+#define INTERVAL_ITERATION_H
+
+#include <vector>
+
+#include "sparse.h"
+
+#ifdef __SOPLEX__
+#include "soplex.h"
+#endif
+
+using namespace soplex;
+
+/**
+* Fixes the values which follow from the graph of the MA alone and marks the
+* other states unknown.
+*
+* @param ma the MA
+* @param objective the objective
+* @param max maximum/minimum
+* @param values fixed value of each state, 0 for unknown states
+* @param unknown the states whose value is not fixed
+* @return # of unknown states
+*/
+extern unsigned long graph_values(SparseMatrix *ma, ValueObjective objective, bool max, std::vector<Real>& values, bool *unknown);
+
+/**
+* Computes the time or reward of each choice until the next state.
+*
+* @param ma the MA, prepared
+* @param objective the objective
+* @param cost cost of each choice
+*/
+extern void choice_costs(const SparseMatrix *ma, ValueObjective objective, std::vector<Real>& cost);
+
+/**
+* Computes an objective by interval iteration: a lower and an upper bound of
+* the value of every state are iterated until they are at most @a epsilon
+* apart at the initial states.
+*
+* @param ma the MA
+* @param objective the objective
+* @param max maximum/minimum
+* @param epsilon width of the interval
+* @param lower lower bound for the initial states
+* @param upper upper bound for the initial states
+* @return the middle of the interval
+*/
+extern Real interval_iteration(SparseMatrix *ma, ValueObjective objective, bool max, Real epsilon, Real *lower, Real *upper);
+
+#endif
@@ -0,0 +1,177 @@
+/**
+* IMCA is a analyzing tool for unbounded reachability probabilities, expected-
+* time, and long-run averages for Interactive Markov Chains and Markov Automata.
+* Copyright (C) RWTH Aachen, 2012
+*				UTwente, 2013
+* 	Author: Dennis Guck
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*
+* @file lexer.h
+* @brief Memory-mapped lexer for model files
+* @author Dennis Guck
+* @version 1.0
+*
+*/
+
+#ifndef LEXER_H
+#define LEXER_H
+
+#include <stddef.h>
+#include <string.h>
+
+#include "sparse.h"
+
+#ifdef __SOPLEX__
+#include "soplex.h"
+using namespace soplex;
+#endif
+
+typedef struct Lexer Lexer;
+
+/**
+* A lexer working in place on a memory-mapped model file. Tokens are returned
+* as pointer and length into the mapped file, nothing is copied.
+*/
+struct Lexer
+{
+	const char *begin;		/* first character of the file */
+	const char *end;		/* one past the last character of the file */
+	const char *pos;		/* current position */
+	unsigned long line_no;		/* line number of the current position */
+	bool mapped;			/* file is mapped, otherwise read into memory */
+};
+
+/**
+* Maps file @a filename into memory.
+*
+* @param lx the lexer
+* @param filename the file
+* @return false if the file could not be opened or read
+*/
+extern bool Lexer_open(Lexer *lx, const char *filename);
+
+/**
+* Unmaps the file of the lexer.
+*
+* @param lx the lexer
+*/
+extern void Lexer_close(Lexer *lx);
+
+/**
+* Reads a real number at the current position.
+*
+* @param lx the lexer
+* @param value the number
+* @return false if there is no number
+*/
+extern bool lexer_real(Lexer *lx, Real *value);
+
+/**
+* Reads a real number with an optional denominator, i.e. "a" or "a/b".
+*
+* @param lx the lexer
+* @param value the number a/b
+* @return false if there is no number
+*/
+extern bool lexer_fraction(Lexer *lx, Real *value);
+
+/**
+* Starts again at the beginning of the file.
+*/
+inline void lexer_rewind(Lexer *lx)
+{
+	lx->pos = lx->begin;
+	lx->line_no = 1;
+}
+
+/**
+* @return true if the whole file is read
+*/
+inline bool lexer_eof(const Lexer *lx)
+{
+	return lx->pos >= lx->end;
+}
+
+/**
+* Skips spaces, tabs and carriage returns, but not the end of the line.
+*/
+inline void lexer_skip_blanks(Lexer *lx)
+{
+	const char *pos = lx->pos;
+	const char *end = lx->end;
+	while (pos < end && (*pos == ' ' || *pos == '\t' || *pos == '\r'))
+		pos++;
+	lx->pos = pos;
+}
+
+/**
+* @return true if there is nothing but blanks left on the current line
+*/
+inline bool lexer_eol(Lexer *lx)
+{
+	lexer_skip_blanks(lx);
+	return lx->pos >= lx->end || *lx->pos == '\n';
+}
+
+/**
+* Goes to the beginning of the next line.
+*
+* @return false if there is no next line
+*/
+inline bool lexer_next_line(Lexer *lx)
+{
+	if (lx->pos >= lx->end)
+		return false;
+	const char *nl = (const char *) memchr(lx->pos, '\n', lx->end - lx->pos);
+	if (nl == NULL) {
+		lx->pos = lx->end;
+		return false;
+	}
+	lx->pos = nl + 1;
+	lx->line_no++;
+	return lx->pos < lx->end;
+}
+
+/**
+* Reads the next blank-separated token of the current line.
+*
+* @param lx the lexer
+* @param token start of the token (inside the mapped file)
+* @param length length of the token
+* @return false if the line has no more tokens
+*/
+inline bool lexer_token(Lexer *lx, const char **token, size_t *length)
+{
+	lexer_skip_blanks(lx);
+	const char *pos = lx->pos;
+	const char *end = lx->end;
+	*token = pos;
+	while (pos < end && *pos != ' ' && *pos != '\t' && *pos != '\r' && *pos != '\n')
+		pos++;
+	*length = pos - *token;
+	lx->pos = pos;
+	return *length > 0;
+}
+
+/**
+* @return true if token @a token of length @a length equals @a str
+*/
+inline bool token_equals(const char *token, size_t length, const char *str)
+{
+	return strlen(str) == length && memcmp(token, str, length) == 0;
+}
+
+#endif
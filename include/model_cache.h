@@ -0,0 +1,70 @@
+/**
+* IMCA is a analyzing tool for unbounded reachability probabilities, expected-
+* time, and long-run averages for Interactive Markov Chains and Markov Automata.
+* Copyright (C) RWTH Aachen, 2012
+*				UTwente, 2013
+* 	Author: Dennis Guck
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*
+* @file model_cache.cpp
+* @brief Binary cache (.imcab) of compiled models
+* @author Dennis Guck
+* @version 1.0
+*
+*/
+
+#ifndef MODEL_CACHE_H
+#define MODEL_CACHE_H
+
+#include "sparse.h"
+
+#ifdef __SOPLEX__
+#include "soplex.h"
+using namespace soplex;
+#endif
+
+/* the compiled model of "model.ma" is stored in "model.ma.imcab" */
+#define MODEL_CACHE_EXT ".imcab"
+
+/* first bytes of every compiled model */
+#define MODEL_CACHE_MAGIC "IMCAB\0\0\0"
+
+/* increase whenever the layout of the file changes */
+#define MODEL_CACHE_VERSION 2
+
+/**
+* Writes MA @a ma, read from @a model_file, to the compiled model @a cache_file.
+*
+* @param ma the MA
+* @param model_file the file the MA was read from
+* @param cache_file the compiled model
+* @param mrm true if rewards are stored
+* @return false if the compiled model could not be written
+*/
+extern bool write_model_cache(const SparseMatrix *ma, const char *model_file, const char *cache_file, bool mrm);
+
+/**
+* Maps the compiled model @a cache_file into memory. The compiled model is
+* only used if it was written for the current version of @a model_file.
+*
+* @param model_file the model the compiled model was made from
+* @param cache_file the compiled model
+* @param mrm true if rewards are needed
+* @return MA, or NULL if there is no up-to-date compiled model
+*/
+extern SparseMatrix *read_model_cache(const char *model_file, const char *cache_file, bool mrm);
+
+#endif
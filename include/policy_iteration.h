@@ -0,0 +1,55 @@
+/**
+* IMCA is a analyzing tool for unbounded reachability probabilities, expected-
+* time, and long-run averages for Interactive Markov Chains and Markov Automata.
+* Copyright (C) RWTH Aachen, 2012
+*				UTwente, 2013
+* 	Author: Dennis Guck
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*
+* @file policy_iteration.cpp
+* @brief Policy iteration for unbounded reachability, expected time and
+*	expected reward
+* @author Dennis Guck
+* @version 1.0
+*
+*/
+
+#ifndef POLICY_ITERATION_H
+#define POLICY_ITERATION_H
+
+#include "sparse.h"
+
+#ifdef __SOPLEX__
+#include "soplex.h"
+#endif
+
+using namespace soplex;
+
+/**
+* Computes an objective by policy iteration: the values of a scheduler are
+* computed by Gauss-Seidel sweeps up to a relative precision of 1e-7, then
+* every state switches to a choice which is better by more than this
+* precision under these values, until no state switches. A block which is
+* not stable after a bounded number of sweeps is reported as an error.
+*
+* @param ma the MA
+* @param objective the objective
+* @param max maximum/minimum
+* @return value of the initial states
+*/
+extern Real policy_iteration(SparseMatrix *ma, ValueObjective objective, bool max);
+
+#endif
@@ -36,7 +36,6 @@
 using namespace soplex;
 #endif
 
-#define MAX_LINE_LENGTH 1024
 #define MARKOV_ACTION "!"
 #define INITIALS "#INITIALS"
 #define GOALS "#GOALS"
@@ -35,7 +35,6 @@
 #include "soplex.h"
 #endif
 
-#define MAX_LINE_LENGTH 1024
 #define MARKOV_ACTION "!"
 #define INITIALS "#INITIALS"
 #define GOALS "#GOALS"
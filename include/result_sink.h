@@ -0,0 +1,109 @@
+/**
+* IMCA is a analyzing tool for unbounded reachability probabilities, expected-
+* time, and long-run averages for Interactive Markov Chains and Markov Automata.
+* Copyright (C) RWTH Aachen, 2012
+*				UTwente, 2013
+* 	Author: Dennis Guck
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*
+* @file result_sink.cpp
+* @brief Buffered CSV or JSON lines output of time series and state vectors
+* @author Dennis Guck
+* @version 1.0
+*
+*/
+
+#ifndef RESULT_SINK_H
+#define RESULT_SINK_H
+
+#include "sparse.h"
+
+#ifdef __SOPLEX__
+#include "soplex.h"
+using namespace soplex;
+#endif
+
+#include <stdio.h>
+
+/* size of the output buffer of a sink */
+#define RESULT_SINK_BUFFER_SIZE (1 << 20)
+
+typedef struct ResultSink ResultSink;
+
+/**
+* Receives the results of an analysis, one record per line, either as CSV
+* with the columns analysis,objective,time,state,value or as JSON lines.
+* The state is empty for the optimum over the initial states.
+*/
+struct ResultSink
+{
+	FILE *file;			/* output, fully buffered */
+	bool is_stdout;			/* file is stdout and is not closed */
+	bool json;			/* JSON lines instead of CSV */
+	bool initials;			/* write the value of each initial state next to the optimum */
+	bool vector;			/* write the value of every state at the end */
+	char *buffer;			/* output buffer */
+};
+
+/**
+* Opens a sink.
+*
+* @param path output file, "-" for stdout
+* @param json write JSON lines instead of CSV
+* @param initials write the value of each initial state next to the optimum
+* @param vector write the value of every state at the end
+* @return the sink, or NULL if @a path cannot be opened
+*/
+extern ResultSink* ResultSink_new(const char *path, bool json, bool initials, bool vector);
+
+/**
+* Flushes and closes a sink.
+*
+* @param sink the sink, may be NULL
+*/
+extern void ResultSink_free(ResultSink *sink);
+
+/**
+* Writes one record.
+*
+* @param sink the sink
+* @param analysis the analysis, like "tb"
+* @param max maximum/minimum
+* @param time time point of the value
+* @param state name of the state, NULL for the optimum over the initial states
+* @param value the value
+*/
+extern void ResultSink_write(ResultSink *sink, const char *analysis, bool max, Real time, const char *state, Real value);
+
+/**
+* Writes the optimum over the initial states and, if the sink asks for them,
+* the values of the initial states or of all states.
+*
+* @param sink the sink
+* @param ma the MA
+* @param analysis the analysis, like "tb"
+* @param max maximum/minimum
+* @param time time point of the values
+* @param u the values, @a width per state
+* @param width # of objectives in @a u
+* @param slot objective to take from @a u
+* @param optimum the optimum over the initial states
+* @param last true for the final result, which includes the vector
+*/
+extern void ResultSink_values(ResultSink *sink, const SparseMatrix *ma, const char *analysis, bool max, Real time,
+		const Real *u, unsigned long width, unsigned long slot, Real optimum, bool last);
+
+#endif
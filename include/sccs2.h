@@ -1,53 +1,108 @@
-/**
-* IMCA is a analyzing tool for unbounded reachability probabilities, expected-
-* time, and long-run averages for Interactive Markov Chains and Markov Automata.
-* Copyright (C) RWTH Aachen, 2012
-*				UTwente, 2013
-* 	Author: Dennis Guck
-*
-* This program is free software: you can redistribute it and/or modify
-* it under the terms of the GNU General Public License as published by
-* the Free Software Foundation, either version 3 of the License, or
-* (at your option) any later version.
-*
-* This program is distributed in the hope that it will be useful,
-* but WITHOUT ANY WARRANTY; without even the implied warranty of
-* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
-* GNU General Public License for more details.
-*
-* You should have received a copy of the GNU General Public License
-* along with this program.  If not, see <http://www.gnu.org/licenses/>.
-* 
-* @file scc2.h
-* @author Daan van Beek (s0167789)
-* @version 1.0
-*
-* Created on January 5, 2013, 4:37 PM
-*/
-
-#ifndef SCCS2_H
-#define	SCCS2_H
-
-#include "sparse.h"
-#include <vector>
-
-#ifdef __SOPLEX__
-#include "soplex.h"
-#endif
-
-using namespace soplex;
-
-
-/**
- * Compute MECs
- * 
- * @param ma file to read MA from
- */
-extern SparseMatrixMEC* mEC_decomposition_previous_algorithm(SparseMatrix*);
-
-extern SparseMatrixMEC* mEC_decomposition_previous_algorithm_without_attractor(SparseMatrix*, vector<unsigned long>&);
-
-extern void compute_SCC_decomposition_tarjan(SparseMatrix *ma, vector<unsigned long>& scc_states, bool* bad_states, bool* bad_transitions, unsigned long& scc_nr);
-
-#endif	/* SCCS2_H */
-
+/**
+* IMCA is a analyzing tool for unbounded reachability probabilities, expected-
+* time, and long-run averages for Interactive Markov Chains and Markov Automata.
+* Copyright (C) RWTH Aachen, 2012
+*				UTwente, 2013
+* 	Author: Dennis Guck
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+* 
+* @file scc2.h
+* @author Daan van Beek (s0167789)
+* @version 1.0
+*
+* Created on January 5, 2013, 4:37 PM
+*/
+
+#ifndef SCCS2_H
+#define	SCCS2_H
+
+#include "sparse.h"
+#include <vector>
+
+#ifdef __SOPLEX__
+#include "soplex.h"
+#endif
+
+using namespace soplex;
+
+
+/**
+ * Compute MECs
+ * 
+ * @param ma file to read MA from
+ */
+extern SparseMatrixMEC* mEC_decomposition_previous_algorithm(SparseMatrix*);
+
+extern SparseMatrixMEC* mEC_decomposition_previous_algorithm_without_attractor(SparseMatrix*, vector<unsigned long>&);
+
+typedef struct SCCSearch SCCSearch;
+
+/**
+* How the bad states and transitions grow during an SCC search.
+*/
+enum SCCBadRule
+{
+	SCC_BAD_NONE,			/* the bad states and transitions stay as given */
+	SCC_BAD_ALL_CHOICES,		/* a choice reaching a bad state turns bad, a state with only bad choices turns bad */
+	SCC_BAD_ANY_CHOICE		/* a choice reaching a bad state turns bad, a state with a bad choice turns bad */
+};
+
+/**
+* Iterative Tarjan search for the nontrivial SCCs of an MA, leaving out bad
+* states and bad transitions (choices). The recursion is kept on an explicit
+* stack, so long chains of states do not overflow the call stack. A single
+* state is an SCC of its own only with a self-loop: for SCC_BAD_ANY_CHOICE a
+* transition to itself, otherwise a choice which is not bad and only leads to
+* itself.
+* Unless the rule is SCC_BAD_NONE, a choice which leaves its SCC only partially
+* turns bad as well. An SCC which loses states or choices this way is searched
+* again on its own as soon as it is completed, so the states reaching it see
+* its final bad states.
+*/
+struct SCCSearch
+{
+	const SparseMatrix *ma;
+	bool *bad_states;			/* states left out, may grow with the rule */
+	bool *bad_transitions;			/* choices left out, may grow with the rule */
+	SCCBadRule rule;			/* how bad states and transitions grow */
+	unsigned long next_index;		/* next depth first index */
+	unsigned long *index;			/* depth first index of each state, (unsigned long) -1 if not visited */
+	unsigned long *lowlink;			/* smallest index reachable in the search tree of each state */
+	bool *on_stack;				/* state is on the SCC stack */
+	sparse_index *next_choice;		/* next choice of each state to search */
+	sparse_index *next_transition;		/* next transition of each state to search */
+	unsigned long *bad_choices;		/* # of choices of each state found bad */
+	sparse_index *scc_stack;		/* states of the open SCCs */
+	sparse_index *call_stack;		/* states whose search is not finished */
+	sparse_index *retry;			/* states of split SCCs to be searched again */
+	unsigned long retry_n;			/* # of states in retry */
+	bool *in_retry;				/* state is in retry */
+	sparse_index *completed;		/* states of all completed SCCs, trivial ones included, NULL if not recorded */
+	sparse_index *completed_starts;		/* first state of each completed SCC in completed */
+	unsigned long completed_n;		/* # of completed SCCs */
+};
+
+extern SCCSearch* SCCSearch_new(const SparseMatrix *ma, bool *bad_states, bool *bad_transitions, SCCBadRule rule);
+extern void SCCSearch_free(SCCSearch *search);
+extern void SCCSearch_reset(SCCSearch *search);
+extern void SCCSearch_record(SCCSearch *search, sparse_index *states, sparse_index *starts);
+extern bool SCCSearch_visited(const SCCSearch *search, unsigned long state_nr);
+extern bool SCCSearch_visit(SCCSearch *search, unsigned long root, vector<unsigned long>& scc_states, unsigned long& scc_nr);
+
+extern void compute_SCC_decomposition_tarjan(SparseMatrix *ma, vector<unsigned long>& scc_states, bool* bad_states, bool* bad_transitions, unsigned long& scc_nr);
+extern void compute_SCC_decomposition_stable(SparseMatrix *ma, vector<unsigned long>& scc_states, bool* bad_states, bool* bad_transitions, SCCBadRule rule, unsigned long& scc_nr);
+
+#endif	/* SCCS2_H */
+
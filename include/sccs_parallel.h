@@ -0,0 +1,90 @@
+/**
+* IMCA is a analyzing tool for unbounded reachability probabilities, expected-
+* time, and long-run averages for Interactive Markov Chains and Markov Automata.
+* Copyright (C) RWTH Aachen, 2012
+*				UTwente, 2013
+* 	Author: Dennis Guck
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*
+* @file sccs_parallel.cpp
+* @brief Parallel forward-backward SCC decomposition
+* @author Dennis Guck
+* @version 1.0
+*
+*/
+
+#ifndef SCCS_PARALLEL_H
+#define SCCS_PARALLEL_H
+
+#include "sparse.h"
+#include <vector>
+
+using namespace std;
+
+/**
+* Forward-backward SCC decomposition. Every subproblem is a set of states of
+* the same colour: states of which no transition stays in the set are trimmed
+* first, then the states both reached from and reaching a pivot form an SCC,
+* and the states only reached, the states only reaching and the other states
+* become three new subproblems. Large subproblems are OpenMP tasks. Every task
+* only writes the states of its own subproblem, so several decompositions of
+* disjoint sets of states may run at the same time.
+*/
+typedef struct SCCParallel SCCParallel;
+
+struct SCCParallel
+{
+	SparseMatrix *ma;
+	const Predecessors *pred;
+	const bool *bad_states;			/* states left out */
+	const bool *bad_transitions;		/* choices left out */
+	unsigned long next_color;		/* next subproblem colour, taken atomically */
+	unsigned long *color;			/* subproblem of each state, 0 once its SCC is found */
+	unsigned long *in_degree;		/* # of transitions from the subproblem of each state */
+	unsigned long *out_degree;		/* # of transitions into the subproblem of each state */
+	unsigned char *reached;			/* state reached forwards and/or backwards from the pivot */
+	unsigned long *root;			/* pivot of the SCC of each state, (unsigned long) -1 for a single state */
+	unsigned long *number;			/* SCC number of each pivot while numbering */
+};
+
+/**
+* @param ma the MA
+* @param bad_states states left out, may change between decompositions
+* @param bad_transitions choices left out, may change between decompositions
+* @return new decomposition
+*/
+extern SCCParallel* SCCParallel_new(SparseMatrix *ma, const bool *bad_states, const bool *bad_transitions);
+
+/**
+* @param engine the decomposition to be freed
+*/
+extern void SCCParallel_free(SCCParallel *engine);
+
+/**
+* Numbers the nontrivial SCCs among the states @a region, starting with
+* @a scc_nr, in the order of their first state in @a region. A single state
+* is an SCC of its own if a choice which is not bad only leads to itself, as
+* in the Tarjan search.
+*
+* @param engine the decomposition
+* @param region the states, bad states are skipped
+* @param parallel use the OpenMP threads, or search in the calling thread only
+* @param scc_states SCC number of each state, left as it is for states in no SCC
+* @param scc_nr number of the next SCC, increased for every SCC found
+*/
+extern void SCCParallel_decompose(SCCParallel *engine, const vector<unsigned long>& region, bool parallel, vector<unsigned long>& scc_states, unsigned long& scc_nr);
+
+#endif
@@ -0,0 +1,138 @@
+/**
+* IMCA is a analyzing tool for unbounded reachability probabilities, expected-
+* time, and long-run averages for Interactive Markov Chains and Markov Automata.
+* Copyright (C) RWTH Aachen, 2012
+*				UTwente, 2013
+* 	Author: Dennis Guck
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*
+* @file serve.cpp
+* @brief Answers queries on a loaded model until it is told to stop
+* @author Dennis Guck
+* @version 1.0
+*
+*/
+
+#ifndef SERVE_H
+#define SERVE_H
+
+#include "sparse.h"
+
+#ifdef __SOPLEX__
+#include "soplex.h"
+using namespace soplex;
+#endif
+
+#include <stdio.h>
+#include <vector>
+
+/* maximal length of a query line */
+#define MAX_QUERY_LENGTH 1024
+
+typedef struct Query Query;
+
+/**
+* A query on the MA, see serve_queries for its textual form.
+*/
+struct Query
+{
+	char analysis[8];		/* ub, et, er, lra, lrr, tb or tr */
+	bool max;			/* compute the maximum */
+	bool min;			/* compute the minimum */
+	bool val;			/* use value iteration for ub and et */
+	bool sound;			/* use interval iteration for ub, et and er */
+	bool topo;			/* use topological value iteration for ub, et and er */
+	bool pi;			/* use policy iteration for ub, et and er */
+	bool has_tb;			/* an upper bound was given */
+	Real ta;			/* lower bound of the time interval */
+	Real tb;			/* upper bound of the time interval */
+	Real epsilon;			/* error bound */
+	Real interval;			/* interval step, 0 for [ta,tb] only */
+	Real interval_start;		/* start of the interval output */
+};
+
+/**
+* Initialises a query with the default options.
+*
+* @param q the query
+* @param analysis ub, et, er, lra, lrr, tb or tr
+* @return false if the analysis is unknown
+*/
+extern bool query_init(Query *q, const char *analysis);
+
+/**
+* Parses a query line.
+*
+* @param line the line (is changed)
+* @param q the query
+* @param error will point to the reason if the query is invalid
+* @return false if the query is invalid
+*/
+extern bool parse_query(char *line, Query *q, const char **error);
+
+/**
+* Reads the queries of a batch file, one query per line.
+*
+* @param filename the batch file, stdin for "-"
+* @param queries the queries are appended here
+* @return false if the file could not be read or contains an invalid query
+*/
+extern bool read_query_file(const char *filename, std::vector<Query> &queries);
+
+/**
+* Answers queries on MA @a ma. A query is a line
+*
+*	<analysis> [min] [max] [T=<upper bound>] [F=<lower bound>] [e=<error bound>]
+*		[i=<interval step>] [b=<interval start>] [val] [sound] [topo] [pi]
+*
+* where <analysis> is one of ub, et, er, lra, lrr, tb, tr. For every
+* requested optimum a line "<analysis> <min|max> <value> <seconds>" is
+* answered, followed by "ok", or a single line "error <reason>".
+* "info" answers the size of the MA, "quit" ends the connection and
+* "shutdown" stops the server.
+*
+* The MA and the results of its graph analyses stay in memory, so only
+* the first query pays for loading the model and computing locks and MECs.
+*
+* @param ma the MA
+* @param mrm true if the MA has rewards
+* @param is_imc true if the MA is an IMC
+* @param socket_path queries are read from this Unix domain socket, from
+*	stdin if NULL
+* @return EXIT_SUCCESS, or EXIT_FAILURE if the socket or the output could not be opened
+*/
+extern int serve_queries(SparseMatrix *ma, bool mrm, bool is_imc, const char *socket_path);
+
+/**
+* Answers all @a queries and writes the results as CSV with the columns
+*
+*	analysis,objective,F,T,e,value,seconds
+*
+* one row per query and requested optimum, in the order of the queries.
+* Time-bounded reachability queries on [0,T] with the same error bound
+* share one discretised model and one value iteration up to the largest T,
+* their time is the time until the value of their T was known.
+*
+* @param ma the MA
+* @param mrm true if the MA has rewards
+* @param is_imc true if the MA is an IMC
+* @param queries the queries
+* @param out where the results are written to
+* @return EXIT_SUCCESS, or EXIT_FAILURE if a query can not be answered
+*/
+extern int run_batch(SparseMatrix *ma, bool mrm, bool is_imc, const std::vector<Query> &queries, FILE *out);
+
+#endif
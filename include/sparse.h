@@ -32,6 +32,7 @@
 
 #include <map>
 #include <string>
+#include <stdint.h>
 
 #ifdef __SOPLEX__
 #include "soplex.h"
@@ -46,7 +47,47 @@ using namespace std;
 using namespace soplex;
 #endif
 
+/* index type of the sparse matrices, 32 bits unless built with -DIMCA_LONG_INDEX */
+#ifdef IMCA_LONG_INDEX
+typedef unsigned long sparse_index;
+#else
+typedef uint32_t sparse_index;
+#endif
+
+/* largest number of states, choices or transitions a sparse matrix can hold */
+#define SPARSE_INDEX_MAX ((unsigned long) (sparse_index) -1)
+
+/* the value iteration kernels split sweeps over at least this many states among the OpenMP threads */
+#define PARALLEL_MIN_STATES 4096
+
 typedef struct SparseMatrix SparseMatrix;
+typedef struct StatePartition StatePartition;
+typedef struct SweepOrder SweepOrder;
+typedef struct SparseMatrixMEC SparseMatrixMEC;
+typedef struct Predecessors Predecessors;
+typedef struct StateNames StateNames;
+
+/* returned by state_names_find for unknown names */
+#define NO_STATE_NAME ((unsigned long) -1)
+
+/**
+* Interned state names. All names are stored one after another in a single
+* arena, an open addressing hash table maps names to state numbers.
+* The names can be shared by several matrices.
+*/
+struct StateNames
+{
+	unsigned long n;			/* # of names */
+	char *arena;				/* names, each terminated by '\0' */
+	unsigned long arena_n;			/* used bytes of arena */
+	unsigned long arena_size;		/* size of arena */
+	unsigned long *offsets;			/* state # mapped to offset of its name in arena */
+	unsigned long *hashes;			/* state # mapped to hash of its name */
+	unsigned long offsets_size;		/* size of offsets and hashes */
+	unsigned long *table;			/* state # + 1 for used slots, 0 for free slots */
+	unsigned long table_size;		/* size of table, a power of two */
+	unsigned long refs;			/* # of matrices using the names */
+};
 
 /**
 * The SparseMatrix structure for MAs.
@@ -57,8 +98,7 @@ struct SparseMatrix
 	unsigned long ms_n;			/* # of Markovian states */
 	unsigned long choices_n;	/* # of choices */
 	unsigned long non_zero_n;	/* # of transitions */
-	map<string,unsigned long> states;	/* state names mapped to # */
-	map<unsigned long,string> states_nr;	/* state # mapped to names */
+	StateNames *names;			/* state names, shared with discretised copies */
 	bool *initials;				/* initial states = true, otherwise false */
 	bool *goals;				/* goal states = true, otherwise false */
 	bool *isPS;				/* probabilistic state = true, otherwise false */
@@ -68,10 +108,22 @@ struct SparseMatrix
 	Real *rewards;			/* rewards for Markovian states and probabilistic transitions */
 	Real max_exit_rate;			/* max exit rate */
 	Real max_markovian_reward;      /* max Markovian reward  */
-	unsigned long *cols;			/* successors */
-	unsigned char *row_counts;		/* pointer to state */
-	unsigned char *rate_counts;		/* pointer to exit rates */
-	unsigned char *choice_counts;		/* pointer to distribution */
+	sparse_index *cols;			/* successors */
+	sparse_index *row_starts;		/* first choice of each state */
+	sparse_index *rate_starts;		/* first exit rate of each state */
+	sparse_index *choice_starts;		/* first transition of each choice */
+	Real *branching;			/* transition probabilities, rates divided by the exit rate (NULL if not prepared yet) */
+	Real *state_rates;			/* exit rate of each state, 0 for probabilistic states (NULL if not prepared yet) */
+	void *mapping;				/* compiled model the transitions are mapped from, otherwise NULL */
+	size_t mapping_size;			/* size of the mapping */
+
+	/* results of the graph analyses, kept for further queries on the same MA (NULL if not computed yet) */
+	bool *locks_strong;			/* see compute_locks_strong */
+	bool *locks_weak;			/* see compute_locks_weak */
+	SparseMatrixMEC *mecs;			/* see mEC_decomposition_previous_algorithm */
+	Predecessors *pred;			/* see SparseMatrix_predecessors */
+	SparseMatrix *discrete;			/* see discretize_model */
+	Real discrete_tau;			/* discretisation step of discrete */
 };
 
 /**
@@ -81,15 +133,102 @@ struct SparseMatrixMEC
 {
 	unsigned long n;				/* # of MECs */
 	
-	unsigned long *cols;				/* MEC states */
-	unsigned char *row_counts;		/* pointer to MEC states */
+	sparse_index *cols;				/* MEC states */
+	sparse_index *row_starts;		/* first state of each MEC */
+};
+
+/**
+* The choices leading to each state: the transitions of the MA in reverse,
+* for the backward graph searches.
+*/
+struct Predecessors
+{
+	sparse_index *starts;			/* first predecessor choice of each state */
+	sparse_index *choices;			/* choice of each transition leading to the state */
+	sparse_index *states;			/* state of each choice */
 };
 
-extern SparseMatrix* SparseMatrix_new(unsigned long, map<string,unsigned long>, map<unsigned long,string>);
+/**
+* Classes of a state partition. Markovian and probabilistic states are split
+* into goal, lock and other states, ordered such that all goal states, all
+* non-goal Markovian states and all non-goal probabilistic states each form
+* one contiguous range.
+*/
+enum StateClass
+{
+	CLASS_MS,				/* Markovian states */
+	CLASS_MS_LOCK,				/* Markovian lock states */
+	CLASS_MS_GOAL,				/* Markovian goal states */
+	CLASS_PS_GOAL,				/* probabilistic goal states */
+	CLASS_PS_LOCK,				/* probabilistic lock states */
+	CLASS_PS,				/* probabilistic states */
+	NUM_STATE_CLASSES
+};
+
+/**
+* The objectives of the value iteration engines which handle all of them.
+*/
+enum ValueObjective
+{
+	OBJECTIVE_REACHABILITY,		/* unbounded reachability probability */
+	OBJECTIVE_EXPECTED_TIME,	/* expected time to reach a goal state */
+	OBJECTIVE_EXPECTED_REWARD	/* expected reward until a goal state is reached */
+};
+
+struct StatePartition
+{
+	sparse_index *states;			/* states ordered by class, ascending within a class */
+	unsigned long starts[NUM_STATE_CLASSES + 1];	/* first position of each class in states */
+};
+
+/**
+* Order in which the fixed point over the probabilistic states is solved.
+* The states updated by a sweep, a suffix of a StatePartition, are split into
+* blocks. Each block only depends on itself and on earlier blocks. Acyclic
+* blocks are solved by one pass in the given order, cyclic blocks (strongly
+* connected components) by iterating until they are stable.
+*/
+struct SweepOrder
+{
+	unsigned long first;			/* first updated position in the partition, the states before are fixed */
+	unsigned long n;			/* # of blocks */
+	sparse_index *states;			/* updated states, successors first */
+	sparse_index *block_starts;		/* first state of each block */
+	bool *cyclic;				/* block has to be iterated */
+};
+
+extern SparseMatrix* SparseMatrix_new(unsigned long, StateNames *);
 extern SparseMatrixMEC* SparseMatrixMEC_new(unsigned long, unsigned long);
+extern SparseMatrixMEC* SparseMatrixMEC_copy(const SparseMatrixMEC *);
 extern SparseMatrix* SparseMatrixDiscrete_new(SparseMatrix* ma);
 
 extern void SparseMatrix_free(SparseMatrix *);
 extern void SparseMatrixMEC_free(SparseMatrixMEC *);
+extern void SparseMatrix_goals_changed(SparseMatrix *);
+extern bool SparseMatrix_fits(unsigned long, unsigned long, unsigned long);
+extern void SparseMatrix_prepare(SparseMatrix *);
+extern const Predecessors* SparseMatrix_predecessors(SparseMatrix *);
+
+extern StatePartition* StatePartition_new(const SparseMatrix *, const bool *);
+extern void StatePartition_free(StatePartition *);
+extern SweepOrder* SweepOrder_new(const SparseMatrix *, const StatePartition *, unsigned long);
+extern SweepOrder* SweepOrder_states_new(const SparseMatrix *, const sparse_index *, unsigned long);
+extern void SweepOrder_free(SweepOrder *);
+
+extern StateNames* StateNames_new(void);
+extern void StateNames_free(StateNames *);
+extern unsigned long state_names_insert(StateNames *, const char *, size_t, bool *);
+extern unsigned long state_names_find(const StateNames *, const char *, size_t);
+extern void state_names_renumber(StateNames *, const unsigned long *);
+
+/**
+* @param names the state names
+* @param state_nr a state
+* @return the name of state @a state_nr
+*/
+inline const char *state_name(const StateNames *names, unsigned long state_nr)
+{
+	return names->arena + names->offsets[state_nr];
+}
 
 #endif
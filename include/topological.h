@@ -0,0 +1,53 @@
+/**
+* IMCA is a analyzing tool for unbounded reachability probabilities, expected-
+* time, and long-run averages for Interactive Markov Chains and Markov Automata.
+* Copyright (C) RWTH Aachen, 2012
+*				UTwente, 2013
+* 	Author: Dennis Guck
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*
+* @file topological.cpp
+* @brief Value iteration over the strongly connected components of the MA
+*	in topological order
+* @author Dennis Guck
+* @version 1.0
+*
+*/
+
+#ifndef TOPOLOGICAL_H
+#define TOPOLOGICAL_H
+
+#include "sparse.h"
+
+#ifdef __SOPLEX__
+#include "soplex.h"
+#endif
+
+using namespace soplex;
+
+/**
+* Computes an objective by topological value iteration: the strongly
+* connected components of the MA are solved one after another, successors
+* first, each until it is stable on its own.
+*
+* @param ma the MA
+* @param objective the objective
+* @param max maximum/minimum
+* @return value of the initial states
+*/
+extern Real topological_value_iteration(SparseMatrix *ma, ValueObjective objective, bool max);
+
+#endif
@@ -0,0 +1,231 @@
+/**
+* IMCA is a analyzing tool for unbounded reachability probabilities, expected-
+* time, and long-run averages for Interactive Markov Chains and Markov Automata.
+* Copyright (C) RWTH Aachen, 2012
+*				UTwente, 2013
+* 	Author: Dennis Guck
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*
+*
+* Source description:
+*	Backward graph searches. Every search walks the predecessor choices of
+*	the MA from the states already found and keeps a counter per choice or
+*	per state, so each transition is looked at a constant number of times.
+*/
+
+#include "backward.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+
+using namespace std;
+
+void reach_some(SparseMatrix *ma, const bool *target, const bool *inside, const bool *choice_ok, bool *result)
+{
+	const Predecessors *pred = SparseMatrix_predecessors(ma);
+	vector<sparse_index> queue;
+
+	for (unsigned long state_nr = 0; state_nr < ma->n; state_nr++) {
+		result[state_nr] = target[state_nr];
+		if (target[state_nr])
+			queue.push_back(state_nr);
+	}
+	for (unsigned long q = 0; q < queue.size(); q++) {
+		unsigned long dst = queue[q];
+		for (unsigned long p = pred->starts[dst]; p < pred->starts[dst + 1]; p++) {
+			unsigned long choice_nr = pred->choices[p];
+			unsigned long state_nr = pred->states[choice_nr];
+			if (result[state_nr] || (inside != NULL && !inside[state_nr]) || (choice_ok != NULL && !choice_ok[choice_nr]))
+				continue;
+			result[state_nr] = true;
+			queue.push_back(state_nr);
+		}
+	}
+}
+
+void reach_all(SparseMatrix *ma, const bool *target, bool *result)
+{
+	const Predecessors *pred = SparseMatrix_predecessors(ma);
+	sparse_index *row_starts = ma->row_starts;
+	unsigned long n = ma->n;
+	/* # of choices of each state without a successor in result yet */
+	unsigned long *open = (unsigned long *) malloc((n > 0 ? n : 1) * sizeof(unsigned long));
+	bool *hit = (bool *) calloc(row_starts[n] > 0 ? row_starts[n] : 1, sizeof(bool));
+	vector<sparse_index> queue;
+
+	for (unsigned long state_nr = 0; state_nr < n; state_nr++) {
+		open[state_nr] = row_starts[state_nr + 1] - row_starts[state_nr];
+		result[state_nr] = target[state_nr];
+		if (target[state_nr])
+			queue.push_back(state_nr);
+	}
+	for (unsigned long q = 0; q < queue.size(); q++) {
+		unsigned long dst = queue[q];
+		for (unsigned long p = pred->starts[dst]; p < pred->starts[dst + 1]; p++) {
+			unsigned long choice_nr = pred->choices[p];
+			unsigned long state_nr = pred->states[choice_nr];
+			if (result[state_nr] || hit[choice_nr])
+				continue;
+			hit[choice_nr] = true;
+			if (--open[state_nr] == 0) {
+				result[state_nr] = true;
+				queue.push_back(state_nr);
+			}
+		}
+	}
+	free(open);
+	free(hit);
+}
+
+void reach_surely_some(SparseMatrix *ma, bool *result)
+{
+	sparse_index *row_starts = ma->row_starts;
+	sparse_index *choice_starts = ma->choice_starts;
+	sparse_index *cols = ma->cols;
+	unsigned long n = ma->n;
+	bool *inside = (bool *) malloc((n > 0 ? n : 1) * sizeof(bool));
+	bool *choice_ok = (bool *) malloc((row_starts[n] > 0 ? row_starts[n] : 1) * sizeof(bool));
+	bool changed = true;
+
+	for (unsigned long state_nr = 0; state_nr < n; state_nr++)
+		inside[state_nr] = true;
+	while (changed) {
+		for (unsigned long choice_nr = 0; choice_nr < row_starts[n]; choice_nr++) {
+			choice_ok[choice_nr] = true;
+			for (unsigned long i = choice_starts[choice_nr]; i < choice_starts[choice_nr + 1]; i++) {
+				if (!inside[cols[i]])
+					choice_ok[choice_nr] = false;
+			}
+		}
+		reach_some(ma, ma->goals, inside, choice_ok, result);
+		changed = memcmp(inside, result, n * sizeof(bool)) != 0;
+		memcpy(inside, result, n * sizeof(bool));
+	}
+	free(inside);
+	free(choice_ok);
+}
+
+void reach_surely_all(SparseMatrix *ma, const bool *positive, bool *result)
+{
+	unsigned long n = ma->n;
+	bool *zero = (bool *) calloc(n > 0 ? n : 1, sizeof(bool));
+	bool *not_goal = (bool *) calloc(n > 0 ? n : 1, sizeof(bool));
+
+	for (unsigned long state_nr = 0; state_nr < n; state_nr++) {
+		zero[state_nr] = !positive[state_nr];
+		not_goal[state_nr] = !ma->goals[state_nr];
+	}
+	reach_some(ma, zero, not_goal, NULL, result);
+	for (unsigned long state_nr = 0; state_nr < n; state_nr++)
+		result[state_nr] = !result[state_nr];
+	free(zero);
+	free(not_goal);
+}
+
+void close_backward(SparseMatrix *ma, const bool *fixed, bool every_choice, bool *set)
+{
+	const Predecessors *pred = SparseMatrix_predecessors(ma);
+	sparse_index *row_starts = ma->row_starts;
+	sparse_index *choice_starts = ma->choice_starts;
+	sparse_index *cols = ma->cols;
+	unsigned long n = ma->n;
+	unsigned long choices_n = row_starts[n];
+	/* # of transitions of each choice leading outside set */
+	unsigned long *leaving = (unsigned long *) malloc((choices_n > 0 ? choices_n : 1) * sizeof(unsigned long));
+	/* # of choices of each state leading outside set */
+	unsigned long *open = (unsigned long *) malloc((n > 0 ? n : 1) * sizeof(unsigned long));
+	vector<sparse_index> queue;
+
+	for (unsigned long state_nr = 0; state_nr < n; state_nr++) {
+		open[state_nr] = 0;
+		for (unsigned long choice_nr = row_starts[state_nr]; choice_nr < row_starts[state_nr + 1]; choice_nr++) {
+			leaving[choice_nr] = 0;
+			for (unsigned long i = choice_starts[choice_nr]; i < choice_starts[choice_nr + 1]; i++) {
+				if (!set[cols[i]])
+					leaving[choice_nr]++;
+			}
+			if (leaving[choice_nr] > 0)
+				open[state_nr]++;
+		}
+	}
+	for (unsigned long state_nr = 0; state_nr < n; state_nr++) {
+		unsigned long choices = row_starts[state_nr + 1] - row_starts[state_nr];
+		if (set[state_nr] || fixed[state_nr])
+			continue;
+		if (every_choice ? open[state_nr] == 0 : open[state_nr] < choices) {
+			set[state_nr] = true;
+			queue.push_back(state_nr);
+		}
+	}
+	for (unsigned long q = 0; q < queue.size(); q++) {
+		unsigned long dst = queue[q];
+		for (unsigned long p = pred->starts[dst]; p < pred->starts[dst + 1]; p++) {
+			unsigned long choice_nr = pred->choices[p];
+			unsigned long state_nr = pred->states[choice_nr];
+			if (--leaving[choice_nr] > 0 || set[state_nr] || fixed[state_nr])
+				continue;
+			if (!every_choice || --open[state_nr] == 0) {
+				set[state_nr] = true;
+				queue.push_back(state_nr);
+			}
+		}
+	}
+	free(leaving);
+	free(open);
+}
+
+void attractor(SparseMatrix *ma, const bool *bad_states, const bool *bad_transitions, bool *set)
+{
+	const Predecessors *pred = SparseMatrix_predecessors(ma);
+	sparse_index *row_starts = ma->row_starts;
+	unsigned long n = ma->n;
+	/* # of choices of each state, not bad, without a transition into set yet */
+	unsigned long *open = (unsigned long *) malloc((n > 0 ? n : 1) * sizeof(unsigned long));
+	bool *hit = (bool *) calloc(row_starts[n] > 0 ? row_starts[n] : 1, sizeof(bool));
+	vector<sparse_index> queue;
+
+	for (unsigned long state_nr = 0; state_nr < n; state_nr++) {
+		open[state_nr] = 0;
+		for (unsigned long choice_nr = row_starts[state_nr]; choice_nr < row_starts[state_nr + 1]; choice_nr++) {
+			if (!bad_transitions[choice_nr])
+				open[state_nr]++;
+		}
+		if (bad_states[state_nr])
+			continue;
+		if (set[state_nr] || open[state_nr] == 0) {
+			set[state_nr] = true;
+			queue.push_back(state_nr);
+		}
+	}
+	for (unsigned long q = 0; q < queue.size(); q++) {
+		unsigned long dst = queue[q];
+		for (unsigned long p = pred->starts[dst]; p < pred->starts[dst + 1]; p++) {
+			unsigned long choice_nr = pred->choices[p];
+			unsigned long state_nr = pred->states[choice_nr];
+			if (set[state_nr] || bad_states[state_nr] || bad_transitions[choice_nr] || hit[choice_nr])
+				continue;
+			hit[choice_nr] = true;
+			if (--open[state_nr] == 0) {
+				set[state_nr] = true;
+				queue.push_back(state_nr);
+			}
+		}
+	}
+	free(open);
+	free(hit);
+}
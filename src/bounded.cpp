@@ -28,8 +28,12 @@
 #include "read_file.h"
 #include "debug.h"
 #include "sccs.h"
+#include "backward.h"
 #include <math.h>
+#include <string.h>
+#include <time.h>
 #include <vector>
+#include <algorithm>
 
 /**
 * sets the error bound for given epsilon and tb
@@ -46,74 +50,111 @@ Real compute_error_bound(SparseMatrix* ma, Real epsilon, Real tb) {
 	return tau;
 }
 
+/**
+* writes the probabilities and rewards of the Markovian states of a discretised
+* MA, the only values which depend on the discretisation step
+*
+* @param discrete_ma the discretised MA
+* @param ma the MA
+* @param tau discretization factor
+*/
+static void discretize_markovian_states(SparseMatrix* discrete_ma, SparseMatrix* ma, Real tau) {
+	sparse_index *row_starts = ma->row_starts;
+	sparse_index *choice_starts = ma->choice_starts;
+	sparse_index *d_choice_starts = discrete_ma->choice_starts;
+	Real *non_zeros = discrete_ma->non_zeros;
+	Real *state_rates = ma->state_rates;
+
+	for (unsigned long state_nr = 0; state_nr < ma->n; state_nr++) {
+		if(ma->isPS[state_nr])
+			continue;
+		Real exit_rate = state_rates[state_nr];
+		// precision of Real could be to small (exp_estau)
+		Real exp_estau = exp(-(exit_rate * tau));
+		Real exp_estau_com = Real(1)-exp_estau;
+		for (unsigned long choice_nr = row_starts[state_nr]; choice_nr < row_starts[state_nr + 1]; choice_nr++) {
+			unsigned long i_start = choice_starts[choice_nr];
+			unsigned long i_end = choice_starts[choice_nr + 1];
+			unsigned long nz_index = d_choice_starts[choice_nr];
+			for (unsigned long i = i_start; i < i_end; i++) {
+				non_zeros[nz_index] = exp_estau_com*ma->branching[i];
+				if(state_nr==ma->cols[i])
+					non_zeros[nz_index] += exp_estau;
+				nz_index++;
+			}
+			// the added selfloop
+			if(nz_index < d_choice_starts[choice_nr + 1])
+				non_zeros[nz_index] = exp_estau;
+			// Reward of each step for Markovian state s is: Rew(s)/E(s)*(1-exp(-E(s)*tau))
+			if(ma->rewards != NULL)
+				discrete_ma->rewards[choice_nr] = exit_rate == 0.0 ? tau * ma->rewards[choice_nr] : ma->rewards[choice_nr] / exit_rate * exp_estau_com;
+		}
+	}
+}
+
 /**
 * discretizes the MA
 *
+* The discretised MA is kept with the MA for all phases, objectives and
+* further queries, as only the Markovian states depend on @a tau. The
+* successors and the probabilistic states are written once, a new @a tau
+* only rewrites the probabilities and rewards of the Markovian states.
+*
 * @param ma the MA
 * @param tau discretization factor
-* @return discretized MA
+* @return discretized MA, owned by @a ma
 */
 SparseMatrix* discretize_model(SparseMatrix* ma, Real tau) {
-	SparseMatrix* discrete_ma;
+	SparseMatrix_prepare(ma);
+	SparseMatrix* discrete_ma = ma->discrete;
+	if(discrete_ma != NULL) {
+		if(ma->discrete_tau != tau) {
+			discretize_markovian_states(discrete_ma, ma, tau);
+			ma->discrete_tau = tau;
+		}
+		return discrete_ma;
+	}
+
 	dbg_printf("memory alloc.\n");
 	discrete_ma=SparseMatrixDiscrete_new(ma);
 	
 	// transitions for MA
-	unsigned long *row_starts = (unsigned long *) ma->row_counts;
-	unsigned long *rate_starts = (unsigned long *) ma->rate_counts;
-	unsigned long *choice_starts = (unsigned long *) ma->choice_counts;
+	sparse_index *row_starts = ma->row_starts;
+	sparse_index *choice_starts = ma->choice_starts;
 	
 	// transition variables for discrete_ma
-	//unsigned long *d_choice_starts = (unsigned long *) discrete_ma->choice_counts;
-	//unsigned long *d_row_starts = (unsigned long *) discrete_ma->row_counts;
 	Real *non_zeros = discrete_ma->non_zeros;
-	unsigned long *cols = discrete_ma->cols;
+	sparse_index *cols = discrete_ma->cols;
 	unsigned long nz_index = 0;
-	//unsigned long choice_index = 0;
-	//unsigned long choice_size = 0;
 	
 	dbg_printf("discretization\n");
 	// add for each Markovian state a loop transition ==> new memory allocation for non_zero, choices and successors
 	for (unsigned long state_nr = 0; state_nr < ma->n; state_nr++) {
 		unsigned long state_start = row_starts[state_nr];
 		unsigned long state_end = row_starts[state_nr + 1];
-		unsigned long r_start = rate_starts[state_nr];
-		//unsigned long r_end = rate_starts[state_nr];
-		dbg_printf("check if Markovian\n");
 		// Look at Markovian states
 		if(!ma->isPS[state_nr])
 		{
 			for (unsigned long choice_nr = state_start; choice_nr < state_end; choice_nr++) {
-				// Add up all outgoing rates of the distribution
 				unsigned long i_start = choice_starts[choice_nr];
 				unsigned long i_end = choice_starts[choice_nr + 1];
-				Real exit_rate = ma->exit_rates[r_start];
-				//Real tmp=Real(1)-exp(-(exit_rate*tau));
-				// precision of Real could be to small (exp_estau)
-				Real estau = -(exit_rate * tau);	
-				Real exp_estau = exp(estau);
-				Real exp_estau_com = Real(1)-exp_estau;
 				bool loop=false;
 				for (unsigned long i = i_start; i < i_end; i++) {
-					Real prob = ma->non_zeros[i]/exit_rate;
-					non_zeros[nz_index] = exp_estau_com*prob;
 					cols[nz_index] = ma->cols[i];
-					if(state_nr==ma->cols[i]){
+					if(state_nr==ma->cols[i])
 						loop=true;
-						non_zeros[nz_index] += exp_estau;
-					}
 					nz_index++;
 				}
-				dbg_printf("add selfloop\n");
 				// add selfloop 
 				if(!loop) {
-					non_zeros[nz_index] = exp_estau;
 					cols[nz_index] = state_nr;
 					nz_index++;
 				}
 			}
 		}else {
 			for (unsigned long choice_nr = state_start; choice_nr < state_end; choice_nr++) {
+				if(ma->rewards != NULL)
+					discrete_ma->rewards[choice_nr] = ma->rewards[choice_nr];
 				// Add up all outgoing rates of the distribution
 				unsigned long i_start = choice_starts[choice_nr];
 				unsigned long i_end = choice_starts[choice_nr + 1];
@@ -125,6 +166,9 @@ SparseMatrix* discretize_model(SparseMatrix* ma, Real tau) {
 			}
 		}
 	}
+	discretize_markovian_states(discrete_ma, ma, tau);
+	ma->discrete = discrete_ma;
+	ma->discrete_tau = tau;
 	return discrete_ma;
 }
 
@@ -134,37 +178,42 @@ SparseMatrix* discretize_model(SparseMatrix* ma, Real tau) {
 * @param ma the MA
 * @param v Markovian vector
 * @param u result vector
+* @param part state partition of the MA
 * @param is_MA_made_absorbing: if true then all goal states are made absorbing, otherwise not
 */
-void compute_markovian_vector(SparseMatrix* ma, vector<Real>& v, const vector<Real> &u, bool is_MA_made_absorbing){
-	unsigned long *row_starts = (unsigned long *) ma->row_counts;
-	unsigned long *choice_starts = (unsigned long *) ma->choice_counts;
-	unsigned long *cols = ma->cols;
+void compute_markovian_vector(SparseMatrix* ma, vector<Real>& v, const vector<Real> &u, const StatePartition *part, bool is_MA_made_absorbing){
+	sparse_index *row_starts = ma->row_starts;
+	sparse_index *choice_starts = ma->choice_starts;
+	sparse_index *cols = ma->cols;
 	Real* non_zeros = ma->non_zeros;
-	bool *goals = ma->goals;
-	for (unsigned long state_nr = 0; state_nr < ma->n; state_nr++) {
+	const sparse_index *states = part->states;
+	// goal states are only computed if the MA is not made absorbing
+	unsigned long ms_end = is_MA_made_absorbing ? part->starts[CLASS_MS_GOAL] : part->starts[CLASS_PS_GOAL];
+	unsigned long ps_start = is_MA_made_absorbing ? part->starts[CLASS_PS_LOCK] : part->starts[CLASS_PS_GOAL];
+	// Look at Markovian states
+	#pragma omp parallel for schedule(static) if(ms_end - part->starts[CLASS_MS] >= PARALLEL_MIN_STATES)
+	for (unsigned long k = part->starts[CLASS_MS]; k < ms_end; k++) {
+		unsigned long state_nr = states[k];
 		unsigned long state_start = row_starts[state_nr];
 		unsigned long state_end = row_starts[state_nr + 1];
-		// Look at Markovian states
-		if(goals[state_nr] && is_MA_made_absorbing){
-			v[state_nr]=1;
-		}else{
-			if(!ma->isPS[state_nr])
-			{
-				for (unsigned long choice_nr = state_start; choice_nr < state_end; choice_nr++) {
-					// Add up all outgoing rates of the distribution
-					unsigned long i_start = choice_starts[choice_nr];
-					unsigned long i_end = choice_starts[choice_nr + 1];
-					v[state_nr]=0;
-					for (unsigned long i = i_start; i < i_end; i++) {
-						v[state_nr] += non_zeros[i] * u[cols[i]];
-					}
-				}
-			}else {
-					v[state_nr] = u[state_nr];
+		for (unsigned long choice_nr = state_start; choice_nr < state_end; choice_nr++) {
+			// Add up all outgoing rates of the distribution
+			unsigned long i_start = choice_starts[choice_nr];
+			unsigned long i_end = choice_starts[choice_nr + 1];
+			v[state_nr]=0;
+			for (unsigned long i = i_start; i < i_end; i++) {
+				v[state_nr] += non_zeros[i] * u[cols[i]];
 			}
 		}
 	}
+	// absorbing goal states
+	for (unsigned long k = ms_end; k < ps_start; k++) {
+		v[states[k]]=1;
+	}
+	// probabilistic states
+	for (unsigned long k = ps_start; k < part->starts[NUM_STATE_CLASSES]; k++) {
+		v[states[k]] = u[states[k]];
+	}
 }
 
 /**
@@ -177,66 +226,52 @@ void compute_markovian_vector(SparseMatrix* ma, vector<Real>& v, const vector<Re
 * @param locks Lock set for states never reach a goal state
 * @param reach reachability for interactive states
 */
-void compute_interactive_vector(SparseMatrix* ma, vector<Real> v, vector<Real>& u, bool max, bool* locks, vector< vector<unsigned long> > reach) {
+void compute_interactive_vector(SparseMatrix* ma, const vector<Real>& v, vector<Real>& u, bool max, const bool* locks, const InteractiveClosure *reach) {
 	bool *goals = ma->goals;
-	vector<unsigned long>::const_iterator r;
+	const sparse_index *rows = reach->rows;
+	const sparse_index *row_starts = reach->row_starts;
+	const sparse_index *cols = reach->cols;
+	#pragma omp parallel for schedule(static) if(ma->n >= PARALLEL_MIN_STATES)
 	for (unsigned long state_nr = 0; state_nr < ma->n; state_nr++) {
+		unsigned long r_start = row_starts[rows[state_nr]];
+		unsigned long r_end = row_starts[rows[state_nr] + 1];
 		if(locks[state_nr]){
 			u[state_nr] = 0;
 		}else if (goals[state_nr]){
 			u[state_nr] = 1;
 		}else{
 			if(max) {
-				u[state_nr]=0;
-				for(r=reach[state_nr].begin(); r<reach[state_nr].end(); r++) {
-					if(u[state_nr] < v[(*r)]){
-						u[state_nr] = v[(*r)];
+				Real best=0;
+				for(unsigned long r = r_start; r < r_end; r++) {
+					if(best < v[cols[r]]){
+						best = v[cols[r]];
 					}
 				}
+				u[state_nr]=best;
 			}else {
-				u[state_nr]=1;
-				for(r=reach[state_nr].begin(); r<reach[state_nr].end(); r++) {
-					if(u[state_nr] > v[(*r)]){
-						u[state_nr] = v[(*r)];
+				Real best=1;
+				for(unsigned long r = r_start; r < r_end; r++) {
+					if(best > v[cols[r]]){
+						best = v[cols[r]];
 					}
 				}
+				u[state_nr]=best;
 			}
 		}
 	}
 }
 
 /**
-* computes reachability for interactive states
-*
-* @param ma the MA
-* @param state_nr the actual state
-* @param visited states visited before
+* Appends the states of closure @a row to the closure @a comp, which is the
+* last one in @a cols. States already marked for @a comp are skipped.
 */
-void interactiveReachability(SparseMatrix* ma, const unsigned long state_nr, vector<unsigned long>& visited) {
-	unsigned long dst;
-	visited[state_nr]=1;
-	
-	unsigned long *row_starts = (unsigned long *) ma->row_counts;
-	unsigned long *choice_starts = (unsigned long *) ma->choice_counts;
-	unsigned long *cols = ma->cols;
-	bool *goals = ma->goals;
-	unsigned long state_start = row_starts[state_nr];
-	unsigned long state_end = row_starts[state_nr + 1];
-	
-	if(!goals[state_nr]){
-		if(ma->isPS[state_nr])
-		{
-			for (unsigned long choice_nr = state_start; choice_nr < state_end; choice_nr++) {
-				// Add up all outgoing rates of the distribution
-				unsigned long i_start = choice_starts[choice_nr];
-				unsigned long i_end = choice_starts[choice_nr + 1];
-				for (unsigned long i = i_start; i < i_end; i++) {
-					dst=cols[i];
-					if(visited[dst]==0) {
-						interactiveReachability(ma,dst,visited);
-					}
-				}
-			}
+static void add_closure(vector<sparse_index>& cols, const vector<sparse_index>& row_starts, unsigned long row,
+		vector<unsigned long>& mark, unsigned long comp) {
+	for (unsigned long r = row_starts[row]; r < row_starts[row + 1]; r++) {
+		sparse_index dst = cols[r];
+		if(mark[dst] != comp) {
+			mark[dst] = comp;
+			cols.push_back(dst);
 		}
 	}
 }
@@ -244,159 +279,452 @@ void interactiveReachability(SparseMatrix* ma, const unsigned long state_nr, vec
 /**
 * computes reachability for interactive states
 *
+* Only the Markovian and goal states are stored, which are the states an
+* interactive state reaches without delay. Interactive transitions leave the
+* non-goal probabilistic states only, their strongly connected components
+* are the blocks of a SweepOrder of these states. All states of a component
+* reach the same states and share one closure. The components are ordered
+* successors first, so the closures of the successors are known when a
+* component is reached.
+*
 * @param ma the MA
-* @param state_nr the actual state
+* @return for each state the states reachable by interactive transitions, computed once and shared by all steps
 */
-vector<unsigned long> interactiveReachability(SparseMatrix* ma, const unsigned long state) {
-	vector<unsigned long> visited(ma->n);
-	vector<unsigned long> goals;
-	unsigned long x;
-	for(x=0; x < ma->n; x++) {
-		visited[x]=0;
-	}
-	interactiveReachability(ma,state, visited);
-	for(x=0; x < ma->n; x++) {
-		if(visited[x]==1) {
-		goals.push_back(x);
+InteractiveClosure* interactiveReachability(SparseMatrix* ma) {
+	const unsigned long statecount = ma->n;
+	const unsigned long undefined = (unsigned long) -1;
+	sparse_index *ma_row_starts = ma->row_starts;
+	sparse_index *choice_starts = ma->choice_starts;
+	sparse_index *ma_cols = ma->cols;
+	bool *goals = ma->goals;
+	bool *isPS = ma->isPS;
+
+	vector<unsigned long> rows(statecount, undefined);	// closure of each state
+	vector<sparse_index> row_starts;
+	vector<sparse_index> cols;
+	vector<unsigned long> mark(statecount, undefined);	// last closure each state was added to
+	vector<unsigned long> row_mark(statecount, undefined);	// last closure each closure was added to
+	vector<sparse_index> interactive;
+
+	// Markovian and goal states reach only themselves
+	for (unsigned long s_idx = 0; s_idx < statecount; s_idx++) {
+		if(!isPS[s_idx] || goals[s_idx]) {
+			rows[s_idx] = row_starts.size();
+			row_starts.push_back(cols.size());
+			cols.push_back(s_idx);
+		} else {
+			interactive.push_back(s_idx);
 		}
 	}
-	return goals;
+
+	SweepOrder *order = SweepOrder_states_new(ma, interactive.empty() ? NULL : &interactive[0], interactive.size());
+	for (unsigned long b = 0; b < order->n; b++) {
+		// a cyclic block is one component, an acyclic block a single state per component
+		unsigned long b_end = order->block_starts[b + 1];
+		for (unsigned long k = order->block_starts[b]; k < b_end; ) {
+			unsigned long comp_end = order->cyclic[b] ? b_end : k + 1;
+			unsigned long comp = row_starts.size();
+			unsigned long comp_start = cols.size();
+			row_starts.push_back(comp_start);
+			for (unsigned long m = k; m < comp_end; m++)
+				rows[order->states[m]] = comp;
+			// collect the closures of the successors
+			row_mark[comp] = comp;
+			for (unsigned long m = k; m < comp_end; m++) {
+				unsigned long member = order->states[m];
+				for (unsigned long t = choice_starts[ma_row_starts[member]]; t < choice_starts[ma_row_starts[member + 1]]; t++) {
+					unsigned long dst_row = rows[ma_cols[t]];
+					if(row_mark[dst_row] != comp) {
+						row_mark[dst_row] = comp;
+						add_closure(cols, row_starts, dst_row, mark, comp);
+					}
+				}
+			}
+			sort(cols.begin() + comp_start, cols.end());
+			k = comp_end;
+		}
+	}
+	SweepOrder_free(order);
+	row_starts.push_back(cols.size());
+
+	InteractiveClosure *reach = new InteractiveClosure;
+	reach->n = row_starts.size() - 1;
+	reach->rows = (sparse_index *) malloc((statecount > 0 ? statecount : 1) * sizeof(sparse_index));
+	reach->row_starts = (sparse_index *) malloc(row_starts.size() * sizeof(sparse_index));
+	reach->cols = (sparse_index *) malloc((cols.size() > 0 ? cols.size() : 1) * sizeof(sparse_index));
+	for (unsigned long s_idx = 0; s_idx < statecount; s_idx++)
+		reach->rows[s_idx] = rows[s_idx];
+	memcpy(reach->row_starts, &row_starts[0], row_starts.size() * sizeof(sparse_index));
+	if(!cols.empty())
+		memcpy(reach->cols, &cols[0], cols.size() * sizeof(sparse_index));
+
+	return reach;
 }
 
 /**
-* computes reachability for interactive states
+* Frees the reachability of interactive states.
 *
-* @param ma the MA
+* @param reach the reachability
 */
-vector< vector<unsigned long> > interactiveReachability(SparseMatrix* ma) {
-	vector< vector<unsigned long> > r;
-	vector<unsigned long> reachSucc;
-	unsigned long s_idx;
-	unsigned long statecount = ma->n;
-	
-	for (s_idx = 0; s_idx < statecount; s_idx++) {
-		reachSucc.clear();
-		reachSucc=interactiveReachability(ma,s_idx);
-		r.push_back(reachSucc);
-	}
-	
-	return r;
+void InteractiveClosure_free(InteractiveClosure *reach) {
+	if(reach == NULL)
+		return;
+	free(reach->rows);
+	free(reach->row_starts);
+	free(reach->cols);
+	delete reach;
 }
 
 /**
 * computes one step for probabilistic states
 *
 * @param ma the MA
-* @param v Markovian vector (we use it as temporary variable for u vector elements as well, so its value after calling of the function is not valid)
+* @param v Markovian vector
 * @param u result vector
+* @param part state partition of the MA
+* @param order order of the interactive states
 * @param max maximum/minimum
-* @param is_MA_made_absorbing: if true then all goal states are made absorbing, otherwise not
 */
-void compute_probabilistic_vector(SparseMatrix* ma, vector<Real>& v, vector<Real>& u, bool max, bool is_MA_made_absorbing){
+void compute_probabilistic_vector(SparseMatrix* ma, vector<Real>& v, vector<Real>& u, const StatePartition *part, const SweepOrder *order, bool max){
 
 	const Real precision = 1e-7;
-	unsigned long statecount = ma-> n;
-	unsigned long *row_starts = (unsigned long *) ma->row_counts;
-	unsigned long *choice_starts = (unsigned long *) ma->choice_counts;
-	unsigned long *cols = ma->cols;
+	sparse_index *row_starts = ma->row_starts;
+	sparse_index *choice_starts = ma->choice_starts;
+	sparse_index *cols = ma->cols;
 	Real* non_zeros = ma->non_zeros;
+	const sparse_index *states = part->states;
+	const sparse_index *order_states = order->states;
 
-	// Initialization
-	for (unsigned long s_idx = 0; s_idx < statecount; s_idx++) {
-		if ( ma -> isPS[s_idx] && (!is_MA_made_absorbing || (is_MA_made_absorbing && !ma -> goals[s_idx])) )
-			v[s_idx] = 0.0;
-		else
-			u[s_idx] = v[s_idx];
-
+	// Initialization: the states before the interactive ones keep their values
+	for (unsigned long k = 0; k < order->first; k++) {
+		u[states[k]] = v[states[k]];
 	}
-	// main loop
-	bool done = false;
-	// done will set to true inside the while loop when we reach fixed point
-	while (! done) {
-		done = true;
-
-
-		// do one step of fixed point, it is applied on interactive states
-		for (unsigned long s_idx = 0; s_idx < statecount; s_idx++) {
-			unsigned long state_start = row_starts[s_idx];
-			unsigned long state_end = row_starts[s_idx + 1];
-			if ( ma -> isPS[s_idx] && (!is_MA_made_absorbing || (is_MA_made_absorbing && !ma -> goals[s_idx])) ){  // do processing only if the state is interactive
-				if (max)
-					u[s_idx] = 0.0;
-				else
-					u[s_idx] = 1.0;
+	// solve one block after another, the successors of a block are solved before it
+	for (unsigned long b = 0; b < order->n; b++) {
+		unsigned long b_start = order->block_starts[b];
+		unsigned long b_end = order->block_starts[b + 1];
+		bool cyclic = order->cyclic[b];
+		if (cyclic) {
+			for (unsigned long k = b_start; k < b_end; k++) {
+				u[order_states[k]] = 0.0;
+			}
+		}
+		// an acyclic block is done after one pass, a cyclic one when it is close enough to the fixed point
+		bool done;
+		do {
+			done = true;
+			for (unsigned long k = b_start; k < b_end; k++) {
+				unsigned long s_idx = order_states[k];
+				unsigned long state_start = row_starts[s_idx];
+				unsigned long state_end = row_starts[s_idx + 1];
+				Real best = max ? 0.0 : 1.0;
 
-				// find the max/min prob. to reach Markovians and store it to tmp
+				// find the max/min prob. to reach Markovians and store it to best
 				for (unsigned long choice_nr = state_start; choice_nr < state_end; choice_nr++) {
 					Real tmp = 0;
 					// Add up all outgoing rates of the distribution
 					unsigned long i_start = choice_starts[choice_nr];
 					unsigned long i_end = choice_starts[choice_nr + 1];
 					for (unsigned long i = i_start; i < i_end; i++) {
-						tmp += non_zeros[i] * v[cols[i]];
+						tmp += non_zeros[i] * u[cols[i]];
 					}
 					if( max ) {
-						if(tmp > u[s_idx] )
-							u[s_idx] = tmp;
+						if(tmp > best )
+							best = tmp;
 					}
 					else {
-						if(tmp < u[s_idx] )
-							u[s_idx] = tmp;
+						if(tmp < best )
+							best = tmp;
 					}
 				}
-				if( fabs(u[s_idx] - v[s_idx]) >= precision )
+				if( cyclic && fabs(best - u[s_idx]) >= precision )
 					done = false;
+				u[s_idx] = best;
+			}
+		} while (! done);
+	}
+}
 
+/**
+* finds the max/min probability over the initial states
+*
+* @param ma the MA
+* @param u result vector, @a width values per state
+* @param max maximum/minimum
+* @param width # of objectives in @a u
+* @param slot objective to take from @a u
+* @return probability for the initial states
+*/
+static Real initial_probability(SparseMatrix* ma, const vector<Real>& u, bool max, unsigned long width, unsigned long slot) {
+	Real prob;
+	if(max)
+		prob=0;
+	else
+		prob=1;
+	bool *initials = ma->initials;
+	for (unsigned long state_nr = 0; state_nr < ma->n; state_nr++) {
+		if(initials[state_nr]){
+			Real value = u[width*state_nr + slot];
+			if(max){
+				if(prob<value)
+					prob=value;
+			}else{
+				if(prob>value)
+					prob=value;
 			}
 		}
+	}
+	return prob;
+}
 
-		// write back u to v, only for interactive elements
-		for (unsigned long s_idx = 0; s_idx < statecount; s_idx++) {
-			if ( ma -> isPS[s_idx] && (!is_MA_made_absorbing || (is_MA_made_absorbing && !ma -> goals[s_idx])) ){
-				v[s_idx] = u[s_idx];
+/**
+* computes one step for Markovian states for the maximum and the minimum at
+* once, so both share one pass over the transitions
+*
+* @param ma the MA
+* @param v Markovian vector, the maximum and the minimum of each state next to each other
+* @param u result vector, likewise
+* @param part state partition of the MA
+* @param is_MA_made_absorbing: if true then all goal states are made absorbing, otherwise not
+*/
+static void compute_markovian_vector_pair(SparseMatrix* ma, vector<Real>& v, const vector<Real> &u, const StatePartition *part, bool is_MA_made_absorbing){
+	sparse_index *row_starts = ma->row_starts;
+	sparse_index *choice_starts = ma->choice_starts;
+	sparse_index *cols = ma->cols;
+	Real* non_zeros = ma->non_zeros;
+	const sparse_index *states = part->states;
+	// goal states are only computed if the MA is not made absorbing
+	unsigned long ms_end = is_MA_made_absorbing ? part->starts[CLASS_MS_GOAL] : part->starts[CLASS_PS_GOAL];
+	unsigned long ps_start = is_MA_made_absorbing ? part->starts[CLASS_PS_LOCK] : part->starts[CLASS_PS_GOAL];
+	// Look at Markovian states
+	#pragma omp parallel for schedule(static) if(ms_end - part->starts[CLASS_MS] >= PARALLEL_MIN_STATES)
+	for (unsigned long k = part->starts[CLASS_MS]; k < ms_end; k++) {
+		unsigned long state_nr = states[k];
+		for (unsigned long choice_nr = row_starts[state_nr]; choice_nr < row_starts[state_nr + 1]; choice_nr++) {
+			Real v_max = 0;
+			Real v_min = 0;
+			for (unsigned long i = choice_starts[choice_nr]; i < choice_starts[choice_nr + 1]; i++) {
+				v_max += non_zeros[i] * u[2*cols[i]];
+				v_min += non_zeros[i] * u[2*cols[i] + 1];
 			}
+			v[2*state_nr] = v_max;
+			v[2*state_nr + 1] = v_min;
 		}
+	}
+	// absorbing goal states
+	for (unsigned long k = ms_end; k < ps_start; k++) {
+		v[2*states[k]] = 1;
+		v[2*states[k] + 1] = 1;
+	}
+	// probabilistic states
+	for (unsigned long k = ps_start; k < part->starts[NUM_STATE_CLASSES]; k++) {
+		v[2*states[k]] = u[2*states[k]];
+		v[2*states[k] + 1] = u[2*states[k] + 1];
+	}
+}
 
-
+/**
+* computes one step for Interactive states for the maximum and the minimum
+*
+* @param ma the MA
+* @param v Markovian vector, the maximum and the minimum of each state next to each other
+* @param u result vector, likewise
+* @param max_locks Lock set of the maximum
+* @param min_locks Lock set of the minimum
+* @param reach reachability for interactive states
+*/
+static void compute_interactive_vector_pair(SparseMatrix* ma, const vector<Real>& v, vector<Real>& u, const bool* max_locks, const bool* min_locks, const InteractiveClosure *reach) {
+	bool *goals = ma->goals;
+	const sparse_index *rows = reach->rows;
+	const sparse_index *row_starts = reach->row_starts;
+	const sparse_index *cols = reach->cols;
+	#pragma omp parallel for schedule(static) if(ma->n >= PARALLEL_MIN_STATES)
+	for (unsigned long state_nr = 0; state_nr < ma->n; state_nr++) {
+		unsigned long r_start = row_starts[rows[state_nr]];
+		unsigned long r_end = row_starts[rows[state_nr] + 1];
+		Real best_max = 0;
+		Real best_min = 1;
+		for(unsigned long r = r_start; r < r_end; r++) {
+			if(best_max < v[2*cols[r]])
+				best_max = v[2*cols[r]];
+			if(best_min > v[2*cols[r] + 1])
+				best_min = v[2*cols[r] + 1];
+		}
+		u[2*state_nr] = max_locks[state_nr] ? 0 : (goals[state_nr] ? 1 : best_max);
+		u[2*state_nr + 1] = min_locks[state_nr] ? 0 : (goals[state_nr] ? 1 : best_min);
 	}
+}
+
+/**
+* computes one step for probabilistic states for the maximum and the minimum
+*
+* A cyclic block is iterated until both are stable, but each one is only
+* updated until it is stable itself, like in compute_probabilistic_vector.
+*
+* @param ma the MA
+* @param v Markovian vector, the maximum and the minimum of each state next to each other
+* @param u result vector, likewise
+* @param part state partition of the MA
+* @param order order of the interactive states
+*/
+static void compute_probabilistic_vector_pair(SparseMatrix* ma, vector<Real>& v, vector<Real>& u, const StatePartition *part, const SweepOrder *order){
 
+	const Real precision = 1e-7;
+	sparse_index *row_starts = ma->row_starts;
+	sparse_index *choice_starts = ma->choice_starts;
+	sparse_index *cols = ma->cols;
+	Real* non_zeros = ma->non_zeros;
+	const sparse_index *states = part->states;
+	const sparse_index *order_states = order->states;
 
+	// Initialization: the states before the interactive ones keep their values
+	for (unsigned long k = 0; k < order->first; k++) {
+		u[2*states[k]] = v[2*states[k]];
+		u[2*states[k] + 1] = v[2*states[k] + 1];
+	}
+	// solve one block after another, the successors of a block are solved before it
+	for (unsigned long b = 0; b < order->n; b++) {
+		unsigned long b_start = order->block_starts[b];
+		unsigned long b_end = order->block_starts[b + 1];
+		bool cyclic = order->cyclic[b];
+		if (cyclic) {
+			for (unsigned long k = b_start; k < b_end; k++) {
+				u[2*order_states[k]] = 0.0;
+				u[2*order_states[k] + 1] = 0.0;
+			}
+		}
+		// an acyclic block is done after one pass, a cyclic one when it is close enough to the fixed point
+		bool max_done = false;
+		bool min_done = false;
+		do {
+			bool max_stable = true;
+			bool min_stable = true;
+			for (unsigned long k = b_start; k < b_end; k++) {
+				unsigned long s_idx = order_states[k];
+				unsigned long state_start = row_starts[s_idx];
+				unsigned long state_end = row_starts[s_idx + 1];
+				Real best_max = 0.0;
+				Real best_min = 1.0;
 
+				for (unsigned long choice_nr = state_start; choice_nr < state_end; choice_nr++) {
+					Real tmp_max = 0;
+					Real tmp_min = 0;
+					for (unsigned long i = choice_starts[choice_nr]; i < choice_starts[choice_nr + 1]; i++) {
+						tmp_max += non_zeros[i] * u[2*cols[i]];
+						tmp_min += non_zeros[i] * u[2*cols[i] + 1];
+					}
+					if(tmp_max > best_max)
+						best_max = tmp_max;
+					if(tmp_min < best_min)
+						best_min = tmp_min;
+				}
+				if(!max_done) {
+					if( cyclic && fabs(best_max - u[2*s_idx]) >= precision )
+						max_stable = false;
+					u[2*s_idx] = best_max;
+				}
+				if(!min_done) {
+					if( cyclic && fabs(best_min - u[2*s_idx + 1]) >= precision )
+						min_stable = false;
+					u[2*s_idx + 1] = best_min;
+				}
+			}
+			max_done = max_done || max_stable;
+			min_done = min_done || min_stable;
+		} while (!max_done || !min_done);
+	}
 }
 
 /**
-* computes time-bounded reachability
+* computes one step of the time-bounded value iteration for one objective,
+* or for the maximum and the minimum at once
+*
+* @param ma the discretised MA
+* @param v Markovian vector
+* @param u result vector
+* @param part state partition of the MA
+* @param order order of the interactive states
+* @param is_MA_made_absorbing: if true then all goal states are made absorbing, otherwise not
+* @param max maximum/minimum, if there is one objective
+* @param both the vectors hold the maximum and the minimum of each state
+* @param locks Lock set of the (first) objective, for IMCs
+* @param min_locks Lock set of the minimum if there are both, for IMCs
+* @param reach reachability for interactive states if the MA is an IMC, otherwise NULL
+*/
+static void compute_time_bounded_step(SparseMatrix* ma, vector<Real>& v, vector<Real>& u, const StatePartition *part, const SweepOrder *order,
+		bool is_MA_made_absorbing, bool max, bool both, const bool *locks, const bool *min_locks, const InteractiveClosure *reach) {
+	if(both) {
+		compute_markovian_vector_pair(ma,v,u,part,is_MA_made_absorbing);
+		if(reach != NULL)
+			compute_interactive_vector_pair(ma,v,u,locks,min_locks,reach);
+		else
+			compute_probabilistic_vector_pair(ma,v,u,part,order);
+		return;
+	}
+	// compute v for Markovian states
+	compute_markovian_vector(ma,v,u,part,is_MA_made_absorbing);
+	// compute u for Probabilistic states
+	if(reach != NULL){
+		// if MA is in fact an IMC we can simplify the computation
+		compute_interactive_vector(ma,v,u,max,locks,reach);
+	}else {
+		compute_probabilistic_vector(ma,v,u,part,order,max);
+	}
+}
+
+/**
+* computes time-bounded reachability for one objective, or for the maximum
+* and the minimum at once
 *
 * @param ma the MA
-* @param max maximum/minimum
+* @param max maximum/minimum, if there is one objective
+* @param both compute the maximum and the minimum
 * @param epsilon the given error
 * @param tb the given time bound
 * @param is_imc indicates if MA is an IMC
+* @param min_prob the minimal probability if there are both
+* @param sink receives the interval output and the final values, NULL to print the interval output
+* @return probability for the initial states, the maximal one if there are both
 */
-Real compute_time_bounded_reachability(SparseMatrix* ma, bool max, Real epsilon, Real ta, Real tb, bool is_imc, Real interval,Real interval_start) {
+static Real time_bounded_reachability(SparseMatrix* ma, bool max, bool both, Real epsilon, Real ta, Real tb, bool is_imc, Real interval,Real interval_start, Real *min_prob, ResultSink *sink) {
 
 	// Check whether the given time interval is zero
 	if( ta > tb ) {
 		printf("WARNING: The given interval is empty (upper bound < lower bound.) The reachability probability is 0.\n");
+		if(both)
+			*min_prob = 0.0;
 		return 0.0;
 	}
 
 	unsigned long num_states = ma->n;
-	vector<Real> v(num_states,0); // Markovian vector
-	vector<Real> u(num_states,0); // Probabilistic vector
+	// with both objectives the maximum and the minimum of a state are stored next to each other
+	unsigned long width = both ? 2 : 1;
+	vector<Real> v(width*num_states,0); // Markovian vector
+	vector<Real> u(width*num_states,0); // Probabilistic vector
 	// initialize goal states
 	bool *goals = ma->goals;
 	for (unsigned long state_nr = 0; state_nr < num_states; state_nr++) {
 		if(goals[state_nr]){
-			v[state_nr]=1;
+			for (unsigned long slot = 0; slot < width; slot++)
+				v[width*state_nr + slot]=1;
 		}
 	}
+	// Markovian, probabilistic and goal states as contiguous index ranges
+	StatePartition *part = StatePartition_new(ma, NULL);
+	// order of the interactive states, with goal states made absorbing and without
+	SweepOrder *order = SweepOrder_new(ma, part, part->starts[CLASS_PS_LOCK]);
+	SweepOrder *order_shift = SweepOrder_new(ma, part, part->starts[CLASS_PS_GOAL]);
 	// in case MA is an IMC: precomputation of paths for interactive states
-	vector< vector<unsigned long> > reach;
-	bool *locks;
+	InteractiveClosure *reach = NULL;
+	bool *locks = NULL;
+	bool *min_locks = NULL;
 	if(is_imc) {
 		cout << "precomputation" << endl;
-		if(max){
+		if(both){
+			locks=compute_locks_strong(ma);
+			min_locks=compute_locks_weak(ma);
+			reach = interactiveReachability(ma);
+		}else if(max){
 			locks=compute_locks_strong(ma);
 			//{s' in S | s ~>i* s'}
 			reach = interactiveReachability(ma);
@@ -438,15 +766,8 @@ Real compute_time_bounded_reachability(SparseMatrix* ma, bool max, Real epsilon,
 		cout << "iterations: " << (unsigned long) ceil((tb - ta) / tau) << endl;
 		
 		for(unsigned long i=0; i < steps; i++){
-			// compute v for Markovian states: from b dwon to a, we make discrete model absorbing
-			compute_markovian_vector(discrete_ma,v,u, true);
-			// compute u for Probabilistic states
-			if(is_imc){
-				// if MA is in fact an IMC we can simplify the computation (slower than the PA computation TODO: find bug)
-				compute_interactive_vector(discrete_ma,v,u,max,locks,reach);
-			}else {
-				compute_probabilistic_vector(discrete_ma,v,u,max, true);
-			}
+			// from b dwon to a, we make discrete model absorbing
+			compute_time_bounded_step(discrete_ma,v,u,part,order, true,max,both,locks,min_locks,reach);
 			
 			/*
 			if(counter==interval_step) {
@@ -458,7 +779,7 @@ Real compute_time_bounded_reachability(SparseMatrix* ma, bool max, Real epsilon,
 					prob=1;
 				bool *initials = ma->initials;
 				for (unsigned long state_nr = 0; state_nr < num_states; state_nr++) {
-					//cout << (ma->states_nr.find(state_nr)->second).c_str() << ": " << u[state_nr] << endl;
+					//cout << state_name(ma->names, state_nr) << ": " << u[state_nr] << endl;
 					if(initials[state_nr]){
 					if(max){
 						if(prob<u[state_nr])
@@ -479,8 +800,6 @@ Real compute_time_bounded_reachability(SparseMatrix* ma, bool max, Real epsilon,
 			*/
 			
 		}
-		// free memory
-		SparseMatrix_free(discrete_ma);
 
 		steps = (unsigned long) ceil( (ta + current_tau) / tau); // calculating the number of steps for interval [0,a]
 		current_tau = (ta + current_tau) / steps;                // recalculate tau based on the number of steps
@@ -495,15 +814,8 @@ Real compute_time_bounded_reachability(SparseMatrix* ma, bool max, Real epsilon,
 		cout << "iterations: " << (unsigned long) ceil( (ta + current_tau) / tau) << endl;
 
 		for(unsigned long i=0; i < steps; ++i){
-			// compute v for Markovian states: shift up to a, we don't make discrete model absorbing
-			compute_markovian_vector(discrete_ma,v,u, false);
-			// compute u for Probabilistic states
-			if(is_imc){
-				// if MA is in fact an IMC we can simplify the computation
-				compute_interactive_vector(discrete_ma,v,u,max,locks,reach);
-			}else {
-				compute_probabilistic_vector(discrete_ma,v,u,max, false);
-			}
+			// shift up to a, we don't make discrete model absorbing
+			compute_time_bounded_step(discrete_ma,v,u,part,order_shift, false,max,both,locks,min_locks,reach);
 			
 			/*
 			if(counter==interval_step) {
@@ -515,7 +827,7 @@ Real compute_time_bounded_reachability(SparseMatrix* ma, bool max, Real epsilon,
 					prob=1;
 				bool *initials = ma->initials;
 				for (unsigned long state_nr = 0; state_nr < num_states; state_nr++) {
-					//cout << (ma->states_nr.find(state_nr)->second).c_str() << ": " << u[state_nr] << endl;
+					//cout << state_name(ma->names, state_nr) << ": " << u[state_nr] << endl;
 					if(initials[state_nr]){
 					if(max){
 						if(prob<u[state_nr])
@@ -537,7 +849,6 @@ Real compute_time_bounded_reachability(SparseMatrix* ma, bool max, Real epsilon,
 			*/
 			
 		}
-		SparseMatrix_free(discrete_ma);
 
 
 	} else { // if a == 0
@@ -563,42 +874,26 @@ Real compute_time_bounded_reachability(SparseMatrix* ma, bool max, Real epsilon,
 		
 		
 		for(unsigned long i=0; i <= steps_for_interval; i++){
-			// compute v for Markovian states: from b dwon to a, we make discrete model absorbing
-			compute_markovian_vector(discrete_ma,v,u, true);
-			// compute u for Probabilistic states
-			if(is_imc){
-				// if MA is in fact an IMC we can simplify the computation
-				compute_interactive_vector(discrete_ma,v,u,max,locks,reach);
-			}else {
-				compute_probabilistic_vector(discrete_ma,v,u,max, true);
-			}
+			// from b dwon to a, we make discrete model absorbing
+			compute_time_bounded_step(discrete_ma,v,u,part,order, true,max,both,locks,min_locks,reach);
 			
 			if(i >= interval_start_point){
 			if((counter==interval_step || i==interval_start_point) && interval != tb) {
 			
-				Real prob;
-				if(max)
-					prob=0;
-				else
-					prob=1;
-				bool *initials = ma->initials;
-				for (unsigned long state_nr = 0; state_nr < num_states; state_nr++) {
-					//cout << (ma->states_nr.find(state_nr)->second).c_str() << ": " << u[state_nr] << endl;
-					if(initials[state_nr]){
-					if(max){
-						if(prob<u[state_nr])
-							prob=u[state_nr];
-						}else{
-						if(prob>u[state_nr])
-							prob=u[state_nr];
-						}
-					}
-				}
-				
 				Real tmp = i*tau - tmp_interval;
 				tmp = i*tau - tmp;
 				
-				printf("tb=%.5g Maximal time-bounded reachability probability: %.10g  (Real tb=%.5g)\n", tmp,prob,i*tau);
+				if(sink != NULL) {
+					for (unsigned long slot = 0; slot < width; slot++) {
+						bool slot_max = both ? (slot == 0) : max;
+						ResultSink_values(sink, ma, "tb", slot_max, tmp, &u[0], width, slot, initial_probability(ma,u,slot_max,width,slot), false);
+					}
+				} else if(both) {
+					printf("tb=%.5g Maximal time-bounded reachability probability: %.10g  (Real tb=%.5g)\n", tmp,initial_probability(ma,u,true,2,0),i*tau);
+					printf("tb=%.5g Minimal time-bounded reachability probability: %.10g  (Real tb=%.5g)\n", tmp,initial_probability(ma,u,false,2,1),i*tau);
+				} else {
+					printf("tb=%.5g Maximal time-bounded reachability probability: %.10g  (Real tb=%.5g)\n", tmp,initial_probability(ma,u,max,1,0),i*tau);
+				}
 				
 				tmp_interval += tmp_step;
 				counter=0;
@@ -607,33 +902,405 @@ Real compute_time_bounded_reachability(SparseMatrix* ma, bool max, Real epsilon,
 			}
 			}
 		}
-		SparseMatrix_free(discrete_ma);
-        delete(discrete_ma);
 
 	}
+	SweepOrder_free(order);
+	SweepOrder_free(order_shift);
+	StatePartition_free(part);
+	InteractiveClosure_free(reach);
+	free(locks);
+	free(min_locks);
 	// find prob. for initial state and return
-	Real prob;
-	if(max)
-		prob=0;
-	else
-		prob=1;
-	bool *initials = ma->initials;
-	printf("vector(%d) [",num_states);
+	if(sink != NULL) {
+		for (unsigned long slot = 0; slot < width; slot++) {
+			bool slot_max = both ? (slot == 0) : max;
+			ResultSink_values(sink, ma, "tb", slot_max, tb, &u[0], width, slot, initial_probability(ma,u,slot_max,width,slot), true);
+		}
+	}
+	
+	if(both) {
+		*min_prob = initial_probability(ma,u,false,2,1);
+		return initial_probability(ma,u,true,2,0);
+	}
+	return initial_probability(ma,u,max,1,0);
+}
+
+/**
+* computes time-bounded reachability
+*
+* @param ma the MA
+* @param max maximum/minimum
+* @param epsilon the given error
+* @param tb the given time bound
+* @param is_imc indicates if MA is an IMC
+* @param sink receives the interval output and the final values, NULL to print the interval output
+*/
+Real compute_time_bounded_reachability(SparseMatrix* ma, bool max, Real epsilon, Real ta, Real tb, bool is_imc, Real interval,Real interval_start, ResultSink *sink) {
+	return time_bounded_reachability(ma, max, false, epsilon, ta, tb, is_imc, interval, interval_start, NULL, sink);
+}
+
+/**
+* computes the maximal and the minimal time-bounded reachability at once:
+* both share the discretised model and every pass over its transitions
+*
+* @param ma the MA
+* @param epsilon the given error
+* @param tb the given time bound
+* @param is_imc indicates if MA is an IMC
+* @param max_prob the maximal probability
+* @param min_prob the minimal probability
+* @param sink receives the interval output and the final values, NULL to print the interval output
+*/
+void compute_time_bounded_reachability_both(SparseMatrix* ma, Real epsilon, Real ta, Real tb, bool is_imc, Real interval,Real interval_start, Real *max_prob, Real *min_prob, ResultSink *sink) {
+	*max_prob = time_bounded_reachability(ma, true, true, epsilon, ta, tb, is_imc, interval, interval_start, min_prob, sink);
+}
+
+/**
+* Computes time-bounded reachability for several intervals [0,tb] at once.
+* All time bounds share one discretisation: tau is chosen for the largest
+* time bound, which meets the error bound epsilon for all smaller ones as
+* well. The value iteration runs once up to the largest time bound and the
+* probability of each time bound is taken on the way. The maximum and the
+* minimum share the discretised model and, if both are asked for, every
+* pass over it.
+*
+* @param ma the MA
+* @param epsilon the given error
+* @param tbs the time bounds
+* @param is_imc indicates if MA is an IMC
+* @param max compute the maximal probabilities
+* @param min compute the minimal probabilities
+* @param max_probs the maximal probability for each time bound
+* @param min_probs the minimal probability for each time bound
+* @param max_times seconds until each maximal probability was known
+* @param min_times seconds until each minimal probability was known
+*/
+void compute_time_bounded_reachability_sweep(SparseMatrix* ma, Real epsilon, const vector<Real>& tbs, bool is_imc, bool max, bool min,
+		vector<Real>& max_probs, vector<Real>& min_probs, vector<double>& max_times, vector<double>& min_times) {
+	unsigned long num_states = ma->n;
+	max_probs.assign(tbs.size(), 0);
+	min_probs.assign(tbs.size(), 1);
+	max_times.assign(tbs.size(), 0);
+	min_times.assign(tbs.size(), 0);
+	if(tbs.empty())
+		return;
+
+	// the smallest tau is needed for the largest time bound
+	Real tb_max = tbs[0];
+	for(unsigned long k=1; k < tbs.size(); k++) {
+		if(tb_max < tbs[k])
+			tb_max = tbs[k];
+	}
+	Real tau = compute_error_bound(ma, epsilon, tb_max);
+
+	// the step at which each time bound is reached, in the order of the steps
+	vector< pair<unsigned long,unsigned long> > steps(tbs.size());
+	for(unsigned long k=0; k < tbs.size(); k++) {
+		steps[k].first = round(tbs[k]/tau);
+		steps[k].second = k;
+	}
+	sort(steps.begin(), steps.end());
+	unsigned long last_step = steps.back().first;
+
+	dbg_printf("discretize model\n");
+	SparseMatrix* discrete_ma = discretize_model(ma,tau);
+	dbg_printf("model discretized\n");
+	StatePartition *part = StatePartition_new(ma, NULL);
+	SweepOrder *order = SweepOrder_new(ma, part, part->starts[CLASS_PS_LOCK]);
+	cout << "iterations: " << last_step << endl;
+	cout << "step duration: " << tau << endl;
+
+	bool both = max && min;
+	unsigned long width = both ? 2 : 1;
+	for(int objective=0; objective < 2; objective++) {
+		bool is_max = (objective == 0);
+		if((is_max && !max) || (!is_max && !min) || (both && !is_max))
+			continue;
+
+		#ifndef __APPLE__
+		struct timespec ts;
+		clock_gettime(CLOCK_REALTIME, &ts);
+		double start = ts.tv_sec + 1e-9*ts.tv_nsec;
+		#endif
+
+		// with both objectives the maximum and the minimum of a state are stored next to each other
+		vector<Real> v(width*num_states,0); // Markovian vector
+		vector<Real> u(width*num_states,0); // Probabilistic vector
+		bool *goals = ma->goals;
+		for (unsigned long state_nr = 0; state_nr < num_states; state_nr++) {
+			if(goals[state_nr]){
+				for (unsigned long slot = 0; slot < width; slot++)
+					v[width*state_nr + slot]=1;
+			}
+		}
+		// in case MA is an IMC: precomputation of paths for interactive states
+		InteractiveClosure *reach = NULL;
+		bool *locks = NULL;
+		bool *min_locks = NULL;
+		if(is_imc) {
+			locks = is_max ? compute_locks_strong(ma) : compute_locks_weak(ma);
+			if(both)
+				min_locks = compute_locks_weak(ma);
+			reach = interactiveReachability(ma);
+		}
+
+		unsigned long next = 0;
+		for(unsigned long i=0; i <= last_step; i++){
+			compute_time_bounded_step(discrete_ma,v,u,part,order, true,is_max,both,locks,min_locks,reach);
+			for(; next < steps.size() && steps[next].first == i; next++) {
+				unsigned long k = steps[next].second;
+				#ifndef __APPLE__
+				clock_gettime(CLOCK_REALTIME, &ts);
+				double seconds = ts.tv_sec + 1e-9*ts.tv_nsec - start;
+				#else
+				double seconds = 0;
+				#endif
+				if(both) {
+					max_probs[k] = initial_probability(ma,u,true,2,0);
+					min_probs[k] = initial_probability(ma,u,false,2,1);
+					max_times[k] = seconds;
+					min_times[k] = seconds;
+				} else {
+					(is_max ? max_probs : min_probs)[k] = initial_probability(ma,u,is_max,1,0);
+					(is_max ? max_times : min_times)[k] = seconds;
+				}
+			}
+		}
+		InteractiveClosure_free(reach);
+		free(locks);
+		free(min_locks);
+	}
+
+	SweepOrder_free(order);
+	StatePartition_free(part);
+}
+
+/**
+* finds the states which reach a goal state, by a backward search over the
+* predecessors of the goal states
+*
+* @param ma the MA
+* @return true for each state which reaches a goal state
+*/
+static bool* compute_goal_reaching(SparseMatrix* ma) {
+	bool *reaching = (bool *) malloc((ma->n > 0 ? ma->n : 1) * sizeof(bool));
+	reach_some(ma, ma->goals, NULL, NULL, reaching);
+	return reaching;
+}
+
+/**
+* sets each interactive state to the largest value of its successors, the
+* states before the interactive ones keep their values
+*
+* @param ma the MA
+* @param u values of all states
+* @param order order of the interactive states
+*/
+static void compute_largest_successor(SparseMatrix* ma, vector<Real>& u, const SweepOrder *order) {
+	sparse_index *row_starts = ma->row_starts;
+	sparse_index *choice_starts = ma->choice_starts;
+	sparse_index *cols = ma->cols;
+	const sparse_index *order_states = order->states;
+
+	// all states of a cyclic block reach each other and get the largest value of their successors
+	for (unsigned long b = 0; b < order->n; b++) {
+		unsigned long b_start = order->block_starts[b];
+		unsigned long b_end = order->block_starts[b + 1];
+		bool cyclic = order->cyclic[b];
+		Real block_best = 0;
+		if (cyclic) {
+			for (unsigned long k = b_start; k < b_end; k++) {
+				u[order_states[k]] = 0;
+			}
+		}
+		for (unsigned long k = b_start; k < b_end; k++) {
+			unsigned long s_idx = order_states[k];
+			Real best = 0;
+			for (unsigned long i = choice_starts[row_starts[s_idx]]; i < choice_starts[row_starts[s_idx + 1]]; i++) {
+				if(best < u[cols[i]])
+					best = u[cols[i]];
+			}
+			if (cyclic) {
+				if(block_best < best)
+					block_best = best;
+			} else {
+				u[s_idx] = best;
+			}
+		}
+		if (cyclic) {
+			for (unsigned long k = b_start; k < b_end; k++) {
+				u[order_states[k]] = block_best;
+			}
+		}
+	}
+}
+
+/**
+* computes one step of the error bound of the discretisation
+*
+* The error of a state is at most its local error plus the error of its
+* successors, weighted like the values for Markovian states and the largest
+* one for probabilistic states. The largest error is taken for every choice,
+* so the bound holds for the maximum and the minimum.
+*
+* @param ma the discretised MA
+* @param ev error of the Markovian states
+* @param eu error of all states
+* @param local local error of each Markovian state in one step
+* @param part state partition of the MA
+* @param order order of the interactive states
+*/
+static void compute_error_vector(SparseMatrix* ma, vector<Real>& ev, vector<Real>& eu, const vector<Real>& local, const StatePartition *part, const SweepOrder *order) {
+	sparse_index *row_starts = ma->row_starts;
+	sparse_index *choice_starts = ma->choice_starts;
+	sparse_index *cols = ma->cols;
+	Real* non_zeros = ma->non_zeros;
+	const sparse_index *states = part->states;
+	unsigned long ms_end = part->starts[CLASS_MS_GOAL];
+
+	// goal states are absorbing and have no error
+	#pragma omp parallel for schedule(static) if(ms_end - part->starts[CLASS_MS] >= PARALLEL_MIN_STATES)
+	for (unsigned long k = part->starts[CLASS_MS]; k < ms_end; k++) {
+		unsigned long state_nr = states[k];
+		Real err = local[state_nr];
+		for (unsigned long i = choice_starts[row_starts[state_nr]]; i < choice_starts[row_starts[state_nr + 1]]; i++) {
+			err += non_zeros[i] * eu[cols[i]];
+		}
+		ev[state_nr] = err;
+	}
+	for (unsigned long k = 0; k < order->first; k++) {
+		eu[states[k]] = ev[states[k]];
+	}
+	compute_largest_successor(ma, eu, order);
+}
+
+/**
+* computes time-bounded reachability for the interval [0,tb] with an adaptive
+* discretisation step
+*
+* The fixed step of compute_error_bound is chosen for the largest exit rate
+* of the MA. Here only the exit rates of non-goal Markovian states which
+* reach a goal state are taken into account, as all other states have an
+* exact value. Besides the values, the iteration computes an error bound.
+* The discretised model is wrong for a step of length tau if Markovian state s
+* jumps to s' and the Markovian states s' reaches by interactive transitions
+* jump again within the same step. With E the exit rate of s and lambda the
+* largest exit rate of those states, this happens with probability at most
+* min(E*lambda*tau^2/2, (1-e^(-E*tau))*(1-e^(-lambda*tau))). The errors are
+* summed up along the paths of the discretised model, so states rarely
+* visited or left for a goal state early add little to the bound and a much
+* coarser step often meets epsilon. The iteration starts with a coarse step
+* and refines it until the bound is below epsilon. The number of steps of the
+* fixed step (for the relevant exit rates) meets epsilon in any case and is
+* never exceeded.
+*
+* @param ma the MA
+* @param max maximum/minimum
+* @param epsilon the given error
+* @param tb the given time bound
+* @param is_imc indicates if MA is an IMC
+* @param sink receives the final values, may be NULL
+* @return probability for the initial states
+*/
+Real compute_time_bounded_reachability_adaptive(SparseMatrix* ma, bool max, Real epsilon, Real tb, bool is_imc, ResultSink *sink) {
+	unsigned long num_states = ma->n;
+	SparseMatrix_prepare(ma);
+	Real *state_rates = ma->state_rates;
+
+	// only the exit rates of states which can still change their value matter
+	bool *reaching = compute_goal_reaching(ma);
+	Real lambda = 0;
 	for (unsigned long state_nr = 0; state_nr < num_states; state_nr++) {
-		//cout << (ma->states_nr.find(state_nr)->second).c_str() << ": " << u[state_nr] << endl;
-		printf(" %lf,",u[state_nr]);
-		if(initials[state_nr]){
-			if(max){
-				if(prob<u[state_nr])
-					prob=u[state_nr];
-			}else{
-				if(prob>u[state_nr])
-					prob=u[state_nr];
+		if(!ma->isPS[state_nr] && !ma->goals[state_nr] && reaching[state_nr] && lambda < state_rates[state_nr])
+			lambda = state_rates[state_nr];
+	}
+	// number of steps of the fixed step for lambda
+	Real safe = ceil(tb * tb * lambda * lambda / (2 * epsilon));
+	unsigned long safe_steps = safe > 1 ? (unsigned long) safe : 1;
+	unsigned long steps = safe_steps / ADAPTIVE_FIRST_STEP_DIVISOR;
+	if(steps < 1)
+		steps = 1;
+	printf("relevant max exit rate: %g (max exit rate: %g)\n", lambda, ma->max_exit_rate);
+	printf("iterations for the fixed step: %lu\n", safe_steps);
+
+	StatePartition *part = StatePartition_new(ma, NULL);
+	SweepOrder *order = SweepOrder_new(ma, part, part->starts[CLASS_PS_LOCK]);
+	// largest relevant exit rate each state reaches by interactive transitions
+	vector<Real> rates(num_states, 0);
+	for (unsigned long state_nr = 0; state_nr < num_states; state_nr++) {
+		if(!ma->isPS[state_nr] && !ma->goals[state_nr] && reaching[state_nr])
+			rates[state_nr] = state_rates[state_nr];
+	}
+	compute_largest_successor(ma, rates, order);
+	InteractiveClosure *reach = NULL;
+	bool *locks = NULL;
+	if(is_imc) {
+		locks = max ? compute_locks_strong(ma) : compute_locks_weak(ma);
+		reach = interactiveReachability(ma);
+	}
+
+	vector<Real> v(num_states);
+	vector<Real> u(num_states);
+	vector<Real> ev(num_states);
+	vector<Real> eu(num_states);
+	vector<Real> local(num_states);
+	Real prob;
+	while(true) {
+		Real tau = tb / steps;
+		// the fixed step meets epsilon anyway, its error bound is not needed
+		bool bound = steps < safe_steps;
+		for (unsigned long state_nr = 0; state_nr < num_states; state_nr++) {
+			v[state_nr] = ma->goals[state_nr] ? 1 : 0;
+			u[state_nr] = 0;
+			ev[state_nr] = 0;
+			eu[state_nr] = 0;
+			local[state_nr] = 0;
+			if(!ma->isPS[state_nr] && !ma->goals[state_nr] && reaching[state_nr]) {
+				Real rate = state_rates[state_nr];
+				for (unsigned long i = ma->choice_starts[ma->row_starts[state_nr]]; i < ma->choice_starts[ma->row_starts[state_nr + 1]]; i++) {
+					Real next_rate = rates[ma->cols[i]];
+					local[state_nr] += ma->branching[i] * min(rate * next_rate * tau * tau / 2, expm1(-rate * tau) * expm1(-next_rate * tau));
+				}
 			}
 		}
+		printf("step duration: %g\n", tau);
+		cout << "iterations: " << steps << endl;
+
+		dbg_printf("discretize model\n");
+		SparseMatrix* discrete_ma = discretize_model(ma,tau);
+		dbg_printf("model discretized\n");
+		// the first step only carries the goal states over to u
+		for(unsigned long i=0; i <= steps; i++){
+			compute_markovian_vector(discrete_ma,v,u,part, true);
+			if(is_imc){
+				compute_interactive_vector(discrete_ma,v,u,max,locks,reach);
+			}else {
+				compute_probabilistic_vector(discrete_ma,v,u,part,order,max);
+			}
+			if(bound && i > 0)
+				compute_error_vector(discrete_ma,ev,eu,local,part,order);
+		}
+
+		prob = initial_probability(ma,u,max,1,0);
+		if(!bound)
+			break;
+		// the error of every initial state counts, not only of the optimal one
+		Real error = initial_probability(ma,eu,true,1,0);
+		printf("error bound: %g\n", error);
+		if(error <= epsilon)
+			break;
+		// the error bound shrinks about linearly with the step; computing it doubles
+		// the work of a step, so half of the fixed steps are not worth it
+		Real refined = ceil(steps * (error / epsilon) * 1.1);
+		steps = 2 * refined < safe_steps ? (unsigned long) refined : safe_steps;
 	}
-	printf(" ]\n");
-	
-	
+	if(sink != NULL)
+		ResultSink_values(sink, ma, "tb", max, tb, &u[0], 1, 0, prob, true);
+
+	SweepOrder_free(order);
+	StatePartition_free(part);
+	InteractiveClosure_free(reach);
+	free(locks);
+	free(reaching);
 	return prob;
 }
@@ -25,6 +25,7 @@
 
 
 #include "bounded_reward.h"
+#include "bounded.h"
 #include "read_file.h"
 #include "debug.h"
 #include "sccs.h"
@@ -46,9 +47,9 @@ Real compute_max_action_reward(SparseMatrix* ma){
 
 	const Real precision = 1e-10;
 	unsigned long statecount = ma-> n;
-	unsigned long *row_starts = (unsigned long *) ma->row_counts;
-	unsigned long *choice_starts = (unsigned long *) ma->choice_counts;
-	unsigned long *cols = ma->cols;
+	sparse_index *row_starts = ma->row_starts;
+	sparse_index *choice_starts = ma->choice_starts;
+	sparse_index *cols = ma->cols;
 	Real* non_zeros = ma->non_zeros;
 	Real* rewards = ma->rewards;
 
@@ -127,129 +128,41 @@ Real compute_error_bound_reward(SparseMatrix* ma, Real epsilon, Real tb) {
 	return tau;
 }
 
-/**
-* discretizes the MA
-*
-* @param ma the MA
-* @param tau discretization factor
-* @return discretized MA
-*/
-SparseMatrix* discretize_model_reward(SparseMatrix* ma, Real tau) {
-	SparseMatrix* discrete_ma;
-	dbg_printf("memory alloc.\n");
-	discrete_ma=SparseMatrixDiscrete_new(ma);
-	
-	// transitions for MA
-	unsigned long *row_starts = (unsigned long *) ma->row_counts;
-	unsigned long *rate_starts = (unsigned long *) ma->rate_counts;
-	unsigned long *choice_starts = (unsigned long *) ma->choice_counts;
-	
-	// transition variables for discrete_ma
-	//unsigned long *d_choice_starts = (unsigned long *) discrete_ma->choice_counts;
-	//unsigned long *d_row_starts = (unsigned long *) discrete_ma->row_counts;
-	Real *non_zeros = discrete_ma->non_zeros;
-	Real *rewards = discrete_ma->rewards;
-	unsigned long *cols = discrete_ma->cols;
-	unsigned long nz_index = 0;
-	//unsigned long choice_index = 0;
-	//unsigned long choice_size = 0;
-	
-	dbg_printf("discretization\n");
-	// add for each Markovian state a loop transition ==> new memory allocation for non_zero, choices and successors
-	for (unsigned long state_nr = 0; state_nr < ma->n; state_nr++) {
-		unsigned long state_start = row_starts[state_nr];
-		unsigned long state_end = row_starts[state_nr + 1];
-		unsigned long r_start = rate_starts[state_nr];
-		//unsigned long r_end = rate_starts[state_nr];
-		dbg_printf("check if Markovian\n");
-		// Look at Markovian states
-		if(!ma->isPS[state_nr])
-		{
-			for (unsigned long choice_nr = state_start; choice_nr < state_end; choice_nr++) {
-				// Add up all outgoing rates of the distribution
-				unsigned long i_start = choice_starts[choice_nr];
-				unsigned long i_end = choice_starts[choice_nr + 1];
-				Real exit_rate = ma->exit_rates[r_start];
-				//Real tmp=Real(1)-exp(-(exit_rate*tau));
-				// precision of Real could be to small (exp_estau)
-				Real estau = -(exit_rate * tau);
-				Real exp_estau = exp(estau);
-				Real exp_estau_com = Real(1)-exp_estau;
-				rewards[choice_nr] = exit_rate == 0.0 ? tau * ma->rewards[choice_nr] : ma->rewards[choice_nr] / exit_rate * exp_estau_com; // Reward of each step for Markovian state s is: Rew(s)/E(s)*(1-exp(-E(s)*tau))
-				bool loop=false;
-				for (unsigned long i = i_start; i < i_end; i++) {
-					Real prob = ma->non_zeros[i]/exit_rate;
-					non_zeros[nz_index] = exp_estau_com*prob;
-					cols[nz_index] = ma->cols[i];
-					if(state_nr==ma->cols[i]){
-						loop=true;
-						non_zeros[nz_index] += exp_estau;
-					}
-					nz_index++;
-				}
-				dbg_printf("add selfloop\n");
-				// add selfloop 
-				if(!loop) {
-					non_zeros[nz_index] = exp_estau;
-					cols[nz_index] = state_nr;
-					nz_index++;
-				}
-			}
-		}else {
-			for (unsigned long choice_nr = state_start; choice_nr < state_end; choice_nr++) {
-				// Write the reward into discrete model
-				rewards[choice_nr] = ma->rewards[choice_nr];
-				// Add up all outgoing rates of the distribution
-				unsigned long i_start = choice_starts[choice_nr];
-				unsigned long i_end = choice_starts[choice_nr + 1];
-				for (unsigned long i = i_start; i < i_end; i++) {
-					non_zeros[nz_index] = ma->non_zeros[i];
-					cols[nz_index] = ma->cols[i];
-					nz_index++;
-				}
-			}
-		}
-	}
-	return discrete_ma;
-}
-
 /**
 * computes one step for Markovian states
 *
 * @param ma the MA
 * @param v Markovian vector
 * @param u result vector
+* @param part state partition of the MA
 * @param is_MA_made_absorbing: if true then all goal states are made absorbing, otherwise not
 */
-void compute_markovian_vector_with_reward(SparseMatrix* ma, vector<Real>& v, const vector<Real> &u, bool is_MA_made_absorbing){
-	unsigned long *row_starts = (unsigned long *) ma->row_counts;
-	unsigned long *choice_starts = (unsigned long *) ma->choice_counts;
-	unsigned long *cols = ma->cols;
+void compute_markovian_vector_with_reward(SparseMatrix* ma, vector<Real>& v, const vector<Real> &u, const StatePartition *part, bool is_MA_made_absorbing){
+	sparse_index *row_starts = ma->row_starts;
+	sparse_index *choice_starts = ma->choice_starts;
+	sparse_index *cols = ma->cols;
 	Real* non_zeros = ma->non_zeros;
 	Real* rewards = ma->rewards;
-	bool *goals = ma->goals;
-	for (unsigned long state_nr = 0; state_nr < ma->n; state_nr++) {
+	const sparse_index *states = part->states;
+	// Look at Markovian states
+	#pragma omp parallel for schedule(static) if(part->starts[CLASS_PS_GOAL] - part->starts[CLASS_MS] >= PARALLEL_MIN_STATES)
+	for (unsigned long k = part->starts[CLASS_MS]; k < part->starts[CLASS_PS_GOAL]; k++) {
+		unsigned long state_nr = states[k];
 		unsigned long state_start = row_starts[state_nr];
 		unsigned long state_end = row_starts[state_nr + 1];
-		// Look at Markovian states
-//		if(goals[state_nr] && is_MA_made_absorbing){
-//			v[state_nr]=1;
-//		}else{
-			if(!ma->isPS[state_nr])
-			{
-				for (unsigned long choice_nr = state_start; choice_nr < state_end; choice_nr++) {
-					// Add up all outgoing rates of the distribution
-					unsigned long i_start = choice_starts[choice_nr];
-					unsigned long i_end = choice_starts[choice_nr + 1];
-					v[state_nr] = rewards[choice_nr];
-					for (unsigned long i = i_start; i < i_end; i++) {
-						v[state_nr] +=  non_zeros[i] * u[cols[i]];
-					}
-				}
-			}else {
-					v[state_nr] = u[state_nr];
+		for (unsigned long choice_nr = state_start; choice_nr < state_end; choice_nr++) {
+			// Add up all outgoing rates of the distribution
+			unsigned long i_start = choice_starts[choice_nr];
+			unsigned long i_end = choice_starts[choice_nr + 1];
+			v[state_nr] = rewards[choice_nr];
+			for (unsigned long i = i_start; i < i_end; i++) {
+				v[state_nr] +=  non_zeros[i] * u[cols[i]];
 			}
-//		}
+		}
+	}
+	// probabilistic states
+	for (unsigned long k = part->starts[CLASS_PS_GOAL]; k < part->starts[NUM_STATE_CLASSES]; k++) {
+		v[states[k]] = u[states[k]];
 	}
 }
 
@@ -257,48 +170,48 @@ void compute_markovian_vector_with_reward(SparseMatrix* ma, vector<Real>& v, con
 * computes one step for probabilistic states
 *
 * @param ma the MA
-* @param v Markovian vector (we use it as temporary variable for u vector elements as well, so its value after calling of the function is not valid)
+* @param v Markovian vector
 * @param u result vector
+* @param part state partition of the MA
+* @param order order of the interactive states
 * @param max maximum/minimum
-* @param is_MA_made_absorbing: if true then all goal states are made absorbing, otherwise not
 */
-void compute_probabilistic_vector_with_reward(SparseMatrix* ma, vector<Real>& v, vector<Real>& u, bool max, bool is_MA_made_absorbing){
+void compute_probabilistic_vector_with_reward(SparseMatrix* ma, vector<Real>& v, vector<Real>& u, const StatePartition *part, const SweepOrder *order, bool max){
 
 	const Real precision = 1e-7;
-	unsigned long statecount = ma-> n;
-	unsigned long *row_starts = (unsigned long *) ma->row_counts;
-	unsigned long *choice_starts = (unsigned long *) ma->choice_counts;
-	unsigned long *cols = ma->cols;
+	sparse_index *row_starts = ma->row_starts;
+	sparse_index *choice_starts = ma->choice_starts;
+	sparse_index *cols = ma->cols;
 	Real* non_zeros = ma->non_zeros;
 	Real* rewards = ma->rewards;
+	const sparse_index *states = part->states;
+	const sparse_index *order_states = order->states;
 
-	// Initialization
-	for (unsigned long s_idx = 0; s_idx < statecount; s_idx++) {
-		if ( ma -> isPS[s_idx] && (!is_MA_made_absorbing || (is_MA_made_absorbing && !ma -> goals[s_idx])) )
-			v[s_idx] = 0.0;
-		else
-			u[s_idx] = v[s_idx];
-
+	// Initialization: the states before the interactive ones keep their values
+	for (unsigned long k = 0; k < order->first; k++) {
+		u[states[k]] = v[states[k]];
 	}
-	//long int bestChoice=0;
-
-	// main loop
-	bool done = false;
-	// done will set to true inside the while loop when we are close enough to the fixed point
-	while (! done) {
-		done = true;
-
-
-		// do one step of fixed point, it is applied on interactive states
-		for (unsigned long s_idx = 0; s_idx < statecount; s_idx++) {
-			unsigned long state_start = row_starts[s_idx];
-			unsigned long state_end = row_starts[s_idx + 1];
-			if ( ma -> isPS[s_idx] && (!is_MA_made_absorbing || (is_MA_made_absorbing && !ma -> goals[s_idx])) ){  // do processing only if the state is interactive
-				if (max)
-					u[s_idx] = 0.0;
-				else
-					u[s_idx] = infinity;//1.0;
-				// find the max/min prob. to reach Markovians and store it to tmp
+	// solve one block after another, the successors of a block are solved before it
+	for (unsigned long b = 0; b < order->n; b++) {
+		unsigned long b_start = order->block_starts[b];
+		unsigned long b_end = order->block_starts[b + 1];
+		bool cyclic = order->cyclic[b];
+		if (cyclic) {
+			for (unsigned long k = b_start; k < b_end; k++) {
+				u[order_states[k]] = 0.0;
+			}
+		}
+		// an acyclic block is done after one pass, a cyclic one when it is close enough to the fixed point
+		bool done;
+		do {
+			done = true;
+			for (unsigned long k = b_start; k < b_end; k++) {
+				unsigned long s_idx = order_states[k];
+				unsigned long state_start = row_starts[s_idx];
+				unsigned long state_end = row_starts[s_idx + 1];
+				Real best = max ? 0.0 : infinity;
+
+				// find the max/min prob. to reach Markovians and store it to best
 				for (unsigned long choice_nr = state_start; choice_nr < state_end; choice_nr++) {
 					Real tmp = 0;
 					// add reward
@@ -307,37 +220,23 @@ void compute_probabilistic_vector_with_reward(SparseMatrix* ma, vector<Real>& v,
 					unsigned long i_start = choice_starts[choice_nr];
 					unsigned long i_end = choice_starts[choice_nr + 1];
 					for (unsigned long i = i_start; i < i_end; i++) {
-						tmp += non_zeros[i] * v[cols[i]];
+						tmp += non_zeros[i] * u[cols[i]];
 					}
 					if( max ) {
-						if(tmp > u[s_idx] ){
-//							bestChoice=choice_nr;
-							u[s_idx] = tmp;
-						}
+						if(tmp > best )
+							best = tmp;
 					}
 					else {
-						if(tmp < u[s_idx] )
-							u[s_idx] = tmp;
+						if(tmp < best )
+							best = tmp;
 					}
 				}
-				if( fabs(u[s_idx] - v[s_idx]) >= precision )
+				if( cyclic && fabs(best - u[s_idx]) >= precision )
 					done = false;
-
+				u[s_idx] = best;
 			}
-		}
-		// write back u to v, only for interactive elements
-		for (unsigned long s_idx = 0; s_idx < statecount; s_idx++) {
-			if ( ma -> isPS[s_idx] && (!is_MA_made_absorbing || (is_MA_made_absorbing && !ma -> goals[s_idx])) ){
-				v[s_idx] = u[s_idx];
-			}
-		}
-
-		//std::cout<<bestChoice<<std::endl;
-
+		} while (! done);
 	}
-
-
-
 }
 
 /**
@@ -369,6 +268,11 @@ Real compute_time_bounded_accumulated_reward(SparseMatrix* ma, bool max, Real ep
 		}
 	}
 	*/
+	// Markovian, probabilistic and goal states as contiguous index ranges
+	StatePartition *part = StatePartition_new(ma, NULL);
+	// order of the interactive states, with goal states made absorbing and without
+	SweepOrder *order = SweepOrder_new(ma, part, part->starts[CLASS_PS_LOCK]);
+	SweepOrder *order_shift = SweepOrder_new(ma, part, part->starts[CLASS_PS_GOAL]);
 	// in case MA is an IMC: precomputation of paths for interactive states
 	vector< vector<unsigned long> > reach;
 	
@@ -390,7 +294,7 @@ Real compute_time_bounded_accumulated_reward(SparseMatrix* ma, bool max, Real ep
 
 		// discretize model with respect to the current value of tau 'current_tau'
 		dbg_printf("discretize model for interval [%g,%g] ... \n", ta, tb);
-		discrete_ma = discretize_model_reward(ma,current_tau);
+		discrete_ma = discretize_model(ma,current_tau);
 		dbg_printf("model discretized\n");
 		//print_model(discrete_ma);
 		
@@ -405,9 +309,9 @@ Real compute_time_bounded_accumulated_reward(SparseMatrix* ma, bool max, Real ep
 		
 		for(unsigned long i=0; i < steps; i++){
 			// compute v for Markovian states: from b dwon to a, we make discrete model absorbing
-			compute_markovian_vector_with_reward(discrete_ma,v,u, true);
+			compute_markovian_vector_with_reward(discrete_ma,v,u,part, true);
 			// compute u for Probabilistic states
-			compute_probabilistic_vector_with_reward(discrete_ma,v,u,max, true);
+			compute_probabilistic_vector_with_reward(discrete_ma,v,u,part,order,max);
 			
 			/*
 			if(counter==interval_step) {
@@ -419,7 +323,7 @@ Real compute_time_bounded_accumulated_reward(SparseMatrix* ma, bool max, Real ep
 					prob=1;
 				bool *initials = ma->initials;
 				for (unsigned long state_nr = 0; state_nr < num_states; state_nr++) {
-					//cout << (ma->states_nr.find(state_nr)->second).c_str() << ": " << u[state_nr] << endl;
+					//cout << state_name(ma->names, state_nr) << ": " << u[state_nr] << endl;
 					if(initials[state_nr]){
 					if(max){
 						if(prob<u[state_nr])
@@ -440,15 +344,13 @@ Real compute_time_bounded_accumulated_reward(SparseMatrix* ma, bool max, Real ep
 			*/
 			
 		}
-		// free memory
-		SparseMatrix_free(discrete_ma);
 
 		steps = (unsigned long) ceil( (ta + current_tau) / tau); // calculating the number of steps for interval [0,a]
 		current_tau = (ta + current_tau) / steps;                                // recalculate tau based on the number of steps
 
 		// discretize model with respect to the current value of tau 'current_tau'
 		dbg_printf("discretize model for interval [0,%g] ... \n", ta);
-		discrete_ma = discretize_model_reward(ma,current_tau);
+		discrete_ma = discretize_model(ma,current_tau);
 		dbg_printf("model discretized\n");
 		//print_model(discrete_ma);
 
@@ -456,9 +358,9 @@ Real compute_time_bounded_accumulated_reward(SparseMatrix* ma, bool max, Real ep
 
 		for(unsigned long i=0; i < steps; i++){
 			// compute v for Markovian states: shift up to a, we don't make discrete model absorbing
-			compute_markovian_vector_with_reward(discrete_ma,v,u, false);
+			compute_markovian_vector_with_reward(discrete_ma,v,u,part, false);
 			// compute u for Probabilistic states
-			compute_probabilistic_vector_with_reward(discrete_ma,v,u,max, false);
+			compute_probabilistic_vector_with_reward(discrete_ma,v,u,part,order_shift,max);
 			
 			/*
 			if(counter==interval_step) {
@@ -470,7 +372,7 @@ Real compute_time_bounded_accumulated_reward(SparseMatrix* ma, bool max, Real ep
 					prob=1;
 				bool *initials = ma->initials;
 				for (unsigned long state_nr = 0; state_nr < num_states; state_nr++) {
-					//cout << (ma->states_nr.find(state_nr)->second).c_str() << ": " << u[state_nr] << endl;
+					//cout << state_name(ma->names, state_nr) << ": " << u[state_nr] << endl;
 					if(initials[state_nr]){
 					if(max){
 						if(prob<u[state_nr])
@@ -492,7 +394,6 @@ Real compute_time_bounded_accumulated_reward(SparseMatrix* ma, bool max, Real ep
 			*/
 			
 		}
-		SparseMatrix_free(discrete_ma);
 
 
 	} else { // if a == 0
@@ -505,7 +406,7 @@ Real compute_time_bounded_accumulated_reward(SparseMatrix* ma, bool max, Real ep
 		dbg_printf("[*] Step Size: %f\n[*] Number of Iterations: %d\n\n", tau, steps_for_interval);
 		// discretize model with respect to the given epsilon
 		dbg_printf("discretize model\n");
-		SparseMatrix* discrete_ma = discretize_model_reward(ma,tau);
+		SparseMatrix* discrete_ma = discretize_model(ma,tau);
 		//print_model(discrete_ma,true);
 		dbg_printf("model discretized\n");
 		//print_model(discrete_ma);
@@ -524,9 +425,9 @@ Real compute_time_bounded_accumulated_reward(SparseMatrix* ma, bool max, Real ep
 		// Note: we start the computation from step one, since in contrast to time bounded reachability, the initial vector here is zero.
 		for(unsigned long i=1; i <= steps_for_interval; i++){
 			// compute v for Markovian states for the current step; we make discrete model absorbing. After this step v contains the updated reward value
-			compute_markovian_vector_with_reward(discrete_ma,v,u, true);
+			compute_markovian_vector_with_reward(discrete_ma,v,u,part, true);
 			// compute u for Probabilistic states
-			compute_probabilistic_vector_with_reward(discrete_ma,v,u,max, true);
+			compute_probabilistic_vector_with_reward(discrete_ma,v,u,part,order,max);
 			
 			if(i >= interval_start_point){
 			if((counter==interval_step || i==interval_start_point) && interval != tb) {
@@ -538,7 +439,7 @@ Real compute_time_bounded_accumulated_reward(SparseMatrix* ma, bool max, Real ep
 					prob=infinity;
 				bool *initials = ma->initials;
 				for (unsigned long state_nr = 0; state_nr < num_states; state_nr++) {
-					//cout << (ma->states_nr.find(state_nr)->second).c_str() << ": " << u[state_nr] << endl;
+					//cout << state_name(ma->names, state_nr) << ": " << u[state_nr] << endl;
 					if(initials[state_nr]){
 					if(max){
 						if(prob<u[state_nr])
@@ -562,9 +463,11 @@ Real compute_time_bounded_accumulated_reward(SparseMatrix* ma, bool max, Real ep
 			}
 			}
 		}
-		SparseMatrix_free(discrete_ma);
 
 	}
+	SweepOrder_free(order);
+	SweepOrder_free(order_shift);
+	StatePartition_free(part);
 	// find prob. for initial state and return
 	Real prob;
 	if(max)
@@ -573,7 +476,7 @@ Real compute_time_bounded_accumulated_reward(SparseMatrix* ma, bool max, Real ep
 		prob=infinity;
 	bool *initials = ma->initials;
 	for (unsigned long state_nr = 0; state_nr < num_states; state_nr++) {
-		//cout << (ma->states_nr.find(state_nr)->second).c_str() << ": " << u[state_nr] << endl;
+		//cout << state_name(ma->names, state_nr) << ": " << u[state_nr] << endl;
 		if(initials[state_nr]){
 			if(max){
 				if(prob<u[state_nr])
@@ -0,0 +1,423 @@
+/**
+* IMCA is a analyzing tool for unbounded reachability probabilities, expected-
+* time, and long-run averages for Interactive Markov Chains and Markov Automata.
+* Copyright (C) RWTH Aachen, 2012
+*				UTwente, 2013
+* 	Author: Dennis Guck
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*
+*
+* Source description:
+*	Interval iteration for unbounded reachability, expected time and
+*	expected reward. The states whose values follow from the graph of the
+*	MA (goal states, probability 0 or 1, infinite expected time) are fixed
+*	first. End components would give the upper bound several fixed points,
+*	so they are collapsed: all states of an end component share the best
+*	value of the choices leaving it. For probabilities the upper bound
+*	starts at 1. Expected time and reward have no such bound, so the upper
+*	bound is guessed from the converged lower bound and kept once a sweep
+*	does not increase it, since every vector not increased by a sweep lies
+*	above the least fixed point. Otherwise the lower bound is iterated
+*	further and the guess is repeated.
+*/
+
+#include "interval_iteration.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <iostream>
+#include <vector>
+
+#include "debug.h"
+#include "backward.h"
+#include "sccs2.h"
+
+// Coloured output
+#define COLOR_YELLOW "\x1b[33m" // Color Start
+#define COLOR_END "\x1b[0m" // To flush out prev settings
+
+using namespace std;
+
+/* a guessed upper bound which keeps increasing is given up after this many sweeps at least */
+#define MIN_GUESS_SWEEPS 10
+
+/**
+* Finds the maximal end components of the states in @a inside which only use
+* the choices in @a choice_ok. Choices leaving the component of their state
+* are dropped and states without choices left are removed until the strongly
+* connected components do not change any more.
+*
+* @param ma the MA
+* @param inside the states
+* @param choice_ok the choices which may be used, on return the choices staying inside their end component
+* @param mec gets the end component of each state, undefined for the others
+* @return # of end components
+*/
+static unsigned long find_end_components(SparseMatrix *ma, const bool *inside, bool *choice_ok, unsigned long *mec)
+{
+	const unsigned long undefined = (unsigned long) -1;
+	sparse_index *row_starts = ma->row_starts;
+	sparse_index *choice_starts = ma->choice_starts;
+	sparse_index *cols = ma->cols;
+	unsigned long n = ma->n;
+	unsigned long choices_n = row_starts[n];
+	bool *outside = (bool *) malloc((n > 0 ? n : 1) * sizeof(bool));
+	bool *choice_bad = (bool *) malloc((choices_n > 0 ? choices_n : 1) * sizeof(bool));
+	/* component of each state, 0 for the states outside */
+	vector<unsigned long> scc(n, 0);
+	unsigned long num_mecs = 0;
+	bool changed = true;
+
+	for (unsigned long state_nr = 0; state_nr < n; state_nr++) {
+		outside[state_nr] = !inside[state_nr];
+		if (!inside[state_nr]) {
+			for (unsigned long choice_nr = row_starts[state_nr]; choice_nr < row_starts[state_nr + 1]; choice_nr++)
+				choice_ok[choice_nr] = false;
+		}
+	}
+	while (changed) {
+		changed = false;
+		for (unsigned long choice_nr = 0; choice_nr < choices_n; choice_nr++)
+			choice_bad[choice_nr] = !choice_ok[choice_nr];
+		scc.assign(n, 0);
+		num_mecs = 1;
+		compute_SCC_decomposition_tarjan(ma, scc, outside, choice_bad, num_mecs);
+		/* a state in no SCC is a component of its own, it keeps the choices which only lead to itself */
+		for (unsigned long state_nr = 0; state_nr < n; state_nr++) {
+			if (!outside[state_nr] && scc[state_nr] == 0)
+				scc[state_nr] = num_mecs++;
+		}
+		for (unsigned long state_nr = 0; state_nr < n; state_nr++) {
+			if (outside[state_nr])
+				continue;
+			bool stays = false;
+			for (unsigned long choice_nr = row_starts[state_nr]; choice_nr < row_starts[state_nr + 1]; choice_nr++) {
+				if (!choice_ok[choice_nr])
+					continue;
+				for (unsigned long i = choice_starts[choice_nr]; i < choice_starts[choice_nr + 1]; i++) {
+					if (outside[cols[i]] || scc[cols[i]] != scc[state_nr]) {
+						choice_ok[choice_nr] = false;
+						changed = true;
+						break;
+					}
+				}
+				if (choice_ok[choice_nr])
+					stays = true;
+			}
+			if (!stays) {
+				outside[state_nr] = true;
+				changed = true;
+			}
+		}
+	}
+	/* the end components are numbered by their smallest state */
+	vector<unsigned long> renumber(num_mecs, undefined);
+	unsigned long num_kept = 0;
+	for (unsigned long state_nr = 0; state_nr < n; state_nr++) {
+		mec[state_nr] = undefined;
+		if (outside[state_nr])
+			continue;
+		if (renumber[scc[state_nr]] == undefined)
+			renumber[scc[state_nr]] = num_kept++;
+		mec[state_nr] = renumber[scc[state_nr]];
+	}
+	free(outside);
+	free(choice_bad);
+	return num_kept;
+}
+
+/**
+* @param ma the MA
+* @param values value of each state
+* @param max maximum/minimum
+* @return the optimal value of the initial states
+*/
+static Real initial_value(const SparseMatrix *ma, const vector<Real>& values, bool max)
+{
+	Real obj = max ? 0 : infinity;
+	for (unsigned long state_nr = 0; state_nr < ma->n; state_nr++) {
+		if (!ma->initials[state_nr])
+			continue;
+		if (max ? values[state_nr] > obj : values[state_nr] < obj)
+			obj = values[state_nr];
+	}
+	return obj;
+}
+
+unsigned long graph_values(SparseMatrix *ma, ValueObjective objective, bool max, vector<Real>& values, bool *unknown)
+{
+	unsigned long n = ma->n;
+	bool reachability = (objective == OBJECTIVE_REACHABILITY);
+	/* the maximal probability and the minimal expected time need the same graph searches */
+	bool some = reachability ? max : !max;
+
+	bool *positive = (bool *) malloc((n > 0 ? n : 1) * sizeof(bool));
+	bool *sure = (bool *) malloc((n > 0 ? n : 1) * sizeof(bool));
+	if (some) {
+		reach_some(ma, ma->goals, NULL, NULL, positive);
+		reach_surely_some(ma, sure);
+	} else {
+		reach_all(ma, ma->goals, positive);
+		reach_surely_all(ma, positive, sure);
+	}
+
+	values.assign(n, 0);
+	unsigned long num_unknown = 0;
+	for (unsigned long state_nr = 0; state_nr < n; state_nr++) {
+		unknown[state_nr] = false;
+		if (reachability) {
+			if (sure[state_nr])
+				values[state_nr] = 1;
+			else if (positive[state_nr])
+				unknown[state_nr] = true;
+		} else if (!ma->goals[state_nr]) {
+			if (!sure[state_nr])
+				values[state_nr] = infinity;
+			else
+				unknown[state_nr] = true;
+		}
+		if (unknown[state_nr])
+			num_unknown++;
+	}
+	free(positive);
+	free(sure);
+	return num_unknown;
+}
+
+void choice_costs(const SparseMatrix *ma, ValueObjective objective, vector<Real>& cost)
+{
+	sparse_index *row_starts = ma->row_starts;
+	Real *state_rates = ma->state_rates;
+
+	cost.assign(row_starts[ma->n], 0);
+	if (objective == OBJECTIVE_REACHABILITY)
+		return;
+	for (unsigned long state_nr = 0; state_nr < ma->n; state_nr++) {
+		for (unsigned long choice_nr = row_starts[state_nr]; choice_nr < row_starts[state_nr + 1]; choice_nr++) {
+			Real c = (objective == OBJECTIVE_EXPECTED_REWARD) ? ma->rewards[choice_nr] : (ma->isPS[state_nr] ? 0 : 1);
+			if (!ma->isPS[state_nr] && state_rates[state_nr] > 0)
+				c /= state_rates[state_nr];
+			cost[choice_nr] = c;
+		}
+	}
+}
+
+Real interval_iteration(SparseMatrix *ma, ValueObjective objective, bool max, Real epsilon, Real *lower, Real *upper)
+{
+	const unsigned long undefined = (unsigned long) -1;
+	SparseMatrix_prepare(ma);
+	unsigned long n = ma->n;
+	sparse_index *row_starts = ma->row_starts;
+	sparse_index *choice_starts = ma->choice_starts;
+	sparse_index *cols = ma->cols;
+	Real *branching = ma->branching;
+	unsigned long choices_n = row_starts[n];
+	bool reachability = (objective == OBJECTIVE_REACHABILITY);
+	/* the maximal probability and the minimal expected time need the same graph searches */
+	bool some = reachability ? max : !max;
+
+	// states with a value fixed by the graph of the MA
+	bool *unknown = (bool *) malloc((n > 0 ? n : 1) * sizeof(bool));
+	vector<Real> low(n, 0);	// lower bound
+	unsigned long num_unknown = graph_values(ma, objective, max, low, unknown);
+	vector<Real> up(low);	// upper bound
+	for (unsigned long state_nr = 0; state_nr < n; state_nr++) {
+		if (unknown[state_nr])
+			up[state_nr] = reachability ? 1 : infinity;
+	}
+
+	// time or reward of each choice until the next state
+	vector<Real> cost;
+	choice_costs(ma, objective, cost);
+
+	// end components: the maximum of probabilities and the minimum of costs may stay in them forever
+	bool *internal = (bool *) calloc(choices_n > 0 ? choices_n : 1, sizeof(bool));
+	unsigned long *mec = (unsigned long *) malloc((n > 0 ? n : 1) * sizeof(unsigned long));
+	unsigned long num_mecs = 0;
+	if (some) {
+		for (unsigned long choice_nr = 0; choice_nr < choices_n; choice_nr++)
+			internal[choice_nr] = (cost[choice_nr] == 0);
+		num_mecs = find_end_components(ma, unknown, internal, mec);
+	} else {
+		for (unsigned long state_nr = 0; state_nr < n; state_nr++)
+			mec[state_nr] = undefined;
+	}
+	vector<sparse_index> mec_starts(num_mecs + 1, 0);
+	vector<sparse_index> mec_states;
+	for (unsigned long state_nr = 0; state_nr < n; state_nr++) {
+		if (mec[state_nr] != undefined)
+			mec_starts[mec[state_nr] + 1]++;
+	}
+	for (unsigned long m = 0; m < num_mecs; m++)
+		mec_starts[m + 1] += mec_starts[m];
+	mec_states.resize(mec_starts[num_mecs]);
+	{
+		vector<sparse_index> next(mec_starts.begin(), mec_starts.end() - 1);
+		for (unsigned long state_nr = 0; state_nr < n; state_nr++) {
+			if (mec[state_nr] != undefined)
+				mec_states[next[mec[state_nr]]++] = state_nr;
+		}
+	}
+
+	// units of the sweep, successors first: single states and collapsed end components
+	vector<sparse_index> unknown_states;
+	for (unsigned long state_nr = 0; state_nr < n; state_nr++) {
+		if (unknown[state_nr])
+			unknown_states.push_back(state_nr);
+	}
+	SweepOrder *order = SweepOrder_states_new(ma, unknown_states.empty() ? NULL : &unknown_states[0], unknown_states.size());
+	vector<sparse_index> unit_starts;
+	vector<sparse_index> unit_states;
+	vector<bool> mec_done(num_mecs, false);
+	for (unsigned long b = 0; b < order->n; b++) {
+		/* a cyclic block is swept from the states found last, which tend to be the successors */
+		for (unsigned long j = order->block_starts[b]; j < order->block_starts[b + 1]; j++) {
+			unsigned long k = order->cyclic[b] ? order->block_starts[b] + order->block_starts[b + 1] - 1 - j : j;
+			unsigned long state_nr = order->states[k];
+			unsigned long m = mec[state_nr];
+			if (m == undefined) {
+				unit_starts.push_back(unit_states.size());
+				unit_states.push_back(state_nr);
+			} else if (!mec_done[m]) {
+				mec_done[m] = true;
+				unit_starts.push_back(unit_states.size());
+				for (unsigned long i = mec_starts[m]; i < mec_starts[m + 1]; i++)
+					unit_states.push_back(mec_states[i]);
+			}
+		}
+	}
+	SweepOrder_free(order);
+	unsigned long num_units = unit_starts.size();
+	unit_starts.push_back(unit_states.size());
+	free(mec);
+	free(unknown);
+	printf("states to iterate: %lu, end components: %lu\n", num_unknown, num_mecs);
+
+	cout << "start interval iteration" << endl;
+	/* the upper bound lies above the value, for probabilities from the start */
+	bool verified = reachability;
+	/* the upper bound is a guess to be checked by the next sweep */
+	bool guessing = false;
+	/* the lower bound is precise enough for a guess if no value changes by more than delta */
+	Real delta = epsilon;
+	unsigned long sweeps = 0, phase_sweeps = 0, guess_sweeps = 0, guess_limit = 0;
+	Real low_obj = initial_value(ma, low, max);
+	Real up_obj = initial_value(ma, up, max);
+	while (up_obj - low_obj > epsilon) {
+		bool with_upper = verified || guessing;
+		bool up_increased = false, up_decreased = false;
+		Real low_change = 0;
+		for (unsigned long unit = 0; unit < num_units; unit++) {
+			unsigned long u_start = unit_starts[unit];
+			unsigned long u_end = unit_starts[unit + 1];
+			bool any = false;
+			Real best_low = 0, best_up = 0;
+			for (unsigned long k = u_start; k < u_end; k++) {
+				unsigned long state_nr = unit_states[k];
+				for (unsigned long choice_nr = row_starts[state_nr]; choice_nr < row_starts[state_nr + 1]; choice_nr++) {
+					// staying in an end component is no choice of its own
+					if (internal[choice_nr])
+						continue;
+					Real l = cost[choice_nr], h = cost[choice_nr];
+					unsigned long i_start = choice_starts[choice_nr];
+					unsigned long i_end = choice_starts[choice_nr + 1];
+					for (unsigned long i = i_start; i < i_end; i++)
+						l += branching[i] * low[cols[i]];
+					if (with_upper) {
+						for (unsigned long i = i_start; i < i_end; i++)
+							h += branching[i] * up[cols[i]];
+					}
+					if (!any) {
+						best_low = l;
+						best_up = h;
+						any = true;
+					} else if (max) {
+						if (l > best_low)
+							best_low = l;
+						if (h > best_up)
+							best_up = h;
+					} else {
+						if (l < best_low)
+							best_low = l;
+						if (h < best_up)
+							best_up = h;
+					}
+				}
+			}
+			if (!any)
+				best_low = best_up = reachability ? 0 : infinity;
+			for (unsigned long k = u_start; k < u_end; k++) {
+				unsigned long state_nr = unit_states[k];
+				if (best_low > low[state_nr]) {
+					if (best_low - low[state_nr] > low_change)
+						low_change = best_low - low[state_nr];
+					low[state_nr] = best_low;
+				}
+				if (verified) {
+					if (best_up < up[state_nr]) {
+						up[state_nr] = best_up;
+						up_decreased = true;
+					}
+				} else if (guessing) {
+					if (best_up > up[state_nr])
+						up_increased = true;
+					up[state_nr] = best_up;
+				}
+			}
+		}
+		sweeps++;
+		phase_sweeps++;
+
+		if (!verified) {
+			if (guessing) {
+				// a sweep which does not increase the guess proves it an upper bound
+				if (!up_increased) {
+					verified = true;
+				} else if (++guess_sweeps >= guess_limit) {
+					guessing = false;
+					delta /= 2;
+					phase_sweeps = 0;
+				}
+			} else if (low_change < delta) {
+				for (unsigned long k = 0; k < unit_states.size(); k++) {
+					unsigned long state_nr = unit_states[k];
+					up[state_nr] = low[state_nr] + epsilon / 2;
+				}
+				guessing = true;
+				guess_sweeps = 0;
+				guess_limit = phase_sweeps > MIN_GUESS_SWEEPS ? phase_sweeps : MIN_GUESS_SWEEPS;
+			}
+		}
+		low_obj = initial_value(ma, low, max);
+		if (verified) {
+			up_obj = initial_value(ma, up, max);
+			if (low_change == 0 && !up_decreased && up_obj - low_obj > epsilon) {
+				printf(COLOR_YELLOW "WARNING: The bounds do not get closer than %g.\n" COLOR_END, up_obj - low_obj);
+				break;
+			}
+		}
+	}
+	printf("sweeps: %lu\n", sweeps);
+	free(internal);
+
+	*lower = low_obj;
+	*upper = up_obj;
+	if (low_obj >= infinity)
+		return infinity;
+	return (low_obj + up_obj) / 2;
+}
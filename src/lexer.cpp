@@ -0,0 +1,245 @@
+/**
+* IMCA is a analyzing tool for unbounded reachability probabilities, expected-
+* time, and long-run averages for Interactive Markov Chains and Markov Automata.
+* Copyright (C) RWTH Aachen, 2012
+*				UTwente, 2013
+* 	Author: Dennis Guck
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*
+* Source description:
+*	Memory-mapped lexer for model files
+*/
+
+#include "lexer.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <string>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+/* powers of ten that are exact in double precision */
+static const double exact_powers_of_ten[] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+/* largest integer such that all smaller integers are exact in double precision */
+#define MAX_EXACT_MANTISSA 9007199254740992ULL
+
+/**
+* Maps file @a filename into memory. If the file can not be mapped, e.g. if
+* it is a pipe, it is read into memory instead.
+*
+* @param lx the lexer
+* @param filename the file
+* @return false if the file could not be opened or read
+*/
+bool Lexer_open(Lexer *lx, const char *filename)
+{
+	struct stat info;
+	int fd = open(filename, O_RDONLY);
+
+	lx->begin = NULL;
+	lx->end = NULL;
+	lx->pos = NULL;
+	lx->line_no = 1;
+	lx->mapped = false;
+	if (fd < 0)
+		return false;
+	if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode)) {
+		if (info.st_size == 0) {
+			close(fd);
+			return true;
+		}
+		void *data = mmap(NULL, (size_t) info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (data != MAP_FAILED) {
+#ifdef MADV_SEQUENTIAL
+			madvise(data, (size_t) info.st_size, MADV_SEQUENTIAL);
+#endif
+			lx->begin = (const char *) data;
+			lx->end = lx->begin + info.st_size;
+			lx->pos = lx->begin;
+			lx->mapped = true;
+			close(fd);
+			return true;
+		}
+	}
+
+	/* fall back to reading the whole file */
+	size_t size = 0;
+	size_t capacity = 1 << 16;
+	char *data = (char *) malloc(capacity);
+	while (data != NULL) {
+		ssize_t n = read(fd, data + size, capacity - size);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n < 0) {
+			/* a failed read must not look like a truncated model */
+			fprintf(stderr, "Reading file \"%s\" failed: %s\n", filename, strerror(errno));
+			free(data);
+			data = NULL;
+			break;
+		}
+		if (n == 0)
+			break;
+		size += n;
+		if (size == capacity) {
+			capacity *= 2;
+			char *tmp = (char *) realloc(data, capacity);
+			if (tmp == NULL)
+				free(data);
+			data = tmp;
+		}
+	}
+	close(fd);
+	if (data == NULL)
+		return false;
+	lx->begin = data;
+	lx->end = data + size;
+	lx->pos = lx->begin;
+	return true;
+}
+
+/**
+* Unmaps the file of the lexer.
+*
+* @param lx the lexer
+*/
+void Lexer_close(Lexer *lx)
+{
+	if (lx->mapped)
+		munmap((void *) lx->begin, lx->end - lx->begin);
+	else
+		free((void *) lx->begin);
+	lx->begin = NULL;
+	lx->end = NULL;
+	lx->pos = NULL;
+	lx->mapped = false;
+}
+
+/**
+* Reads a real number at the current position. Numbers whose digits fit into
+* the 53 bit mantissa and with a small exponent are converted directly, which
+* gives the correctly rounded result. All other numbers are converted by
+* strtod.
+*
+* @param lx the lexer
+* @param value the number
+* @return false if there is no number
+*/
+bool lexer_real(Lexer *lx, Real *value)
+{
+	lexer_skip_blanks(lx);
+	const char *start = lx->pos;
+	const char *end = lx->end;
+	const char *pos = start;
+	unsigned long long mantissa = 0;
+	int digits = 0;
+	int exponent = 0;
+	bool negative = false;
+	bool has_digits = false;
+	bool exact = true;
+
+	if (pos < end && (*pos == '-' || *pos == '+')) {
+		negative = (*pos == '-');
+		pos++;
+	}
+	for (; pos < end && *pos >= '0' && *pos <= '9'; pos++) {
+		has_digits = true;
+		if (digits < 19) {
+			mantissa = mantissa * 10 + (*pos - '0');
+			if (mantissa != 0)
+				digits++;
+		} else {
+			exact = false;
+		}
+	}
+	if (pos < end && *pos == '.') {
+		pos++;
+		for (; pos < end && *pos >= '0' && *pos <= '9'; pos++) {
+			has_digits = true;
+			if (digits < 19) {
+				mantissa = mantissa * 10 + (*pos - '0');
+				if (mantissa != 0)
+					digits++;
+				exponent--;
+			} else {
+				exact = false;
+			}
+		}
+	}
+	if (!has_digits)
+		return false;
+	if (pos < end && (*pos == 'e' || *pos == 'E')) {
+		const char *exp_pos = pos + 1;
+		bool exp_negative = false;
+		int exp_value = 0;
+		if (exp_pos < end && (*exp_pos == '-' || *exp_pos == '+')) {
+			exp_negative = (*exp_pos == '-');
+			exp_pos++;
+		}
+		if (exp_pos < end && *exp_pos >= '0' && *exp_pos <= '9') {
+			for (; exp_pos < end && *exp_pos >= '0' && *exp_pos <= '9'; exp_pos++) {
+				if (exp_value < 10000)
+					exp_value = exp_value * 10 + (*exp_pos - '0');
+			}
+			exponent += exp_negative ? -exp_value : exp_value;
+			pos = exp_pos;
+		}
+	}
+	lx->pos = pos;
+
+	if (exact && mantissa <= MAX_EXACT_MANTISSA && exponent >= -22 && exponent <= 22) {
+		double result = (double) mantissa;
+		if (exponent < 0)
+			result /= exact_powers_of_ten[-exponent];
+		else
+			result *= exact_powers_of_ten[exponent];
+		*value = negative ? -result : result;
+	} else {
+		string number(start, pos - start);
+		*value = strtod(number.c_str(), NULL);
+	}
+	return true;
+}
+
+/**
+* Reads a real number with an optional denominator, i.e. "a" or "a/b".
+*
+* @param lx the lexer
+* @param value the number a/b
+* @return false if there is no number
+*/
+bool lexer_fraction(Lexer *lx, Real *value)
+{
+	Real denominator;
+	if (!lexer_real(lx, value))
+		return false;
+	if (lx->pos < lx->end && *lx->pos == '/') {
+		lx->pos++;
+		if (!lexer_real(lx, &denominator))
+			return false;
+		*value /= denominator;
+	}
+	return true;
+}
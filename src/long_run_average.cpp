@@ -156,12 +156,12 @@ static void set_constraints_lra(SoPlex& lp_model, SparseMatrix *ma, bool max, ve
 	unsigned long states = ma->n + 1;
 	bool *goals = ma->goals;
 	//map<unsigned long,string> states_nr = ma->states_nr;
-	unsigned long *row_starts = (unsigned long *) ma->row_counts;
-	unsigned long *rate_starts = (unsigned long *) ma->rate_counts;
-	unsigned long *choice_starts = (unsigned long *) ma->choice_counts;
-	Real *non_zeros = ma->non_zeros;
-	Real *exit_rates = ma->exit_rates;
-	unsigned long *cols = ma->cols;
+	SparseMatrix_prepare(ma);
+	sparse_index *row_starts = ma->row_starts;
+	sparse_index *choice_starts = ma->choice_starts;
+	sparse_index *cols = ma->cols;
+	Real *branching = ma->branching;
+	Real *state_rates = ma->state_rates;
 	Real prob;
 	Real rate;
 	int m=0; // greater equal 0
@@ -185,14 +185,8 @@ static void set_constraints_lra(SoPlex& lp_model, SparseMatrix *ma, bool max, ve
 				unsigned long i_end = choice_starts[choice_nr + 1];
 				for (i = i_start; i < i_end; i++) {
 					if(mec[cols[i]]) {
-						prob=non_zeros[i];
-						rate=0;
-						unsigned long r_start = rate_starts[state_nr];
-						unsigned long r_end = rate_starts[state_nr + 1];
-						for (unsigned long j = r_start; j < r_end; j++) {
-							prob /= exit_rates[j];
-							rate = -1/exit_rates[j];
-						}
+						prob=branching[i];
+						rate=(state_rates[state_nr] > 0) ? -1/state_rates[state_nr] : 0;
 						//dbg_printf("%s - %lf -> %s\n",(states_nr.find(state_nr)->second).c_str(),prob,(states_nr.find(cols[i])->second).c_str());
 						if(state_nr==cols[i]) {
 							loop=true;
@@ -208,12 +202,7 @@ static void set_constraints_lra(SoPlex& lp_model, SparseMatrix *ma, bool max, ve
 				if(!bad) {
 					if(!loop)
 						row.add(state_nr,-1.0);
-					rate=0;
-					unsigned long r_start = rate_starts[state_nr];
-					unsigned long r_end = rate_starts[state_nr + 1];
-					for (unsigned long j = r_start; j < r_end; j++) {
-						rate = -1/exit_rates[j];
-					}
+					rate=(state_rates[state_nr] > 0) ? -1/state_rates[state_nr] : 0;
 					if(rate < 0)
 						row.add(ma->n,rate);
 					if(goals[state_nr]) {
@@ -242,12 +231,12 @@ static void set_constraints_ssp(SoPlex& lp_model, SparseMatrix *ma,SparseMatrixM
 	unsigned long choice_nr;
 	unsigned long states = ma->n + 1;
 	//map<unsigned long,string> states_nr = ma->states_nr;
-	unsigned long *row_starts = (unsigned long *) ma->row_counts;
-	unsigned long *rate_starts = (unsigned long *) ma->rate_counts;
-	unsigned long *choice_starts = (unsigned long *) ma->choice_counts;
-	Real *non_zeros = ma->non_zeros;
-	Real *exit_rates = ma->exit_rates;
-	unsigned long *cols = ma->cols;
+	SparseMatrix_prepare(ma);
+	sparse_index *row_starts = ma->row_starts;
+	sparse_index *choice_starts = ma->choice_starts;
+	sparse_index *cols = ma->cols;
+	Real *branching = ma->branching;
+	Real *state_rates = ma->state_rates;
 	Real prob;
 	Real rate;
 	Real goal;
@@ -271,14 +260,8 @@ static void set_constraints_ssp(SoPlex& lp_model, SparseMatrix *ma,SparseMatrixM
 				unsigned long i_start = choice_starts[choice_nr];
 				unsigned long i_end = choice_starts[choice_nr + 1];
 				for (i = i_start; i < i_end; i++) {
-					prob=non_zeros[i];
-					rate=0;
-					unsigned long r_start = rate_starts[state_nr];
-					unsigned long r_end = rate_starts[state_nr + 1];
-					for (unsigned long j = r_start; j < r_end; j++) {
-						prob /= exit_rates[j];
-						rate = -1/exit_rates[j];
-					}
+					prob=branching[i];
+					rate=(state_rates[state_nr] > 0) ? -1/state_rates[state_nr] : 0;
 					//printf("%s - %lf -> %s\n",(states_nr.find(state_nr)->second).c_str(),prob,(states_nr.find(cols[i])->second).c_str());
 					if(state_nr==cols[i]) {
 						loop=true;
@@ -325,14 +308,8 @@ static void set_constraints_ssp(SoPlex& lp_model, SparseMatrix *ma,SparseMatrixM
 				unsigned long i_start = choice_starts[choice_nr];
 				unsigned long i_end = choice_starts[choice_nr + 1];
 				for (i = i_start; i < i_end; i++) {
-					prob=non_zeros[i];
-					rate=0;
-					unsigned long r_start = rate_starts[state_nr];
-					unsigned long r_end = rate_starts[state_nr + 1];
-					for (unsigned long j = r_start; j < r_end; j++) {
-						prob /= exit_rates[j];
-						rate = -1/exit_rates[j];
-					}
+					prob=branching[i];
+					rate=(state_rates[state_nr] > 0) ? -1/state_rates[state_nr] : 0;
 					//printf("%s - %lf -> %s\n",(states_nr.find(state_nr)->second).c_str(),prob,(states_nr.find(cols[i])->second).c_str());
 					if(state_nr==cols[i]) {
 						loop=true;
@@ -389,15 +366,9 @@ static void set_constraints_ssp(SoPlex& lp_model, SparseMatrix *ma,SparseMatrixM
 					for (i = i_start; i < i_end; i++) {
 						if(mecNr[cols[i]]!=m_nr+1) {
 							bad=true;
-							prob=non_zeros[i];
-							rate=0;
-							unsigned long r_start = rate_starts[state_nr];
-							unsigned long r_end = rate_starts[state_nr + 1];
-							for (unsigned long j = r_start; j < r_end; j++) {
-								prob /= exit_rates[j];
-								rate = -1/exit_rates[j];
-							}
-							//printf("%s - %lf -> %s\n",(ma->states_nr.find(state_nr)->second).c_str(),prob,(ma->states_nr.find(cols[i])->second).c_str());
+							prob=branching[i];
+							rate=(state_rates[state_nr] > 0) ? -1/state_rates[state_nr] : 0;
+							//printf("%s - %lf -> %s\n",state_name(ma->names, state_nr),prob,state_name(ma->names, cols[i]));
 							isMec[mecNr[cols[i]]-1]=true;
 							mec_prob[mecNr[cols[i]]-1] += prob;
 							//row.add(mecNr[cols[i]],prob);
@@ -443,8 +414,8 @@ Real compute_stochastic_shortest_path_problem(SparseMatrix *ma, SparseMatrixMEC
 	vector<Real> mecNr(ma->n,0);
 	map<unsigned long,unsigned long> ssp_nr;
 	
-	unsigned long *row_starts = (unsigned long *) mecs->row_counts;
-	unsigned long *cols = mecs->cols;
+	sparse_index *row_starts = mecs->row_starts;
+	sparse_index *cols = mecs->cols;
 	
 	for(unsigned long mec_nr=0; mec_nr < mecs->n; mec_nr++) {
 		unsigned long mec_start = row_starts[mec_nr];
@@ -462,7 +433,7 @@ Real compute_stochastic_shortest_path_problem(SparseMatrix *ma, SparseMatrixMEC
 	for (state_nr = 0; state_nr < ma->n; state_nr++) {
 		bad[state_nr]=true;
 		if(initials[state_nr])
-			dbg_printf("test %s\n",(ma->states_nr.find(state_nr)->second).c_str());
+			dbg_printf("test %s\n",state_name(ma->names, state_nr));
 		if(initials[state_nr] && mec[state_nr]){
 			free(bad);
 			return lra[state_nr];
@@ -571,12 +542,12 @@ Real compute_stochastic_shortest_path_problem(SparseMatrix *ma, SparseMatrixMEC
 * @param u result vector
 */
 void compute_markovian_vector_lra(SparseMatrix* ma, vector<Real>& v, const vector<Real> &u, bool* locks){
-	unsigned long *row_starts = (unsigned long *) ma->row_counts;
-	unsigned long *choice_starts = (unsigned long *) ma->choice_counts;
-	unsigned long *rate_starts = (unsigned long *) ma->rate_counts;
-	unsigned long *cols = ma->cols;
-	Real *non_zeros = ma->non_zeros;
-	Real *exit_rates = ma->exit_rates;
+	SparseMatrix_prepare(ma);
+	sparse_index *row_starts = ma->row_starts;
+	sparse_index *choice_starts = ma->choice_starts;
+	sparse_index *cols = ma->cols;
+	Real *branching = ma->branching;
+	Real *state_rates = ma->state_rates;
 	bool *goals = ma->goals;
 	const unsigned long k = ma->n +1;
 	
@@ -595,12 +566,7 @@ void compute_markovian_vector_lra(SparseMatrix* ma, vector<Real>& v, const vecto
 				// Add up all outgoing rates of the distribution
 				unsigned long i_start = choice_starts[choice_nr];
 				unsigned long i_end = choice_starts[choice_nr + 1];
-				Real exit_rate;
-				unsigned long r_start = rate_starts[state_nr];
-				unsigned long r_end = rate_starts[state_nr + 1];
-				for (unsigned long j = r_start; j < r_end; j++) {
-					exit_rate = ma->exit_rates[j];
-				}
+				Real exit_rate = state_rates[state_nr];
 				if(goals[state_nr]) {
 					v[state_nr]=1.0/exit_rate;
 					//tmp = 1.0;
@@ -609,7 +575,7 @@ void compute_markovian_vector_lra(SparseMatrix* ma, vector<Real>& v, const vecto
 					//tmp = 0.0;
 				}
 				for (unsigned long i = i_start; i < i_end; i++) {
-					v[state_nr] += (non_zeros[i]/exit_rate) * u[cols[i]];
+					v[state_nr] += branching[i] * u[cols[i]];
 					//tmp += ((non_zeros[i]/exit_rate) * u[cols[i]]) * exit_rate;
 				}
 				v[state_nr] -= (1.0/exit_rate) * u[k];
@@ -634,15 +600,10 @@ void compute_markovian_vector_lra(SparseMatrix* ma, vector<Real>& v, const vecto
 				// Add up all outgoing rates of the distribution
 				unsigned long i_start = choice_starts[choice_nr];
 				unsigned long i_end = choice_starts[choice_nr + 1];
-				Real exit_rate;
-				unsigned long r_start = rate_starts[state_nr];
-				unsigned long r_end = rate_starts[state_nr + 1];
-				for (unsigned long j = r_start; j < r_end; j++) {
-					exit_rate = ma->exit_rates[j];
-				}
+				Real exit_rate = state_rates[state_nr];
 				tmp = 0.0;
 				for (unsigned long i = i_start; i < i_end; i++) {
-					tmp += ((non_zeros[i]/exit_rate) * v[cols[i]]);
+					tmp += (branching[i] * v[cols[i]]);
 				}
 				tmp *= exit_rate;
 				if(goals[state_nr]) {
@@ -672,9 +633,9 @@ void compute_probabilistic_vector_lra(SparseMatrix* ma, vector<Real>& v, vector<
 
 	const Real precision = 1e-7;
 	unsigned long statecount = ma-> n;
-	unsigned long *row_starts = (unsigned long *) ma->row_counts;
-	unsigned long *choice_starts = (unsigned long *) ma->choice_counts;
-	unsigned long *cols = ma->cols;
+	sparse_index *row_starts = ma->row_starts;
+	sparse_index *choice_starts = ma->choice_starts;
+	sparse_index *cols = ma->cols;
 	Real* non_zeros = ma->non_zeros;
 	const unsigned long k = ma->n+1;
 
@@ -759,7 +720,8 @@ Real long_run_average_value_iteration(SparseMatrix* ma, bool max) {
 	vector<Real> u(num_states+1,0); // Probabilistic vector
 	vector<Real> tmp(num_states+1,0); // tmp vector
 	const unsigned long k = ma->n+1;
-	unsigned long *rate_starts = (unsigned long *) ma->rate_counts;
+	SparseMatrix_prepare(ma);
+	Real *state_rates = ma->state_rates;
 	
 	// initialize k (LRA)
 	if(max)
@@ -769,12 +731,7 @@ Real long_run_average_value_iteration(SparseMatrix* ma, bool max) {
 	// initialize goal states
 	bool *goals = ma->goals;
 	for (unsigned long state_nr = 0; state_nr < num_states; state_nr++) {
-		Real exit_rate;
-		unsigned long r_start = rate_starts[state_nr];
-		unsigned long r_end = rate_starts[state_nr + 1];
-		for (unsigned long j = r_start; j < r_end; j++) {
-			exit_rate = ma->exit_rates[j];
-		}
+		Real exit_rate = state_rates[state_nr];
 		if(goals[state_nr]){
 			if(max)
 				v[state_nr]=0.0;
@@ -825,7 +782,8 @@ Real long_run_average_ssp_value_iteration(SparseMatrix *ma, SparseMatrixMEC *mec
 	vector<Real> u(num_states+1,0); // Probabilistic vector
 	vector<Real> tmp(num_states+1,0); // tmp vector
 	const unsigned long k = ma->n+1;
-	unsigned long *rate_starts = (unsigned long *) ma->rate_counts;
+	SparseMatrix_prepare(ma);
+	Real *state_rates = ma->state_rates;
 	
 	// initialize k (LRA)
 	if(max)
@@ -835,12 +793,7 @@ Real long_run_average_ssp_value_iteration(SparseMatrix *ma, SparseMatrixMEC *mec
 	// initialize goal states
 	bool *goals = ma->goals;
 	for (unsigned long state_nr = 0; state_nr < num_states; state_nr++) {
-		Real exit_rate;
-		unsigned long r_start = rate_starts[state_nr];
-		unsigned long r_end = rate_starts[state_nr + 1];
-		for (unsigned long j = r_start; j < r_end; j++) {
-			exit_rate = ma->exit_rates[j];
-		}
+		Real exit_rate = state_rates[state_nr];
 		if(goals[state_nr]){
 			if(max)
 				v[state_nr]=0.0;
@@ -908,8 +861,8 @@ Real compute_long_run_average(SparseMatrix *ma, bool max) {
 	vector<bool> mec_tmp(ma->n,false);
 	vector<Real> lra_mec(mecs->n);
 	
-	unsigned long *row_starts = (unsigned long *) mecs->row_counts;
-	unsigned long *cols = mecs->cols;
+	sparse_index *row_starts = mecs->row_starts;
+	sparse_index *cols = mecs->cols;
 	
 	
 	/* TODO: Problem with LRA computation for some models! Need to be solved! */
@@ -918,7 +871,7 @@ Real compute_long_run_average(SparseMatrix *ma, bool max) {
 		unsigned long mec_end = row_starts[mec_nr + 1];
 		for(unsigned long state_nr=mec_start; state_nr < mec_end; state_nr++) {
 			mec[cols[state_nr]]=true;
-			//printf("%s\n",(ma->states_nr.find(cols[state_nr])->second).c_str());
+			//printf("%s\n",state_name(ma->names, cols[state_nr]));
 		}
 		SoPlex lp_model;
 		/* first step: build the lp model */
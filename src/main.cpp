@@ -34,6 +34,8 @@
 #include <string.h>
 #include <map>
 #include <string>
+#include <vector>
+#include <unistd.h>
 //#include <popt.h>
 
 
@@ -63,6 +65,15 @@
 #include "long_run_reward.h"
 #include "bounded.h"
 #include "bounded_reward.h"
+#include "model_cache.h"
+#include "serve.h"
+#include "interval_iteration.h"
+#include "topological.h"
+#include "policy_iteration.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 #ifndef __APPLE__
 #include <time.h>
@@ -92,11 +103,26 @@ double begin, end;
 #define TO_STR       "--to"
 #define IMC_STR "-imc"
 #define VAL_STR "-val"
+#define SOUND_STR "-sound"
+#define TOPO_STR "-topo"
+#define PI_STR "-pi"
 #define INTERVAL_STR "-i"
 #define INTERVAL_START_STR "-b"
 #define TIME_POINTS_STR "-Tp"
 #define MEC_STR "-mec"
 #define DOT_STR "-dot"
+#define LOAD_STR "-load"
+#define COMPILE_STR "-compile"
+#define NO_CACHE_STR "-nocache"
+#define SERVE_STR "--serve"
+#define SOCKET_STR "--socket"
+#define BATCH_STR "--batch"
+#define THREADS_STR "-threads"
+#define ADAPTIVE_STR "-adaptive"
+#define OUTPUT_STR "-o"
+#define JSON_STR "-json"
+#define VECTOR_STR "-vector"
+#define INITIALS_STR "-initials"
 
 // Coloured output
 #define COLOR_RED "\x1b[31m" // Color Start
@@ -139,6 +165,9 @@ static bool is_interval_present = false;
 static bool is_interval_start_present = false;
 static bool is_imc = false;
 static bool is_val = false;
+static bool is_sound_present = false;
+static bool is_topo_present = false;
+static bool is_pi_present = false;
 static bool is_mec = false;
 
 static bool is_lower_bound_present = false;
@@ -146,6 +175,15 @@ static bool is_upper_bound_present = false;
 static bool is_error_bound_present = false;
 
 static bool is_dot_present = false;
+static bool is_load_present = false;
+static bool is_compile_present = false;
+static bool is_no_cache_present = false;
+static bool is_serve_present = false;
+static bool is_batch_present = false;
+static bool is_adaptive_present = false;
+static bool is_json_present = false;
+static bool is_vector_present = false;
+static bool is_initials_present = false;
 
 /**
 * Global variables
@@ -157,6 +195,10 @@ static Real ta = 0;						/* default lower bound for time interval ( time-bounded
 static Real tb = 0;						/* default upper bound for time interval ( time-bounded reachability ) */
 static Real interval = 0;			/* The interval step for time-bounded reachability */
 static Real interval_start = 0;			/* The interval step for time-bounded reachability */
+static const char * socket_path = NULL;	/* socket to serve queries on, stdin if NULL */
+static const char * batch_file = NULL;	/* file with the queries of a batch */
+static std::vector<Real> tb_values;		/* all upper bounds given with '-T' */
+static const char * output_file = NULL;	/* file for the results of -tb, stdout if "-" */
 
 using namespace std;
 
@@ -198,8 +240,29 @@ static void print_usage(void) {
 	printf("                          '-e' for error bound '-i' for interval output\n");
 	printf("                          '-i' only available for [0,T]\n");
 	printf("                          '-val for expected-time value iteration\n");
+	printf("                          '-sound' for interval iteration of -ub, -et and -er, which bounds\n");
+	printf("                          the result from below and above up to the error bound '-e'\n");
+	printf("                          '-topo' for value iteration of -ub, -et and -er one strongly\n");
+	printf("                          connected component after another\n");
+	printf("                          '-pi' for policy iteration of -ub, -et and -er\n");
     printf("                          '-mec for maximal end component computation + output\n");
     printf("                          '-dot for .dot export\n");
+	printf("                          '-load' to only load the model and report the loading time\n");
+	printf("                          '-compile' to store the model as '<model file>%s', later runs map it instead of parsing the model\n", MODEL_CACHE_EXT);
+	printf("                          '-nocache' to parse the model even if it was compiled\n");
+	printf("                          '--serve' to keep the model loaded and answer queries like\n");
+	printf("                          'tb max T=10 e=1e-4' read line by line from stdin\n");
+	printf("                          '--socket <path>' to read the queries from a Unix domain socket\n");
+	printf("                          '--batch <file>' to answer the queries of a file, one per line, as CSV\n");
+	printf("                          '-T' may be repeated to answer -tb and -tr for several bounds as CSV\n");
+	printf("                          '-threads <n>' to split the value iteration sweeps among n threads\n");
+	printf("                          '-adaptive' to choose the discretisation step of -tb from an error bound\n");
+	printf("                          computed on the way, only available for [0,T] without '-i'\n");
+	printf("                          '-o <file>' to write the interval output and the result of -tb as CSV\n");
+	printf("                          to a file ('-' for stdout) instead of printing the interval output\n");
+	printf("                          '-json' to write JSON lines instead of CSV\n");
+	printf("                          '-initials' to write the value of each initial state next to the optimum\n");
+	printf("                          '-vector' to write the value of every state for T\n");
 	//printf("                          '-Tp {a,b,c}' for several time points (i XOR Tp)\n");
 	//printf("	<model type>	- define if .ma input is an IMC {-imc} \n");
 }
@@ -240,7 +303,7 @@ static void checkComputation(){
 		exit(EXIT_FAILURE);
 
 	}
-	if(!is_expected_time_present && !is_unbound_present && !is_lra_present && !is_time_bounded_present && !is_expected_reward_present && !is_time_reward_present && !is_mec && !is_lrr_present && !is_dot_present){
+	if(!is_expected_time_present && !is_unbound_present && !is_lra_present && !is_time_bounded_present && !is_expected_reward_present && !is_time_reward_present && !is_mec && !is_lrr_present && !is_dot_present && !is_load_present && !is_compile_present && !is_serve_present && !is_batch_present){
 		printf(COLOR_RED "ERROR: No computation type was set.\n" COLOR_END);
 		print_usage();
 		exit(EXIT_FAILURE);
@@ -352,16 +415,17 @@ static void parseParams(int argc, char *argv[]) {
 				}
 			}
 		}else if( IS_UPPER_BOUND(argv[i]) ){
-			if( is_upper_bound_present ) {
-				printf(COLOR_RED "ERROR: '%s' is repeated.\n" COLOR_END, argv[i]);
-				exit(EXIT_FAILURE);
-			} else if(i+1 >= argc ) {
+			if(i+1 >= argc ) {
 				printf(COLOR_RED "ERROR: No upper bound for time interval specified.\n" COLOR_END);
 				exit(EXIT_FAILURE);
 			} else {
 				char *toEnd;
-				tb=strtod(argv[i+1], &toEnd);
-				if( *toEnd == '\0' && tb > 0) { //TODO adding support of reachability computation for ta = tb = 0
+				Real bound = strtod(argv[i+1], &toEnd);
+				if( *toEnd == '\0' && bound > 0) { //TODO adding support of reachability computation for ta = tb = 0
+					/* several upper bounds are answered as a batch */
+					if( !is_upper_bound_present )
+						tb = bound;
+					tb_values.push_back(bound);
 					is_upper_bound_present = true;
 					i++;
 				}
@@ -454,6 +518,24 @@ static void parseParams(int argc, char *argv[]) {
 			}else{
 				printf(COLOR_YELLOW "WARNING: The option has been noticed before, skipping '%s'.\n" COLOR_END, argv[i]);
 			}
+		}else if( strcmp(argv[i], SOUND_STR) == 0 ){
+			if( !is_sound_present ){
+				is_sound_present = true;
+			}else{
+				printf(COLOR_YELLOW "WARNING: The option has been noticed before, skipping '%s'.\n" COLOR_END, argv[i]);
+			}
+		}else if( strcmp(argv[i], TOPO_STR) == 0 ){
+			if( !is_topo_present ){
+				is_topo_present = true;
+			}else{
+				printf(COLOR_YELLOW "WARNING: The option has been noticed before, skipping '%s'.\n" COLOR_END, argv[i]);
+			}
+		}else if( strcmp(argv[i], PI_STR) == 0 ){
+			if( !is_pi_present ){
+				is_pi_present = true;
+			}else{
+				printf(COLOR_YELLOW "WARNING: The option has been noticed before, skipping '%s'.\n" COLOR_END, argv[i]);
+			}
 		}else if( strcmp(argv[i], MEC_STR) == 0 ){
 			if( !is_mec ){
 				is_mec = true;
@@ -466,24 +548,230 @@ static void parseParams(int argc, char *argv[]) {
             }else{
                 printf(COLOR_YELLOW "WARNING: The option has been noticed before, skipping '%s'.\n" COLOR_END, argv[i]);
             }
+		}else if( strcmp(argv[i], LOAD_STR) == 0 ){
+			if( !is_load_present ){
+				is_load_present = true;
+			}else{
+				printf(COLOR_YELLOW "WARNING: The option has been noticed before, skipping '%s'.\n" COLOR_END, argv[i]);
+			}
+		}else if( strcmp(argv[i], COMPILE_STR) == 0 ){
+			if( !is_compile_present ){
+				is_compile_present = true;
+			}else{
+				printf(COLOR_YELLOW "WARNING: The option has been noticed before, skipping '%s'.\n" COLOR_END, argv[i]);
+			}
+		}else if( strcmp(argv[i], SERVE_STR) == 0 ){
+			if( !is_serve_present ){
+				is_serve_present = true;
+			}else{
+				printf(COLOR_YELLOW "WARNING: The option has been noticed before, skipping '%s'.\n" COLOR_END, argv[i]);
+			}
+		}else if( strcmp(argv[i], SOCKET_STR) == 0 ){
+			if( socket_path != NULL ) {
+				printf(COLOR_RED "ERROR: '%s' is repeated.\n" COLOR_END, argv[i]);
+				exit(EXIT_FAILURE);
+			} else if(i+1 >= argc ) {
+				printf(COLOR_RED "ERROR: No socket specified.\n" COLOR_END);
+				exit(EXIT_FAILURE);
+			} else {
+				is_serve_present = true;
+				socket_path = argv[i+1];
+				i++;
+			}
+		}else if( strcmp(argv[i], BATCH_STR) == 0 ){
+			if( batch_file != NULL ) {
+				printf(COLOR_RED "ERROR: '%s' is repeated.\n" COLOR_END, argv[i]);
+				exit(EXIT_FAILURE);
+			} else if(i+1 >= argc ) {
+				printf(COLOR_RED "ERROR: No batch file specified.\n" COLOR_END);
+				exit(EXIT_FAILURE);
+			} else {
+				is_batch_present = true;
+				batch_file = argv[i+1];
+				i++;
+			}
+		}else if( strcmp(argv[i], NO_CACHE_STR) == 0 ){
+			if( !is_no_cache_present ){
+				is_no_cache_present = true;
+			}else{
+				printf(COLOR_YELLOW "WARNING: The option has been noticed before, skipping '%s'.\n" COLOR_END, argv[i]);
+			}
+		}else if( strcmp(argv[i], ADAPTIVE_STR) == 0 ){
+			if( !is_adaptive_present ){
+				is_adaptive_present = true;
+			}else{
+				printf(COLOR_YELLOW "WARNING: The option has been noticed before, skipping '%s'.\n" COLOR_END, argv[i]);
+			}
+		}else if( strcmp(argv[i], OUTPUT_STR) == 0 ){
+			if( output_file != NULL ) {
+				printf(COLOR_RED "ERROR: '%s' is repeated.\n" COLOR_END, argv[i]);
+				exit(EXIT_FAILURE);
+			} else if(i+1 >= argc ) {
+				printf(COLOR_RED "ERROR: No output file specified.\n" COLOR_END);
+				exit(EXIT_FAILURE);
+			} else {
+				output_file = argv[i+1];
+				i++;
+			}
+		}else if( strcmp(argv[i], JSON_STR) == 0 ){
+			if( !is_json_present ){
+				is_json_present = true;
+			}else{
+				printf(COLOR_YELLOW "WARNING: The option has been noticed before, skipping '%s'.\n" COLOR_END, argv[i]);
+			}
+		}else if( strcmp(argv[i], VECTOR_STR) == 0 ){
+			if( !is_vector_present ){
+				is_vector_present = true;
+			}else{
+				printf(COLOR_YELLOW "WARNING: The option has been noticed before, skipping '%s'.\n" COLOR_END, argv[i]);
+			}
+		}else if( strcmp(argv[i], INITIALS_STR) == 0 ){
+			if( !is_initials_present ){
+				is_initials_present = true;
+			}else{
+				printf(COLOR_YELLOW "WARNING: The option has been noticed before, skipping '%s'.\n" COLOR_END, argv[i]);
+			}
+		}else if( strcmp(argv[i], THREADS_STR) == 0 ){
+			if(i+1 >= argc ) {
+				printf(COLOR_RED "ERROR: No number of threads specified.\n" COLOR_END);
+				exit(EXIT_FAILURE);
+			} else {
+				char *toEnd;
+				long threads = strtol(argv[i+1], &toEnd, 10);
+				if( *toEnd == '\0' && threads > 0 ) {
+#ifdef _OPENMP
+					omp_set_num_threads(threads);
+#else
+					printf(COLOR_YELLOW "WARNING: IMCA was built without OpenMP, skipping '%s'.\n" COLOR_END, argv[i]);
+#endif
+					i++;
+				}
+				else {
+					printf(COLOR_RED "ERROR: The specified number of threads ('%s') is invalid. After '%s' must be an integer greater than zero.\n" COLOR_END, argv[i+1], argv[i]);
+					exit(EXIT_FAILURE);
+				}
+			}
         }
 	}
 
+	if( tb_values.size() > 1 )
+		is_batch_present = true;
+	if( is_batch_present && is_interval_present ) {
+		printf(COLOR_RED "ERROR: '%s' is not available for batches.\n" COLOR_END, INTERVAL_STR);
+		exit(EXIT_FAILURE);
+	}
+	if( is_batch_present && is_adaptive_present ) {
+		printf(COLOR_RED "ERROR: '%s' is not available for batches.\n" COLOR_END, ADAPTIVE_STR);
+		exit(EXIT_FAILURE);
+	}
+	if( (is_batch_present || is_serve_present) && (output_file != NULL || is_vector_present || is_initials_present) ) {
+		printf(COLOR_RED "ERROR: '%s', '%s' and '%s' are not available for batches and '%s'.\n" COLOR_END, OUTPUT_STR, VECTOR_STR, INITIALS_STR, SERVE_STR);
+		exit(EXIT_FAILURE);
+	}
+	if( is_json_present && output_file == NULL && !is_vector_present && !is_initials_present ) {
+		printf(COLOR_YELLOW "WARNING: '%s' is only used with '%s', '%s' or '%s', skipping it.\n" COLOR_END, JSON_STR, OUTPUT_STR, VECTOR_STR, INITIALS_STR);
+	}
+
 	checkComputation();
 }
 
 /**
-* Load the .ma file
+* @return true if the arguments ask for a batch, i.e. '--batch' or several '-T'
+*/
+static bool isBatch(int argc, char *argv[]) {
+	int upper_bounds = 0;
+
+	for(int i = 1; i < argc; i++) {
+		if( strcmp(argv[i], BATCH_STR) == 0 )
+			return true;
+		if( IS_UPPER_BOUND(argv[i]) )
+			upper_bounds++;
+	}
+	return upper_bounds > 1;
+}
+
+/**
+* Appends a query for @a analysis with the options given on the command line.
+*/
+static void addQuery(vector<Query> &queries, const char *analysis, Real bound) {
+	Query q;
+
+	query_init(&q, analysis);
+	q.max = is_max_present;
+	q.min = is_min_present;
+	q.val = is_val;
+	q.sound = is_sound_present;
+	q.topo = is_topo_present;
+	q.pi = is_pi_present;
+	q.ta = ta;
+	q.tb = bound;
+	q.has_tb = bound > 0;
+	q.epsilon = epsilon;
+	queries.push_back(q);
+}
+
+/**
+* Builds the queries of a batch from the computations given on the command
+* line, time-bounded computations once for every upper bound.
+*/
+static void addQueries(vector<Query> &queries) {
+	if(is_unbound_present)
+		addQuery(queries, "ub", 0);
+	if(is_expected_time_present)
+		addQuery(queries, "et", 0);
+	if(is_expected_reward_present)
+		addQuery(queries, "er", 0);
+	if(is_lra_present)
+		addQuery(queries, "lra", 0);
+	if(is_lrr_present)
+		addQuery(queries, "lrr", 0);
+	for(unsigned long k = 0; k < tb_values.size(); k++) {
+		if( ta >= tb_values[k] ) {
+			printf(COLOR_RED "ERROR: The lower bound %g is not below the upper bound %g.\n" COLOR_END, ta, tb_values[k]);
+			exit(EXIT_FAILURE);
+		}
+		if(is_time_bounded_present)
+			addQuery(queries, "tb", tb_values[k]);
+		if(is_time_reward_present)
+			addQuery(queries, "tr", tb_values[k]);
+	}
+}
+
+/**
+* Load the .ma file, or its compiled model if it is up to date
 */
 static void loadMA(const char *filename) {
 	if(is_ma_present || is_mrm_present) {
+		string cache_file = string(filename) + MODEL_CACHE_EXT;
 		printf("Loading the '%s' file, please wait.\n", filename);
-		if(is_mrm_present)
+		#ifndef __APPLE__
+		clock_gettime(CLOCK_REALTIME, &tp);
+		begin = 1e9*tp.tv_sec + tp.tv_nsec;
+		#endif
+		if(!is_no_cache_present && !is_compile_present)
+			ma = read_model_cache(filename,cache_file.c_str(),is_mrm_present);
+		if(ma != NULL)
+			printf("Using the compiled model '%s'.\n", cache_file.c_str());
+		else if(is_mrm_present)
 		ma = read_MA_SparseMatrix_file(filename,is_mrm_present);
 		if(ma == NULL){
 			printf(COLOR_RED "ERROR: The '%s' file '%s' was not found or is incorrect!\n" COLOR_END,MA_FILE_EXT, filename);
 			exit(EXIT_FAILURE);
 		}
+		#ifndef __APPLE__
+		clock_gettime(CLOCK_REALTIME, &tp);
+		end = 1e9*tp.tv_sec + tp.tv_nsec;
+		printf("Loading Time: %f seconds\n", (end-begin)*1e-9);
+		#else
+		printf("Loading Time: ??? seconds\n");
+		#endif
+		if(is_compile_present) {
+			if(!write_model_cache(ma,filename,cache_file.c_str(),is_mrm_present)){
+				printf(COLOR_RED "ERROR: The compiled model '%s' could not be written!\n" COLOR_END, cache_file.c_str());
+				exit(EXIT_FAILURE);
+			}
+			printf("Compiled model written to '%s'.\n", cache_file.c_str());
+		}
 	}
 }
 
@@ -502,12 +790,27 @@ int main(int argc, char* argv[]) {
 	sp1 = mallinfo().uordblks;
 	#endif
 
+	/// batches write CSV to stdout, everything else goes to stderr
+	FILE *batch_out = stdout;
+	if(isBatch(argc, argv)) {
+		batch_out = fdopen(dup(STDOUT_FILENO), "w");
+		dup2(STDERR_FILENO, STDOUT_FILENO);
+	}
+
 	/// print the MAA intro
 	print_intro();
 
 	/// Parse and validate the input parameters
 	parseParams(argc, argv);
 
+	/// read the queries of a batch before the model is loaded
+	vector<Query> queries;
+	if(is_batch_present) {
+		if(batch_file != NULL && !read_query_file(batch_file, queries))
+			exit(EXIT_FAILURE);
+		addQueries(queries);
+	}
+
 	/// load the MA from file
 	loadMA(ma_file);
 
@@ -530,7 +833,33 @@ int main(int argc, char* argv[]) {
 	printf("The occupied space is ??? Bytes.\n\n");
 	#endif
 
+	if(is_serve_present){
+		int ret = serve_queries(ma, is_mrm_present, is_imc, socket_path);
+		SparseMatrix_free(ma);
+		delete(ma);
+		return ret;
+	}
+
+	if(is_batch_present){
+		int ret = run_batch(ma, is_mrm_present, is_imc, queries, batch_out);
+		SparseMatrix_free(ma);
+		delete(ma);
+		return ret;
+	}
+
 	Real tmp;
+	Real lower, upper;
+
+	/// the results of -tb go to a sink if they were asked for, the console if no file is given
+	ResultSink *sink = NULL;
+	if(is_time_bounded_present && (output_file != NULL || is_vector_present || is_initials_present)) {
+		const char *path = (output_file != NULL) ? output_file : "-";
+		sink = ResultSink_new(path, is_json_present, is_initials_present, is_vector_present);
+		if(sink == NULL) {
+			printf(COLOR_RED "ERROR: The output file '%s' cannot be opened.\n" COLOR_END, path);
+			exit(EXIT_FAILURE);
+		}
+	}
 
 	if(is_unbound_present){
 		if(is_max_present){
@@ -539,7 +868,17 @@ int main(int argc, char* argv[]) {
 			begin = 1e9*tp.tv_sec + tp.tv_nsec;
 			#endif
 			printf("\nCompute maximal unbounded reachability, please wait.\n");
-			if(!is_val){
+			if(is_sound_present){
+				tmp=interval_iteration(ma,OBJECTIVE_REACHABILITY,true,epsilon,&lower,&upper);
+				printf("Maximal unbounded reachability: %.10g\n", tmp);
+				printf("Interval: [%.10g,%.10g]\n", lower, upper);
+			}else if(is_topo_present){
+				tmp=topological_value_iteration(ma,OBJECTIVE_REACHABILITY,true);
+				printf("Maximal unbounded reachability: %.10g\n", tmp);
+			}else if(is_pi_present){
+				tmp=policy_iteration(ma,OBJECTIVE_REACHABILITY,true);
+				printf("Maximal unbounded reachability: %.10g\n", tmp);
+			}else if(!is_val){
 				tmp = compute_unbounded_reachability(ma,true);
 				printf("Maximal unbounded reachability: %.10g\n", tmp);
 			}else {
@@ -560,7 +899,17 @@ int main(int argc, char* argv[]) {
 			begin = 1e9*tp.tv_sec + tp.tv_nsec;
 			#endif
 			printf("\nCompute minimal unbounded reachability, please wait.\n");
-			if(!is_val){
+			if(is_sound_present){
+				tmp=interval_iteration(ma,OBJECTIVE_REACHABILITY,false,epsilon,&lower,&upper);
+				printf("Minimal unbounded reachability: %.10g\n", tmp);
+				printf("Interval: [%.10g,%.10g]\n", lower, upper);
+			}else if(is_topo_present){
+				tmp=topological_value_iteration(ma,OBJECTIVE_REACHABILITY,false);
+				printf("Minimal unbounded reachability: %.10g\n", tmp);
+			}else if(is_pi_present){
+				tmp=policy_iteration(ma,OBJECTIVE_REACHABILITY,false);
+				printf("Minimal unbounded reachability: %.10g\n", tmp);
+			}else if(!is_val){
 				tmp = compute_unbounded_reachability(ma,false);
 				printf("Minimal unbounded reachability: %.10g\n", tmp);
 			}else {
@@ -583,7 +932,17 @@ int main(int argc, char* argv[]) {
 			begin = 1e9*tp.tv_sec + tp.tv_nsec;
 			#endif
 			printf("\nCompute maximal expected time, please wait.\n");
-			if(!is_val){
+			if(is_sound_present){
+				tmp=interval_iteration(ma,OBJECTIVE_EXPECTED_TIME,true,epsilon,&lower,&upper);
+				printf("Maximal expected time: %.10g\n", tmp);
+				printf("Interval: [%.10g,%.10g]\n", lower, upper);
+			}else if(is_topo_present){
+				tmp=topological_value_iteration(ma,OBJECTIVE_EXPECTED_TIME,true);
+				printf("Maximal expected time value iteration: %.10g\n", tmp);
+			}else if(is_pi_present){
+				tmp=policy_iteration(ma,OBJECTIVE_EXPECTED_TIME,true);
+				printf("Maximal expected time: %.10g\n", tmp);
+			}else if(!is_val){
 				tmp = compute_expected_time(ma,true);
 				printf("Maximal expected time: %.10g\n", tmp);
 			} else {
@@ -604,7 +963,17 @@ int main(int argc, char* argv[]) {
 			begin = 1e9*tp.tv_sec + tp.tv_nsec;
 			#endif
 			printf("\nCompute minimal expected time, please wait.\n");
-			if(!is_val) {
+			if(is_sound_present){
+				tmp=interval_iteration(ma,OBJECTIVE_EXPECTED_TIME,false,epsilon,&lower,&upper);
+				printf("Minimal expected time: %.10g\n", tmp);
+				printf("Interval: [%.10g,%.10g]\n", lower, upper);
+			}else if(is_topo_present){
+				tmp=topological_value_iteration(ma,OBJECTIVE_EXPECTED_TIME,false);
+				printf("Minimal expected time value iteration: %.10g\n", tmp);
+			}else if(is_pi_present){
+				tmp=policy_iteration(ma,OBJECTIVE_EXPECTED_TIME,false);
+				printf("Minimal expected time: %.10g\n", tmp);
+			}else if(!is_val) {
 				tmp = compute_expected_time(ma,false);
 				printf("Minimal expected time: %.10g\n\n", tmp);
 			} else {
@@ -627,8 +996,20 @@ int main(int argc, char* argv[]) {
 			begin = 1e9*tp.tv_sec + tp.tv_nsec;
 			#endif
 			printf("\nCompute maximal expected reward, please wait.\n");
-			tmp=expected_reward_value_iteration(ma,true);
-			printf("Maximal expected reward: %.10g\n", tmp);
+			if(is_sound_present){
+				tmp=interval_iteration(ma,OBJECTIVE_EXPECTED_REWARD,true,epsilon,&lower,&upper);
+				printf("Maximal expected reward: %.10g\n", tmp);
+				printf("Interval: [%.10g,%.10g]\n", lower, upper);
+			}else if(is_topo_present){
+				tmp=topological_value_iteration(ma,OBJECTIVE_EXPECTED_REWARD,true);
+				printf("Maximal expected reward: %.10g\n", tmp);
+			}else if(is_pi_present){
+				tmp=policy_iteration(ma,OBJECTIVE_EXPECTED_REWARD,true);
+				printf("Maximal expected reward: %.10g\n", tmp);
+			}else{
+				tmp=expected_reward_value_iteration(ma,true);
+				printf("Maximal expected reward: %.10g\n", tmp);
+			}
 			#ifndef __APPLE__
 			clock_gettime(CLOCK_REALTIME, &tp);
 			end = 1e9*tp.tv_sec + tp.tv_nsec;
@@ -643,8 +1024,20 @@ int main(int argc, char* argv[]) {
 			begin = 1e9*tp.tv_sec + tp.tv_nsec;
 			#endif
 			printf("\nCompute minimal expected reward, please wait.\n");
-			tmp=expected_reward_value_iteration(ma,false);
-			printf("Minimal expected reward: %.10g\n", tmp);
+			if(is_sound_present){
+				tmp=interval_iteration(ma,OBJECTIVE_EXPECTED_REWARD,false,epsilon,&lower,&upper);
+				printf("Minimal expected reward: %.10g\n", tmp);
+				printf("Interval: [%.10g,%.10g]\n", lower, upper);
+			}else if(is_topo_present){
+				tmp=topological_value_iteration(ma,OBJECTIVE_EXPECTED_REWARD,false);
+				printf("Minimal expected reward: %.10g\n", tmp);
+			}else if(is_pi_present){
+				tmp=policy_iteration(ma,OBJECTIVE_EXPECTED_REWARD,false);
+				printf("Minimal expected reward: %.10g\n", tmp);
+			}else{
+				tmp=expected_reward_value_iteration(ma,false);
+				printf("Minimal expected reward: %.10g\n", tmp);
+			}
 			#ifndef __APPLE__
 			clock_gettime(CLOCK_REALTIME, &tp);
 			end = 1e9*tp.tv_sec + tp.tv_nsec;
@@ -705,6 +1098,7 @@ int main(int argc, char* argv[]) {
             for (unsigned long state_nr = 0; state_nr < ma->n; state_nr++) {
                 ma->goals[state_nr]=true;
             }
+            SparseMatrix_goals_changed(ma);
         }
 
 		if(is_max_present){
@@ -746,6 +1140,7 @@ int main(int argc, char* argv[]) {
                     ma->goals[state_nr]=false;
                 }
             }
+            SparseMatrix_goals_changed(ma);
         }
 
 	}
@@ -753,36 +1148,26 @@ int main(int argc, char* argv[]) {
 		if(interval == 0){
 			interval=tb;
 		}
-		if(is_max_present){
-			#ifndef __APPLE__
-			clock_gettime(CLOCK_REALTIME, &tp);
-			begin = 1e9*tp.tv_sec + tp.tv_nsec;
-			#endif
-			printf("\nCompute maximal time-bounded reachability inside interval [%g,%g] with precision %g, please wait.\n", ta, tb, epsilon);
-			tmp=compute_time_bounded_reachability(ma,true,epsilon,ta,tb,is_imc,interval,interval_start);
-			if(interval==tb)
-				printf("Maximal time-bounded reachability probability: %.10g\n", tmp);
-			else
-				printf("tb=%.5g Maximal time-bounded reachability probability: %.10g\n", tb,tmp);
-			#ifndef __APPLE__
-			clock_gettime(CLOCK_REALTIME, &tp);
-			end = 1e9*tp.tv_sec + tp.tv_nsec;
-			printf("Computation Time: %f seconds\n", (end-begin)*1e-9);
-			#else
-			printf("Computation Time: ??? seconds\n");
-			#endif
+		if(is_adaptive_present && (ta > 0 || interval != tb)) {
+			printf(COLOR_YELLOW "WARNING: '%s' is only available for [0,T] without '%s', using the fixed discretisation step.\n" COLOR_END, ADAPTIVE_STR, INTERVAL_STR);
+			is_adaptive_present = false;
 		}
-		if(is_min_present){
+		if(is_max_present && is_min_present && !is_adaptive_present){
+			// the maximum and the minimum share every pass over the model
 			#ifndef __APPLE__
 			clock_gettime(CLOCK_REALTIME, &tp);
 			begin = 1e9*tp.tv_sec + tp.tv_nsec;
 			#endif
-			printf("\nCompute minimal time-bounded reachability inside interval [%g,%g] with precision %g, please wait.\n", ta, tb, epsilon);
-			tmp=compute_time_bounded_reachability(ma,false,epsilon,ta,tb,is_imc,interval,interval_start);
-			if(interval==tb)
-				printf("Minimal time-bounded reachability probability: %.10g\n", tmp);
-			else
+			printf("\nCompute maximal and minimal time-bounded reachability inside interval [%g,%g] with precision %g, please wait.\n", ta, tb, epsilon);
+			Real min_tmp;
+			compute_time_bounded_reachability_both(ma,epsilon,ta,tb,is_imc,interval,interval_start,&tmp,&min_tmp,sink);
+			if(interval==tb) {
+				printf("Maximal time-bounded reachability probability: %.10g\n", tmp);
+				printf("Minimal time-bounded reachability probability: %.10g\n", min_tmp);
+			} else {
 				printf("tb=%.5g Maximal time-bounded reachability probability: %.10g\n", tb,tmp);
+				printf("tb=%.5g Minimal time-bounded reachability probability: %.10g\n", tb,min_tmp);
+			}
 			#ifndef __APPLE__
 			clock_gettime(CLOCK_REALTIME, &tp);
 			end = 1e9*tp.tv_sec + tp.tv_nsec;
@@ -790,6 +1175,51 @@ int main(int argc, char* argv[]) {
 			#else
 			printf("Computation Time: ??? seconds\n");
 			#endif
+		} else {
+			if(is_max_present){
+				#ifndef __APPLE__
+				clock_gettime(CLOCK_REALTIME, &tp);
+				begin = 1e9*tp.tv_sec + tp.tv_nsec;
+				#endif
+				printf("\nCompute maximal time-bounded reachability inside interval [%g,%g] with precision %g, please wait.\n", ta, tb, epsilon);
+				if(is_adaptive_present)
+					tmp=compute_time_bounded_reachability_adaptive(ma,true,epsilon,tb,is_imc,sink);
+				else
+					tmp=compute_time_bounded_reachability(ma,true,epsilon,ta,tb,is_imc,interval,interval_start,sink);
+				if(interval==tb)
+					printf("Maximal time-bounded reachability probability: %.10g\n", tmp);
+				else
+					printf("tb=%.5g Maximal time-bounded reachability probability: %.10g\n", tb,tmp);
+				#ifndef __APPLE__
+				clock_gettime(CLOCK_REALTIME, &tp);
+				end = 1e9*tp.tv_sec + tp.tv_nsec;
+				printf("Computation Time: %f seconds\n", (end-begin)*1e-9);
+				#else
+				printf("Computation Time: ??? seconds\n");
+				#endif
+			}
+			if(is_min_present){
+				#ifndef __APPLE__
+				clock_gettime(CLOCK_REALTIME, &tp);
+				begin = 1e9*tp.tv_sec + tp.tv_nsec;
+				#endif
+				printf("\nCompute minimal time-bounded reachability inside interval [%g,%g] with precision %g, please wait.\n", ta, tb, epsilon);
+				if(is_adaptive_present)
+					tmp=compute_time_bounded_reachability_adaptive(ma,false,epsilon,tb,is_imc,sink);
+				else
+					tmp=compute_time_bounded_reachability(ma,false,epsilon,ta,tb,is_imc,interval,interval_start,sink);
+				if(interval==tb)
+					printf("Minimal time-bounded reachability probability: %.10g\n", tmp);
+				else
+					printf("tb=%.5g Maximal time-bounded reachability probability: %.10g\n", tb,tmp);
+				#ifndef __APPLE__
+				clock_gettime(CLOCK_REALTIME, &tp);
+				end = 1e9*tp.tv_sec + tp.tv_nsec;
+				printf("Computation Time: %f seconds\n", (end-begin)*1e-9);
+				#else
+				printf("Computation Time: ??? seconds\n");
+				#endif
+			}
 		}
 	}
 	if(is_time_reward_present && is_mrm_present){
@@ -840,20 +1270,30 @@ int main(int argc, char* argv[]) {
 	 *               MEC testsuite
 	 ********************************************************************/
 		printf("MEC computation start.\n");
+		#ifndef __APPLE__
+		clock_gettime(CLOCK_REALTIME, &tp);
+		begin = 1e9*tp.tv_sec + tp.tv_nsec;
+		#endif
 		SparseMatrixMEC *mecs;
 		mecs=mEC_decomposition_previous_algorithm(ma);
-		map<unsigned long,string> states_nr = ma->states_nr;
-		unsigned long *row_starts = (unsigned long *) mecs->row_counts;
-		unsigned long *cols = mecs->cols;
+		#ifndef __APPLE__
+		clock_gettime(CLOCK_REALTIME, &tp);
+		end = 1e9*tp.tv_sec + tp.tv_nsec;
+		printf("Computation Time: %f seconds\n", (end-begin)*1e-9);
+		#else
+		printf("Computation Time: ??? seconds\n");
+		#endif
+		sparse_index *row_starts = mecs->row_starts;
+		sparse_index *cols = mecs->cols;
 		for(unsigned long mec_nr=0; mec_nr < mecs->n; mec_nr++) {
 			unsigned long mec_start = row_starts[mec_nr];
 			unsigned long mec_end = row_starts[mec_nr + 1];
 			printf("MEC #%d: %d States\n",mec_nr+1,mec_end-mec_start);
             printf("{");
             for (int state_nr = mec_start; state_nr < mec_end-1; state_nr++) {
-                printf("%s,",(states_nr.find(cols[state_nr])->second).c_str());
+                printf("%s,",state_name(ma->names, cols[state_nr]));
             }
-            printf("%s}\n\n",(states_nr.find(cols[mec_end-1])->second).c_str());
+            printf("%s}\n\n",state_name(ma->names, cols[mec_end-1]));
 		}
 		SparseMatrixMEC_free(mecs);
 		delete(mecs);
@@ -873,6 +1313,7 @@ int main(int argc, char* argv[]) {
         printf("Dot file \"%s\" created.\n",file.c_str());
     }
     
+	ResultSink_free(sink);
 	SparseMatrix_free(ma);
 
 	delete(ma);
@@ -0,0 +1,520 @@
+/**
+* IMCA is a analyzing tool for unbounded reachability probabilities, expected-
+* time, and long-run averages for Interactive Markov Chains and Markov Automata.
+* Copyright (C) RWTH Aachen, 2012
+*				UTwente, 2013
+* 	Author: Dennis Guck
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*
+* Source description:
+*	Binary cache (.imcab) of compiled models. The file starts with a
+*	ModelCacheHeader, followed by the sections
+*		row_starts, rate_starts, choice_starts, cols, non_zeros,
+*		exit_rates, rewards (only with rewards), initials, goals, isPS
+*		(as bitsets), name offsets, name hashes, name table, name arena
+*	All numbers are little-endian, every section starts at a multiple of
+*	8 bytes. The arrays of the MA point directly into the mapped file.
+*/
+
+#include "model_cache.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <iostream>
+#include <string>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "read_file.h"
+
+// Coloured output
+#define COLOR_RED "\x1b[31m" // Color Start
+#define COLOR_YELLOW "\x1b[33m" // Color Start
+#define COLOR_END "\x1b[0m" // To flush out prev settings
+
+using namespace std;
+
+/* flags of the header */
+#define CACHE_HAS_REWARDS 1
+#define CACHE_LONG_INDEX 2		/* written with 64 bit sparse_index */
+
+typedef struct ModelCacheHeader ModelCacheHeader;
+
+struct ModelCacheHeader
+{
+	char magic[8];			/* MODEL_CACHE_MAGIC */
+	uint32_t version;		/* MODEL_CACHE_VERSION */
+	uint32_t flags;			/* CACHE_HAS_REWARDS, CACHE_LONG_INDEX */
+	uint64_t source_size;		/* size of the model file */
+	int64_t source_mtime;		/* modification time of the model file */
+	uint64_t n;			/* # of states */
+	uint64_t ms_n;			/* # of Markovian states */
+	uint64_t choices_n;		/* # of choices */
+	uint64_t non_zero_n;		/* # of transitions */
+	double max_exit_rate;
+	double max_markovian_reward;
+	uint64_t names_table_size;	/* size of the hash table of the state names */
+	uint64_t names_arena_n;		/* bytes of all state names */
+};
+
+typedef struct CacheLayout CacheLayout;
+
+/**
+* Offsets of the sections in the file.
+*/
+struct CacheLayout
+{
+	size_t row_starts;
+	size_t rate_starts;
+	size_t choice_starts;
+	size_t cols;
+	size_t non_zeros;
+	size_t exit_rates;
+	size_t rewards;
+	size_t initials;
+	size_t goals;
+	size_t isPS;
+	size_t name_offsets;
+	size_t name_hashes;
+	size_t name_table;
+	size_t name_arena;
+	size_t size;			/* size of the whole file */
+};
+
+/**
+* The arrays are stored as they are in memory, so the compiled models can only
+* be used on little-endian hosts with 64 bit unsigned long and double as Real.
+*
+* @return true if the compiled models can be used on this host
+*/
+static bool host_supported(void)
+{
+	unsigned long one = 1;
+	return sizeof(unsigned long) == 8 && sizeof(Real) == 8 && *(unsigned char *) &one == 1;
+}
+
+/**
+* @return # of bytes of a section padded to a multiple of 8
+*/
+static size_t padded(size_t bytes)
+{
+	return (bytes + 7) & ~((size_t) 7);
+}
+
+/**
+* @return # of bytes of a bitset with @a n entries
+*/
+static size_t bitset_bytes(unsigned long n)
+{
+	return ((n + 63) / 64) * sizeof(uint64_t);
+}
+
+/**
+* Computes the offsets of all sections.
+*
+* @param h the header
+* @param layout the offsets
+*/
+static void cache_layout(const ModelCacheHeader *h, CacheLayout *layout)
+{
+	size_t pos = sizeof(ModelCacheHeader);
+	layout->row_starts = pos;
+	pos += padded((h->n + 1) * sizeof(sparse_index));
+	layout->rate_starts = pos;
+	pos += padded((h->n + 1) * sizeof(sparse_index));
+	layout->choice_starts = pos;
+	pos += padded((h->choices_n + 1) * sizeof(sparse_index));
+	layout->cols = pos;
+	pos += padded(h->non_zero_n * sizeof(sparse_index));
+	layout->non_zeros = pos;
+	pos += padded(h->non_zero_n * sizeof(Real));
+	layout->exit_rates = pos;
+	pos += padded(h->ms_n * sizeof(Real));
+	layout->rewards = pos;
+	if (h->flags & CACHE_HAS_REWARDS)
+		pos += padded(h->choices_n * sizeof(Real));
+	layout->initials = pos;
+	pos += bitset_bytes(h->n);
+	layout->goals = pos;
+	pos += bitset_bytes(h->n);
+	layout->isPS = pos;
+	pos += bitset_bytes(h->n);
+	layout->name_offsets = pos;
+	pos += padded(h->n * sizeof(unsigned long));
+	layout->name_hashes = pos;
+	pos += padded(h->n * sizeof(unsigned long));
+	layout->name_table = pos;
+	pos += padded(h->names_table_size * sizeof(unsigned long));
+	layout->name_arena = pos;
+	pos += padded(h->names_arena_n);
+	layout->size = pos;
+}
+
+/**
+* Writes a section and pads it to a multiple of 8 bytes.
+*
+* @param file the compiled model
+* @param data the section
+* @param bytes size of the section
+* @param error error flag
+*/
+static void write_section(FILE *file, const void *data, size_t bytes, bool *error)
+{
+	static const char zeros[8] = { 0 };
+	if (*error)
+		return;
+	if (bytes > 0 && fwrite(data, 1, bytes, file) != bytes)
+		*error = true;
+	else if (padded(bytes) > bytes && fwrite(zeros, 1, padded(bytes) - bytes, file) != padded(bytes) - bytes)
+		*error = true;
+}
+
+/**
+* Writes @a n flags as bitset.
+*
+* @param file the compiled model
+* @param flags the flags
+* @param n # of flags
+* @param error error flag
+*/
+static void write_bitset(FILE *file, const bool *flags, unsigned long n, bool *error)
+{
+	size_t words = bitset_bytes(n) / sizeof(uint64_t);
+	uint64_t *bits = (uint64_t *) calloc(words > 0 ? words : 1, sizeof(uint64_t));
+	for (unsigned long i = 0; i < n; i++) {
+		if (flags[i])
+			bits[i / 64] |= ((uint64_t) 1) << (i % 64);
+	}
+	write_section(file, bits, words * sizeof(uint64_t), error);
+	free(bits);
+}
+
+/**
+* Expands a bitset with @a n entries to an array of flags.
+*
+* @param bits the bitset
+* @param n # of flags
+* @return the flags
+*/
+static bool *read_bitset(const uint64_t *bits, unsigned long n)
+{
+	bool *flags = (bool *) malloc((n > 0 ? n : 1) * sizeof(bool));
+	for (unsigned long i = 0; i < n; i++)
+		flags[i] = (bits[i / 64] >> (i % 64)) & 1;
+	return flags;
+}
+
+/**
+* Writes MA @a ma, read from @a model_file, to the compiled model @a cache_file.
+* The file is written under a temporary name first, so that a concurrent run
+* never maps a half written model.
+*
+* @param ma the MA
+* @param model_file the file the MA was read from
+* @param cache_file the compiled model
+* @param mrm true if rewards are stored
+* @return false if the compiled model could not be written
+*/
+bool write_model_cache(const SparseMatrix *ma, const char *model_file, const char *cache_file, bool mrm)
+{
+	bool error = false;
+	struct stat source;
+	ModelCacheHeader h;
+	const StateNames *names = ma->names;
+
+	if (!host_supported()) {
+		fprintf(stderr, COLOR_YELLOW "Compiled models are not supported on this host.\n" COLOR_END);
+		return false;
+	}
+	if (stat(model_file, &source) != 0) {
+		fprintf(stderr, COLOR_RED "Could not open file \"%s\"\n" COLOR_END, model_file);
+		return false;
+	}
+
+	memset(&h, 0, sizeof(h));
+	memcpy(h.magic, MODEL_CACHE_MAGIC, sizeof(h.magic));
+	h.version = MODEL_CACHE_VERSION;
+	h.flags = (mrm && ma->rewards != NULL) ? CACHE_HAS_REWARDS : 0;
+	if (sizeof(sparse_index) == 8)
+		h.flags |= CACHE_LONG_INDEX;
+	h.source_size = source.st_size;
+	h.source_mtime = source.st_mtime;
+	h.n = ma->n;
+	h.ms_n = ma->ms_n;
+	h.choices_n = ma->choices_n;
+	h.non_zero_n = ma->non_zero_n;
+	h.max_exit_rate = ma->max_exit_rate;
+	h.max_markovian_reward = ma->max_markovian_reward;
+	h.names_table_size = names->table_size;
+	h.names_arena_n = names->arena_n;
+
+	string tmp_file = string(cache_file) + ".tmp";
+	FILE *file = fopen(tmp_file.c_str(), "wb");
+	if (file == NULL) {
+		fprintf(stderr, COLOR_RED "Could not create file \"%s\"\n" COLOR_END, tmp_file.c_str());
+		return false;
+	}
+
+	write_section(file, &h, sizeof(h), &error);
+	write_section(file, ma->row_starts, (ma->n + 1) * sizeof(sparse_index), &error);
+	write_section(file, ma->rate_starts, (ma->n + 1) * sizeof(sparse_index), &error);
+	write_section(file, ma->choice_starts, (ma->choices_n + 1) * sizeof(sparse_index), &error);
+	write_section(file, ma->cols, ma->non_zero_n * sizeof(sparse_index), &error);
+	write_section(file, ma->non_zeros, ma->non_zero_n * sizeof(Real), &error);
+	write_section(file, ma->exit_rates, ma->ms_n * sizeof(Real), &error);
+	if (h.flags & CACHE_HAS_REWARDS)
+		write_section(file, ma->rewards, ma->choices_n * sizeof(Real), &error);
+	write_bitset(file, ma->initials, ma->n, &error);
+	write_bitset(file, ma->goals, ma->n, &error);
+	write_bitset(file, ma->isPS, ma->n, &error);
+	write_section(file, names->offsets, ma->n * sizeof(unsigned long), &error);
+	write_section(file, names->hashes, ma->n * sizeof(unsigned long), &error);
+	write_section(file, names->table, names->table_size * sizeof(unsigned long), &error);
+	write_section(file, names->arena, names->arena_n, &error);
+
+	if (fclose(file) != 0)
+		error = true;
+	if (!error && rename(tmp_file.c_str(), cache_file) != 0)
+		error = true;
+	if (error) {
+		fprintf(stderr, COLOR_RED "Could not write file \"%s\"\n" COLOR_END, cache_file);
+		remove(tmp_file.c_str());
+	}
+
+	return !error;
+}
+
+/**
+* @param starts the start array
+* @param n # of rows
+* @param end # of entries of all rows
+* @return true if @a starts starts at 0, never decreases and ends at @a end
+*/
+static bool starts_valid(const sparse_index *starts, unsigned long n, unsigned long end)
+{
+	if (starts[0] != 0 || starts[n] != end)
+		return false;
+	for (unsigned long i = 0; i < n; i++) {
+		if (starts[i] > starts[i + 1])
+			return false;
+	}
+	return true;
+}
+
+/**
+* @param rate_starts the first exit rate of each state
+* @param isPS the probabilistic states as bitset
+* @param n # of states
+* @param ms_n # of Markovian states
+* @return true if every Markovian state has one exit rate and every
+*	probabilistic state none
+*/
+static bool rate_starts_valid(const sparse_index *rate_starts, const uint64_t *isPS, unsigned long n, unsigned long ms_n)
+{
+	if (rate_starts[0] != 0 || rate_starts[n] != ms_n)
+		return false;
+	for (unsigned long i = 0; i < n; i++) {
+		bool ps = (isPS[i / 64] >> (i % 64)) & 1;
+		if (rate_starts[i + 1] != rate_starts[i] + (ps ? 0 : 1))
+			return false;
+	}
+	return true;
+}
+
+/**
+* @param cols the columns
+* @param n # of columns
+* @param bound the bound
+* @return true if all columns are below @a bound
+*/
+static bool cols_valid(const sparse_index *cols, unsigned long n, unsigned long bound)
+{
+	for (unsigned long i = 0; i < n; i++) {
+		if (cols[i] >= bound)
+			return false;
+	}
+	return true;
+}
+
+/**
+* Checks that the state names of the compiled model only point into their
+* arena and to existing states, and that the hash table has a free slot to
+* end each lookup.
+*
+* @param h the header
+* @param layout the offsets of the sections
+* @param base start of the mapped file
+* @return true if the state names can be used
+*/
+static bool names_valid(const ModelCacheHeader *h, const CacheLayout *layout, const char *base)
+{
+	const unsigned long *offsets = (const unsigned long *) (base + layout->name_offsets);
+	const unsigned long *table = (const unsigned long *) (base + layout->name_table);
+	const char *arena = base + layout->name_arena;
+	unsigned long used = 0;
+
+	if (h->n > 0 && (h->names_arena_n == 0 || arena[h->names_arena_n - 1] != '\0'))
+		return false;
+	for (unsigned long nr = 0; nr < h->n; nr++) {
+		if (offsets[nr] >= h->names_arena_n)
+			return false;
+	}
+	for (unsigned long slot = 0; slot < h->names_table_size; slot++) {
+		if (table[slot] > h->n)
+			return false;
+		if (table[slot] != 0)
+			used++;
+	}
+	return used == h->n && used < h->names_table_size;
+}
+
+/**
+* Copies the state names out of the compiled model.
+*
+* @param h the header
+* @param layout the offsets of the sections
+* @param base start of the mapped file
+* @return the state names
+*/
+static StateNames *read_names(const ModelCacheHeader *h, const CacheLayout *layout, const char *base)
+{
+	StateNames *names = StateNames_new();
+	free(names->arena);
+	free(names->offsets);
+	free(names->hashes);
+	free(names->table);
+
+	names->n = h->n;
+	names->arena_n = h->names_arena_n;
+	names->arena_size = h->names_arena_n > 0 ? h->names_arena_n : 1;
+	names->arena = (char *) malloc(names->arena_size);
+	memcpy(names->arena, base + layout->name_arena, h->names_arena_n);
+	names->offsets_size = h->n > 0 ? h->n : 1;
+	names->offsets = (unsigned long *) malloc(names->offsets_size * sizeof(unsigned long));
+	memcpy(names->offsets, base + layout->name_offsets, h->n * sizeof(unsigned long));
+	names->hashes = (unsigned long *) malloc(names->offsets_size * sizeof(unsigned long));
+	memcpy(names->hashes, base + layout->name_hashes, h->n * sizeof(unsigned long));
+	names->table_size = h->names_table_size;
+	names->table = (unsigned long *) malloc(names->table_size * sizeof(unsigned long));
+	memcpy(names->table, base + layout->name_table, names->table_size * sizeof(unsigned long));
+	return names;
+}
+
+/**
+* Maps the compiled model @a cache_file into memory. The compiled model is
+* only used if it is not older than @a model_file and was written for its
+* current size and modification time.
+*
+* @param model_file the model the compiled model was made from
+* @param cache_file the compiled model
+* @param mrm true if rewards are needed
+* @return MA, or NULL if there is no up-to-date compiled model
+*/
+SparseMatrix *read_model_cache(const char *model_file, const char *cache_file, bool mrm)
+{
+	struct stat source, cache;
+
+	if (!host_supported())
+		return NULL;
+	if (stat(model_file, &source) != 0 || stat(cache_file, &cache) != 0)
+		return NULL;
+	if (cache.st_mtime < source.st_mtime || (size_t) cache.st_size < sizeof(ModelCacheHeader))
+		return NULL;
+
+	int fd = open(cache_file, O_RDONLY);
+	if (fd < 0)
+		return NULL;
+	size_t size = cache.st_size;
+	void *mapping = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (mapping == MAP_FAILED)
+		return NULL;
+
+	const char *base = (const char *) mapping;
+	const ModelCacheHeader *h = (const ModelCacheHeader *) base;
+	if (memcmp(h->magic, MODEL_CACHE_MAGIC, sizeof(h->magic)) != 0 || h->version != MODEL_CACHE_VERSION
+			|| h->source_size != (uint64_t) source.st_size || h->source_mtime != (int64_t) source.st_mtime
+			|| (mrm && !(h->flags & CACHE_HAS_REWARDS))
+			|| ((h->flags & CACHE_LONG_INDEX) != 0) != (sizeof(sparse_index) == 8)) {
+		munmap(mapping, size);
+		return NULL;
+	}
+
+	/* no count can exceed the file size, this keeps the layout from overflowing */
+	CacheLayout layout;
+	bool valid = h->n <= size && h->ms_n <= h->n && h->choices_n <= size && h->non_zero_n <= size
+			&& h->names_table_size <= size && h->names_arena_n <= size
+			&& h->names_table_size > 0 && (h->names_table_size & (h->names_table_size - 1)) == 0;
+	if (valid) {
+		cache_layout(h, &layout);
+		valid = layout.size == size;
+	}
+	/* a damaged file must not make the analyses read outside the arrays */
+	if (valid) {
+		const sparse_index *row_starts = (const sparse_index *) (base + layout.row_starts);
+		const sparse_index *rate_starts = (const sparse_index *) (base + layout.rate_starts);
+		const sparse_index *choice_starts = (const sparse_index *) (base + layout.choice_starts);
+		valid = starts_valid(row_starts, h->n, h->choices_n)
+				&& rate_starts_valid(rate_starts, (const uint64_t *) (base + layout.isPS), h->n, h->ms_n)
+				&& starts_valid(choice_starts, h->choices_n, h->non_zero_n)
+				&& cols_valid((const sparse_index *) (base + layout.cols), h->non_zero_n, h->n)
+				&& names_valid(h, &layout, base);
+	}
+	if (!valid) {
+		fprintf(stderr, COLOR_YELLOW "The compiled model \"%s\" is damaged and is ignored.\n" COLOR_END, cache_file);
+		munmap(mapping, size);
+		return NULL;
+	}
+
+	SparseMatrix *model = new SparseMatrix;
+	model->n = h->n;
+	model->ms_n = h->ms_n;
+	model->choices_n = h->choices_n;
+	model->non_zero_n = h->non_zero_n;
+	model->names = read_names(h, &layout, base);
+	model->initials = read_bitset((const uint64_t *) (base + layout.initials), h->n);
+	model->goals = read_bitset((const uint64_t *) (base + layout.goals), h->n);
+	model->isPS = read_bitset((const uint64_t *) (base + layout.isPS), h->n);
+	model->non_zeros = (Real *) (base + layout.non_zeros);
+	model->exit_rates = (Real *) (base + layout.exit_rates);
+	model->rewards = (h->flags & CACHE_HAS_REWARDS) ? (Real *) (base + layout.rewards) : NULL;
+	model->max_exit_rate = h->max_exit_rate;
+	model->max_markovian_reward = h->max_markovian_reward;
+	model->cols = (sparse_index *) (base + layout.cols);
+	model->row_starts = (sparse_index *) (base + layout.row_starts);
+	model->rate_starts = (sparse_index *) (base + layout.rate_starts);
+	model->choice_starts = (sparse_index *) (base + layout.choice_starts);
+	model->branching = NULL;
+	model->state_rates = NULL;
+	model->mapping = mapping;
+	model->mapping_size = size;
+	model->locks_strong = NULL;
+	model->locks_weak = NULL;
+	model->mecs = NULL;
+	model->pred = NULL;
+	model->discrete = NULL;
+	model->discrete_tau = 0;
+
+	if (mrm)
+		cout << "Maximum State Reward: " << model->max_markovian_reward << endl;
+	print_model_info(model);
+
+	return model;
+}
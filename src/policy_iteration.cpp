@@ -0,0 +1,218 @@
+/**
+* IMCA is a analyzing tool for unbounded reachability probabilities, expected-
+* time, and long-run averages for Interactive Markov Chains and Markov Automata.
+* Copyright (C) RWTH Aachen, 2012
+*				UTwente, 2013
+* 	Author: Dennis Guck
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*
+*
+* Source description:
+*	Policy iteration for unbounded reachability, expected time and expected
+*	reward. The states whose values follow from the graph of the MA are
+*	fixed first. A scheduler picks one choice per state; its values solve a
+*	sparse linear system, which is done by Gauss-Seidel sweeps over the
+*	strongly connected components, successors first, starting from the
+*	values of the previous scheduler, until they are stable within a
+*	relative precision of 1e-7. Every state then switches to a choice
+*	which is better by more than this precision under these values. The start scheduler for
+*	minimal expected time and reward reaches the goal states almost surely,
+*	so the linear systems keep a unique solution. For the other objectives
+*	every scheduler does, or the least solution is the right one and is
+*	found by sweeps from below.
+*/
+
+#include "policy_iteration.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <iostream>
+#include <vector>
+
+#include "debug.h"
+#include "interval_iteration.h"
+
+// Coloured output
+#define COLOR_RED "\x1b[31m" // Color Start
+#define COLOR_END "\x1b[0m" // To flush out prev settings
+
+using namespace std;
+
+/* the evaluation of a cyclic block is given up after this many sweeps */
+#define MAX_EVALUATION_SWEEPS 1000000
+
+/**
+* Computes the value of @a choice_nr under the values @a u.
+*
+* @param ma the MA
+* @param cost cost of each choice
+* @param u the values
+* @param choice_nr the choice
+* @return the value
+*/
+static inline Real choice_value(const SparseMatrix *ma, const vector<Real>& cost, const vector<Real>& u, unsigned long choice_nr)
+{
+	Real value = cost[choice_nr];
+	for (unsigned long i = ma->choice_starts[choice_nr]; i < ma->choice_starts[choice_nr + 1]; i++)
+		value += ma->branching[i] * u[ma->cols[i]];
+	return value;
+}
+
+/**
+* Picks for every unknown state a choice which stays among the unknown and
+* goal states and leads closer to the goal states, such that the scheduler
+* reaches them almost surely.
+*
+* @param ma the MA
+* @param unknown the states with a value not fixed by the graph, all of them
+*	reach the goal states almost surely under some scheduler
+* @param order the unknown states, successors first
+* @param policy the choice of each state
+*/
+static void attracting_policy(const SparseMatrix *ma, const bool *unknown, const SweepOrder *order, vector<sparse_index>& policy)
+{
+	sparse_index *row_starts = ma->row_starts;
+	sparse_index *choice_starts = ma->choice_starts;
+	sparse_index *cols = ma->cols;
+	unsigned long num_states = order->block_starts[order->n];
+	vector<bool> ready(ma->goals, ma->goals + ma->n);
+
+	// a state picked in a pass may be used by the states after it, cycles need further passes
+	bool changed = true;
+	while (changed) {
+		changed = false;
+		for (unsigned long k = 0; k < num_states; k++) {
+			unsigned long state_nr = order->states[k];
+			if (ready[state_nr])
+				continue;
+			for (unsigned long choice_nr = row_starts[state_nr]; choice_nr < row_starts[state_nr + 1]; choice_nr++) {
+				bool inside = true, closer = false;
+				for (unsigned long i = choice_starts[choice_nr]; i < choice_starts[choice_nr + 1]; i++) {
+					unsigned long dst = cols[i];
+					if (!unknown[dst] && !ma->goals[dst])
+						inside = false;
+					if (ready[dst])
+						closer = true;
+				}
+				if (inside && closer) {
+					policy[state_nr] = choice_nr;
+					ready[state_nr] = true;
+					changed = true;
+					break;
+				}
+			}
+		}
+	}
+}
+
+Real policy_iteration(SparseMatrix *ma, ValueObjective objective, bool max)
+{
+	/* a cyclic block is stable once no value changes by this fraction any more,
+	   and a choice has to be better by this fraction of the value to be switched to */
+	const Real precision = 1e-7;
+	SparseMatrix_prepare(ma);
+	unsigned long n = ma->n;
+	sparse_index *row_starts = ma->row_starts;
+	bool reachability = (objective == OBJECTIVE_REACHABILITY);
+
+	// states with a value fixed by the graph of the MA, the others start at 0
+	bool *unknown = (bool *) malloc((n > 0 ? n : 1) * sizeof(bool));
+	vector<Real> u;
+	unsigned long num_unknown = graph_values(ma, objective, max, u, unknown);
+	sparse_index *states = (sparse_index *) malloc((num_unknown > 0 ? num_unknown : 1) * sizeof(sparse_index));
+	unsigned long num_states = 0;
+	for (unsigned long state_nr = 0; state_nr < n; state_nr++) {
+		if (unknown[state_nr])
+			states[num_states++] = state_nr;
+	}
+	SweepOrder *order = SweepOrder_states_new(ma, states, num_states);
+	free(states);
+
+	// time or reward of each choice until the next state
+	vector<Real> cost;
+	choice_costs(ma, objective, cost);
+
+	vector<sparse_index> policy(row_starts, row_starts + n);
+	if (!reachability && !max)
+		attracting_policy(ma, unknown, order, policy);
+	free(unknown);
+	printf("states to iterate: %lu\n", num_unknown);
+
+	cout << "start policy iteration" << endl;
+	unsigned long iterations = 0, backups = 0;
+	bool changed = true, stable = true;
+	while (changed) {
+		iterations++;
+		// policy evaluation, a cyclic block is swept until it is stable
+		for (unsigned long b = 0; b < order->n && stable; b++) {
+			unsigned long b_start = order->block_starts[b];
+			unsigned long b_end = order->block_starts[b + 1];
+			bool cyclic = order->cyclic[b];
+			unsigned long sweeps = 0;
+			bool done;
+			do {
+				done = true;
+				for (unsigned long k = b_start; k < b_end; k++) {
+					unsigned long state_nr = order->states[k];
+					Real value = choice_value(ma, cost, u, policy[state_nr]);
+					if (cyclic && fabs(value - u[state_nr]) > precision * (fabs(value) + 1))
+						done = false;
+					u[state_nr] = value;
+				}
+				backups += b_end - b_start;
+				if (!done && ++sweeps >= MAX_EVALUATION_SWEEPS) {
+					printf(COLOR_RED "ERROR: A block of %lu states is not stable after %d sweeps, the result is not reliable.\n" COLOR_END, b_end - b_start, MAX_EVALUATION_SWEEPS);
+					stable = false;
+					break;
+				}
+			} while (!done);
+		}
+		if (!stable)
+			break;
+
+		// policy improvement: keep the current choice unless another one is strictly better
+		changed = false;
+		for (unsigned long k = 0; k < num_states; k++) {
+			unsigned long state_nr = order->states[k];
+			Real best = u[state_nr];
+			Real tolerance = precision * (fabs(best) + 1);
+			for (unsigned long choice_nr = row_starts[state_nr]; choice_nr < row_starts[state_nr + 1]; choice_nr++) {
+				if (choice_nr == policy[state_nr])
+					continue;
+				Real value = choice_value(ma, cost, u, choice_nr);
+				if (max ? value > best + tolerance : value < best - tolerance) {
+					best = value;
+					policy[state_nr] = choice_nr;
+					changed = true;
+				}
+			}
+		}
+	}
+	printf("policy iterations: %lu\n", iterations);
+	cout << "backups: " << backups << endl;
+	SweepOrder_free(order);
+
+	// find the value of the initial states and return
+	Real obj = max ? 0 : infinity;
+	for (unsigned long state_nr = 0; state_nr < n; state_nr++) {
+		if (ma->initials[state_nr]) {
+			if (max ? u[state_nr] > obj : u[state_nr] < obj)
+				obj = u[state_nr];
+		}
+	}
+	return obj;
+}
@@ -34,6 +34,7 @@
 #include <vector>
 
 #include "debug.h"
+#include "lexer.h"
 
 // Coloured output
 #define COLOR_RED "\x1b[31m" // Color Start
@@ -42,687 +43,341 @@
 
 using namespace std;
 
+/* marks a state without a number yet */
+#define NO_STATE ((unsigned long) -1)
+
 /**
-* Read number of states and create a hash table for state names.
+* State of the single pass MA reader. States are numbered provisionally in the
+* order of their first occurrence in the file. After the last line is read they
+* get their final numbers: first all states with outgoing transitions, in the
+* order they are given, followed by the deadlock states.
+*/
+typedef struct MAReader MAReader;
+
+struct MAReader
+{
+	StateNames *names;			/* state names, numbered provisionally */
+	vector<unsigned long> source_nr;	/* provisional # mapped to source order, NO_STATE for deadlocks */
+	vector<unsigned long> sources;		/* source order mapped to provisional # */
+	vector<bool> initials;			/* indexed by provisional # */
+	vector<bool> goals;			/* indexed by provisional # */
+	vector<bool> found_as_successor;	/* first occurrence was a successor, indexed by provisional # */
+	vector<bool> isPS;			/* indexed by source order */
+	vector<unsigned long> row_ends;		/* # of choices after each source */
+
+	/* growable CSR buffers, handed over to the SparseMatrix */
+	sparse_index *cols;
+	unsigned long cols_size;
+	Real *non_zeros;
+	unsigned long non_zeros_size;
+	unsigned long nz_n;
+	sparse_index *choice_starts;
+	unsigned long choice_starts_size;
+	Real *rewards;
+	unsigned long rewards_size;
+	unsigned long choice_n;
+	Real *exit_rates;
+	unsigned long exit_rates_size;
+	unsigned long ms_n;
+	Real max_exit_rate;
+	Real max_markovian_reward;
+
+	/* transitions of the current source state */
+	bool in_block;
+	unsigned long from;
+	bool has_ps_choice;
+	bool has_ms_choice;
+	bool in_ms_choice;
+	unsigned long last_to;
+	vector<unsigned long> ms_cols;		/* the Markovian choice is kept aside until */
+	vector<Real> ms_non_zeros;		/* we know whether the state is probabilistic */
+	Real ms_reward;
+};
+
+/**
+* Makes sure that a buffer created by malloc can hold @a needed elements.
+* The capacity is doubled, so appending n elements costs O(n) in total.
 *
-* @param line_no line number in file (should be 1 before)
+* @param buf the buffer
+* @param size current capacity of the buffer (updated)
+* @param needed number of elements the buffer must hold
+* @param elem_size size of one element
 * @param error error flag
-* @param p MA file
-* @param filename filename of MA file
-* @param num_states will store number of states here
-* @param states will map the state names to state numbers
+* @return the (possibly moved) buffer
 */
-static void read_states(unsigned long *line_no, bool *error, FILE *p, const char *filename, unsigned long *num_states, map<string,unsigned long> *states, map<unsigned long,string> *states_nr)
+static void *grow_buffer(void *buf, unsigned long *size, unsigned long needed, size_t elem_size, bool *error)
 {
-	char s[MAX_LINE_LENGTH];
-	unsigned long state_nr = 0;
-	pair<map<string,unsigned long>::iterator,bool> ret;
-	char state[MAX_LINE_LENGTH];
-	char act[MAX_LINE_LENGTH];
-	map<string ,unsigned long> tmp;
-	map<unsigned long, string> tmp_nr;
-
-	/* go to Transitions */
-	if (!*error) {
-		if(fgets(s, MAX_LINE_LENGTH, p) == 0)
-		{
-			fprintf(stderr, COLOR_RED "Reading line %ld of file \"%s\" failed.\n" COLOR_END,*line_no, filename);
-			*error = true;
-		}
-		++(*line_no);
-		sscanf(s, "%s", state);
-		while(strcmp(state,TRANSITIONS) != 0 && !*error) {
-			if(fgets(s, MAX_LINE_LENGTH, p) == 0)
-			{
-				fprintf(stderr, COLOR_RED "Reading line %ld of file \"%s\" failed.\n" COLOR_END,*line_no, filename);
-				*error = true;
-			}
-			sscanf(s, "%s", state);
-			++(*line_no);
-		}
+	if (needed <= *size)
+		return buf;
+	unsigned long new_size = (*size < 1024) ? 1024 : *size;
+	while (new_size < needed)
+		new_size *= 2;
+	void *tmp = realloc(buf, new_size * elem_size);
+	if (tmp == NULL) {
+		fprintf(stderr, COLOR_RED "Out of memory while reading the transitions.\n" COLOR_END);
+		*error = true;
+		return buf;
 	}
+	*size = new_size;
+	return tmp;
+}
 
-
-	/* TODO: also check lines */
-	while (fgets(s, MAX_LINE_LENGTH, p) != NULL && !*error) {
-		if (s[0] == '*') {
-			++(*line_no);
-		} else {
-			sscanf(s, "%s%s", state, act);
-			ret=tmp.insert(pair<string,unsigned long>(state,state_nr));
-			if(ret.second == true){
-				tmp_nr.insert(pair<unsigned long,string>(state_nr,state));
-				state_nr++;
-			}
-			++(*line_no);
-		}
+/**
+* Returns the provisional number of state @a name, a new one if it is not known yet.
+*
+* @param r the reader
+* @param name state name (not terminated)
+* @param length length of the name
+* @param successor true if the state occurs as successor
+* @return provisional state number
+*/
+static unsigned long intern_state(MAReader *r, const char *name, size_t length, bool successor)
+{
+	bool inserted;
+	unsigned long nr = state_names_insert(r->names, name, length, &inserted);
+	if (inserted) {
+		r->source_nr.push_back(NO_STATE);
+		r->initials.push_back(false);
+		r->goals.push_back(false);
+		r->found_as_successor.push_back(successor);
 	}
-
-	(*num_states) = state_nr;
-	(*states)=tmp;
-	(*states_nr)=tmp_nr;
+	return nr;
 }
 
 /**
-* Check for deadlocks and add selfloop.
+* Appends a new choice to the CSR buffers.
 *
-* @param line_no line number in file (should be 1 before)
+* @param r the reader
+* @param reward reward of the choice
+* @param mrm true if rewards are stored
 * @param error error flag
-* @param p MA file
-* @param filename filename of MA file
-* @param num_states will store number of states here
-* @param states will map the state names to state numbers
 */
-static void check_dedlocks(unsigned long *line_no, bool *error, FILE *p, const char *filename, unsigned long *num_states, map<string,unsigned long> *states, map<unsigned long,string> *states_nr, vector<unsigned long> *deadlocks)
+static void add_choice(MAReader *r, Real reward, bool mrm, bool *error)
 {
-	char s[MAX_LINE_LENGTH];
-	unsigned long state_nr = (*num_states);
-	pair<map<string,unsigned long>::iterator,bool> ret;
-	char state[MAX_LINE_LENGTH];
-	char star[MAX_LINE_LENGTH];
-	map<string ,unsigned long> tmp=*states;
-	map<unsigned long, string> tmp_nr=*states_nr;
-	bool deadlock=false;
-
-	/* go to Transitions */
-	if(fgets(s, MAX_LINE_LENGTH, p) == 0)
-		{
-			fprintf(stderr, COLOR_RED "Reading line %ld of file \"%s\" failed.\n" COLOR_END,*line_no, filename);
-			*error = true;
-		}
-		++(*line_no);
-		sscanf(s, "%s", state);
-		if(strcmp(state,INITIALS) != 0 && !*error) {
-			fprintf(stderr,"No declaration of initial states.\n");
-			*error = true;
-		} else {
-			++(*line_no);
-			if(fgets(s, MAX_LINE_LENGTH, p) == 0)
-			{
-				fprintf(stderr, COLOR_RED "Reading line %ld of file \"%s\" failed.\n" COLOR_END,*line_no, filename);
-				*error = true;
-			}
-			sscanf(s, "%s", state);
-			while(strcmp(state,GOALS) != 0 && !*error)
-			{
-				ret=tmp.insert(pair<string,unsigned long>(state,state_nr));
-				if(ret.second == true){
-					//cout << "Deadlock: " << state << "    State nr = " << state_nr << endl;
-					deadlock=true;
-					tmp_nr.insert(pair<unsigned long,string>(state_nr,state));
-					(*deadlocks).push_back(state_nr);
-					state_nr++;
-				}
-				if(fgets(s, MAX_LINE_LENGTH, p) == 0)
-				{
-					fprintf(stderr, COLOR_RED "Reading line %ld of file \"%s\" failed.\n" COLOR_END,*line_no, filename);
-					*error = true;
-				}
-				sscanf(s, "%s", state);
-				++(*line_no);
-			}
-			if(fgets(s, MAX_LINE_LENGTH, p) == 0)
-			{
-				fprintf(stderr, COLOR_RED "Reading line %ld of file \"%s\" failed.\n" COLOR_END,*line_no, filename);
-				*error = true;
-			}
-			sscanf(s, "%s", state);
-			while(strcmp(state,TRANSITIONS) != 0 && !*error) {
-				ret=tmp.insert(pair<string,unsigned long>(state,state_nr));
-				if(ret.second == true){
-					//cout << "Deadlock: " << state << "    State nr = " << state_nr << endl;
-					deadlock=true;
-					tmp_nr.insert(pair<unsigned long,string>(state_nr,state));
-					(*deadlocks).push_back(state_nr);
-					state_nr++;
-				}
-				if(fgets(s, MAX_LINE_LENGTH, p) == 0)
-				{
-					fprintf(stderr, COLOR_RED "Reading line %ld of file \"%s\" failed.\n" COLOR_END,*line_no, filename);
-					*error = true;
-				}
-				sscanf(s, "%s", state);
-				++(*line_no);
-			}
-		}
-
-	// cout << "hey" << endl;
-
-	/* TODO: also check lines */
-	while (fgets(s, MAX_LINE_LENGTH, p) != NULL && !*error) {
-		if (s[0] == '*') {
-			sscanf(s, "%s%s", star, state);
-			ret=tmp.insert(pair<string,unsigned long>(state,state_nr));
-			if(ret.second == true){
-				cout << "Deadlock: " << state << "    State nr = " << state_nr << endl;
-				//cout << "";
-				deadlock=true;
-				tmp_nr.insert(pair<unsigned long,string>(state_nr,state));
-				(*deadlocks).push_back(state_nr);
-				state_nr++;
-			}
-			//cout << state << endl;
-			++(*line_no);
-		} else {
-			++(*line_no);
-		}
-	}
-
-	if(deadlock) {
-		(*num_states) = state_nr;
-		(*states)=tmp;
-		(*states_nr)=tmp_nr;
-	}
+	r->choice_starts = (sparse_index *) grow_buffer(r->choice_starts, &r->choice_starts_size, r->choice_n + 2, sizeof(sparse_index), error);
+	if (mrm)
+		r->rewards = (Real *) grow_buffer(r->rewards, &r->rewards_size, r->choice_n + 1, sizeof(Real), error);
+	if (*error)
+		return;
+	r->choice_starts[r->choice_n] = r->nz_n;
+	if (mrm)
+		r->rewards[r->choice_n] = reward;
+	r->choice_n++;
 }
 
-static void init_states(unsigned long *line_no, bool *error, FILE *p, const char *filename, unsigned long *num_ms_states, map<string,unsigned long> states, SparseMatrix *ma, vector<unsigned long> deadlocks) {
-	char src[MAX_LINE_LENGTH];
-	char act[MAX_LINE_LENGTH];
-	char s[MAX_LINE_LENGTH];
-	unsigned long from;
-	unsigned long last_from = 0;
-	unsigned long ms_states=0;
-	bool *isPS;
-	bool first=true;
-
+/**
+* Appends a successor to the last choice in the CSR buffers.
+*
+* @param r the reader
+* @param to provisional number of the successor
+* @param value probability or rate
+* @param error error flag
+*/
+static void add_successor(MAReader *r, unsigned long to, Real value, bool *error)
+{
+	r->cols = (sparse_index *) grow_buffer(r->cols, &r->cols_size, r->nz_n + 1, sizeof(sparse_index), error);
+	r->non_zeros = (Real *) grow_buffer(r->non_zeros, &r->non_zeros_size, r->nz_n + 1, sizeof(Real), error);
 	if (!*error) {
-		bool *initials = (bool *) ma->initials;
-		bool *goals = (bool *)ma->goals;
-		isPS = (bool *)ma->isPS;
-
-		for(from=0; from < ma->n; from++){
-			/* iinitialize init and goal and isPS with false */
-			initials[from]=false;
-			goals[from]=false;
-			isPS[from]=false;
-		}
-
-		/* store initials and goals */
-		if(fgets(s, MAX_LINE_LENGTH, p) == 0)
-		{
-			fprintf(stderr, COLOR_RED "Reading line %ld of file \"%s\" failed.\n" COLOR_END,*line_no, filename);
-			*error = true;
-		}
-		++(*line_no);
-		sscanf(s, "%s", src);
-		if(strcmp(src,INITIALS) != 0 && !*error) {
-			fprintf(stderr,COLOR_RED "No declaration of initial states.\n" COLOR_END);
-			*error = true;
-		} else {
-			++(*line_no);
-			if(fgets(s, MAX_LINE_LENGTH, p) == 0)
-			{
-				fprintf(stderr, COLOR_RED "Reading line %ld of file \"%s\" failed.\n" COLOR_END,*line_no, filename);
-				*error = true;
-			}
-			sscanf(s, "%s", src);
-			while(strcmp(src,GOALS) != 0 && !*error)
-			{
-				from=states.find(src)->second;
-				initials[from]=true;
-				if(fgets(s, MAX_LINE_LENGTH, p) == 0)
-				{
-					fprintf(stderr, COLOR_RED "Reading line %ld of file \"%s\" failed.\n" COLOR_END,*line_no, filename);
-					*error = true;
-				}
-				sscanf(s, "%s", src);
-				++(*line_no);
-			}
-			if(fgets(s, MAX_LINE_LENGTH, p) == 0)
-			{
-				fprintf(stderr, COLOR_RED "Reading line %ld of file \"%s\" failed.\n" COLOR_END,*line_no, filename);
-				*error = true;
-			}
-			sscanf(s, "%s", src);
-			while(strcmp(src,TRANSITIONS) != 0 && !*error) {
-				from=states.find(src)->second;
-				goals[from]=true;
-				if(fgets(s, MAX_LINE_LENGTH, p) == 0)
-				{
-					fprintf(stderr, COLOR_RED "Reading line %ld of file \"%s\" failed.\n" COLOR_END,*line_no, filename);
-					*error = true;
-				}
-				sscanf(s, "%s", src);
-				++(*line_no);
-			}
-		}
-	}
-
-	while (!*error && (fgets(s, MAX_LINE_LENGTH, p) != NULL)) {
-		if (s[0] != '*') {
-			if (sscanf(s, "%s%s", src, act) != 2) { /* check if both values are returned */
-				*error = true;
-			} else {
-				from=states.find(src)->second;
-				/* test consistency of ma file */
-				if (from < last_from) {
-					fprintf(stderr, COLOR_RED "Line %ld: State transitions must be given in continuous order for one state.\n" COLOR_END, *line_no);
-					*error = true;
-				} else if(from==last_from && !first){
-					if(strcmp(act,MARKOV_ACTION) == 0 && !isPS[from]) {
-						*error = true;
-						fprintf(stderr, COLOR_RED "Line %ld: Markovian state transitions of one state should not be divided.\n" COLOR_END, (*line_no));
-					} else {
-						isPS[from]=true;
-					}
-				} else {
-					if(strcmp(act,MARKOV_ACTION) != 0)
-						isPS[from]=true;
-					first=false;
-					last_from = from;
-				}
-			}
-		}
-		++(*line_no);
-	}
-
-	vector<unsigned long>::iterator it;
-	for(it=deadlocks.begin(); it<deadlocks.end(); it++) {
-		isPS[(*it)]=true;
+		r->cols[r->nz_n] = to;
+		r->non_zeros[r->nz_n] = value;
+		r->nz_n++;
 	}
+}
 
-	if(!*error) {
-		for(from=0; from<ma->n; from++) {
-			if(!isPS[from])
-				ms_states++;
+/**
+* Finishes the transitions of the current source state. The Markovian choice
+* is added only if the state has no probabilistic choice, since probabilistic
+* transitions are chosen before Markovian transitions.
+*
+* @param r the reader
+* @param mrm true if rewards are stored
+* @param error error flag
+*/
+static void flush_state(MAReader *r, bool mrm, bool *error)
+{
+	if (!r->in_block)
+		return;
+	r->in_block = false;
+	if (r->has_ps_choice) {
+		r->isPS.push_back(true);
+	} else {
+		Real exit_rate = 0;
+		add_choice(r, r->ms_reward, mrm, error);
+		for (unsigned long i = 0; i < r->ms_cols.size() && !*error; i++) {
+			add_successor(r, r->ms_cols[i], r->ms_non_zeros[i], error);
+			exit_rate += r->ms_non_zeros[i];
 		}
+		if (*error)
+			return;
+		r->exit_rates = (Real *) grow_buffer(r->exit_rates, &r->exit_rates_size, r->ms_n + 1, sizeof(Real), error);
+		if (*error)
+			return;
+		r->exit_rates[r->ms_n] = exit_rate;
+		r->ms_n++;
+		if (r->max_exit_rate < exit_rate)
+			r->max_exit_rate = exit_rate;
+		if (mrm && r->max_markovian_reward < r->ms_reward)
+			r->max_markovian_reward = r->ms_reward;
+		r->isPS.push_back(false);
 	}
-
-	if(!*error) {
-		(*num_ms_states) = ms_states;
-		ma->ms_n = ms_states;
-		Real * exit_rates = (Real *) malloc(ms_states * sizeof(Real));
-		ma->exit_rates = exit_rates;
-	}
+	r->row_ends.push_back(r->choice_n);
 }
 
-
 /**
-* Allocate memory needed for MA data structures and stores rates for Markovian states.
+* Reads the initial and goal states up to the transitions.
 *
-* @param line_no line number in file
+* @param r the reader
 * @param error error flag
-* @param p MA file
-* @param model MA for which allocations will be done
+* @param lx lexer on the MA file
+* @param filename filename of MA file
 */
-static void reserve_transition_memory(unsigned long *line_no, bool *error, FILE *p, const char *filename, SparseMatrix *model, vector<unsigned long> deadlocks, bool mrm) {
-	char s[MAX_LINE_LENGTH];
-	char src[MAX_LINE_LENGTH];
-	char dst[MAX_LINE_LENGTH];
-	char act[MAX_LINE_LENGTH];
-	char star[MAX_LINE_LENGTH];
-	Real exit_rate=0.0;
-	Real max_exit_rate=0;
-	Real prob;
-    Real reward;
-	unsigned long exit_index = 0;
-	unsigned long num_choice = 0;
-	unsigned long num_non_zeros = 0;
-	bool is_ms = false;
-	Real *exit_rates;
-	unsigned long *rate_starts;
-	unsigned long from;
-	unsigned long last_from = 0;
-	unsigned long to;
-	unsigned long last_to = -1;
-	map<string ,unsigned long> states;
-	bool *isPS;
-
-	/* go to Transitions */
-	if (!*error) {
-		if(fgets(s, MAX_LINE_LENGTH, p) == 0)
-		{
-			fprintf(stderr, COLOR_RED "Reading line %ld of file \"%s\" failed.\n" COLOR_END,*line_no, filename);
+static void read_header(MAReader *r, bool *error, Lexer *lx, const char *filename)
+{
+	const char *state;
+	size_t length;
+	bool in_initials = false;
+	bool in_goals = false;
+
+	for (;;) {
+		if (lexer_eof(lx)) {
+			fprintf(stderr, COLOR_RED "Reading line %ld of file \"%s\" failed.\n" COLOR_END, lx->line_no, filename);
 			*error = true;
-		}
-		++(*line_no);
-		sscanf(s, "%s", src);
-		while(strcmp(src,TRANSITIONS) != 0 && !*error) {
-			if(fgets(s, MAX_LINE_LENGTH, p) == 0)
-			{
-				fprintf(stderr, COLOR_RED "Reading line %ld of file \"%s\" failed.\n" COLOR_END,*line_no, filename);
+		} else if (!lexer_token(lx, &state, &length)) {
+			/* skip empty lines */
+		} else if (!in_initials && !in_goals) {
+			if (!token_equals(state, length, INITIALS)) {
+				fprintf(stderr, COLOR_RED "No declaration of initial states.\n" COLOR_END);
 				*error = true;
 			}
-			sscanf(s, "%s", src);
-			++(*line_no);
-		}
-	}
-
-	if (!*error) {
-		exit_rates = model->exit_rates;
-		rate_starts = (unsigned long *) model->rate_counts;
-		states = model->states;
-		isPS = model->isPS;
-	}
-
-
-	while (!*error && (fgets(s, MAX_LINE_LENGTH, p) != NULL)) {
-		if (s[0] != '*') {
-			if (sscanf(s, "%s%s", src, act) != 2) { /* check if both values are returned */
-				*error = true;
-			} else {
-				from=states.find(src)->second;
-				last_to = -1;
-				/* test consistency of ma file */
-				if (from < last_from) {
-					fprintf(stderr, COLOR_RED "Line %ld: State transitions must be given in continuous order for one state.\n" COLOR_END, *line_no);
-					*error = true;
-				} else {
-					/* if Markovian state, store exit rate */
-					if(is_ms & !isPS[last_from]) {
-						if(max_exit_rate<exit_rate)
-							max_exit_rate=exit_rate;
-						exit_rates[exit_index] = exit_rate;
-						exit_index++;
-						for (; last_from < from; last_from++) {
-							rate_starts[last_from + 1] = rate_starts[last_from + 0];
-						}
-						rate_starts[from + 0]++;
-					} else {
-						for (; last_from < from; last_from++) {
-							rate_starts[last_from + 1] = rate_starts[last_from + 0];
-						}
-					}
-
-
-					is_ms=false;
-					exit_rate=0;
-					if(strcmp(act,MARKOV_ACTION) == 0)
-					{
-						is_ms=true;
-					}
-
-					/* probabilistic transitions are chosen before Markovian transitions */
-					if((isPS[from] && !is_ms) || (!isPS[from] && is_ms)){
-						num_choice++;
-					}
-
-					last_from = from;
-				}
-			}
-			//++(*line_no);
-		} else {
-			/* probabilistic transitions are chosen before Markovian transitions */
-			Real rate;
-			if ( 3 != sscanf(s, "%s%s%lf", star, dst, &rate) ) {
-				fprintf(stderr, COLOR_RED "ERROR at line %d, expected something like '* <dst_state> <rate/prob>'.\n" COLOR_END, *line_no);
-				*error = true;
-			}
-			dbg_printf("%s %s\n",src,act);
-			to = states.find(dst)->second;
-			if(((isPS[from] && !is_ms) || (!isPS[from] && is_ms)) && to != last_to) {
-				num_non_zeros++;
-				if(is_ms & !isPS[from]){
-					//Real rate;
-					//char star[MAX_LINE_LENGTH];
-					//sscanf(s, "%s%s%lf", star, dst, &rate);
-					exit_rate += rate;
-				}
-			}
-			last_to = to;
-		}
-		++(*line_no);
-	}
-
-	//dbg_printf("nz %ld  nc %ld\n",num_non_zeros,num_choice);
-
-	if(deadlocks.size() == 0) {
-		/* probabilistic transitions are choosen before markovian transitions */
-		if((is_ms)) {
-			if(max_exit_rate<exit_rate)
-				max_exit_rate=exit_rate;
-			exit_rates[exit_index] = exit_rate;
-			for (; from+0 < model->n; from++) {
-				rate_starts[from+1] = rate_starts[from+0];
-			}
-			rate_starts[from + 0]++;
+			in_initials = true;
+		} else if (in_initials && token_equals(state, length, GOALS)) {
+			in_initials = false;
+			in_goals = true;
+		} else if (in_goals && token_equals(state, length, TRANSITIONS)) {
+			lexer_next_line(lx);
+			break;
+		} else if (state[0] == '#') {
+			fprintf(stderr, COLOR_RED "Line %ld: Unexpected section \"%.*s\".\n" COLOR_END, lx->line_no, (int) length, state);
+			*error = true;
+		} else if (in_initials) {
+			r->initials[intern_state(r, state, length, false)] = true;
 		} else {
-			//cout << from << " " << last_from << endl;
-			for (; last_from < from; last_from++) {
-				rate_starts[last_from + 1] = rate_starts[last_from + 0];
-			}
-		}
-	}
-	else{
-		vector<unsigned long>::iterator it;
-		for(it=deadlocks.begin(); it<deadlocks.end(); it++) {
-			from=(*it);
-			if(is_ms) {
-				exit_rates[exit_index] = exit_rate;
-				exit_index++;
-				if(max_exit_rate<exit_rate)
-					max_exit_rate=exit_rate;
-				for (; last_from < from; last_from++) {
-					rate_starts[last_from + 1] = rate_starts[last_from + 0];
-				}
-				rate_starts[from + 0]++;
-				is_ms=false;
-			} else {
-				for (; last_from < from; last_from++) {
-					rate_starts[last_from + 1] = rate_starts[last_from + 0];
-				}
-			}
-			num_choice++;
-			num_non_zeros++;
-			last_from = from;
-		}
-		for (; last_from < from; last_from++) {
-			rate_starts[last_from + 1] = rate_starts[last_from + 0];
-		}
-	}
-
-	dbg_printf("nz %ld  nc %ld\n",num_non_zeros,num_choice);
-
-	/* now allocate the memory needed */
-	if (!*error) {
-		unsigned long * choice_starts = (unsigned long *) calloc((size_t) (num_choice + 1), sizeof(unsigned long));
-		Real * non_zeros = (Real *) malloc((num_non_zeros) * sizeof(Real));
-		unsigned long * cols = (unsigned long *) malloc((num_non_zeros) * sizeof(unsigned long));
-		model->choice_counts = (unsigned char *) choice_starts;
-		model->non_zeros = non_zeros;
-		model->cols = cols;
-		model->choices_n = num_choice;
-		model->non_zero_n = num_non_zeros;
-		model->max_exit_rate=max_exit_rate;
-		if(mrm){
-			Real * rewards = (Real *) malloc((num_choice) * sizeof(Real));
-			model->rewards=rewards;
+			r->goals[intern_state(r, state, length, false)] = true;
 		}
+		if (*error)
+			break;
+		lexer_next_line(lx);
 	}
 }
 
 /**
-* Reads the transitions of a MA.
+* Reads the transitions of a MA in one pass and stores them in the growable
+* CSR buffers of the reader. Successors are stored with provisional numbers.
 *
-* @param line_no line number in file (should be 1 before)
+* @param r the reader
 * @param error error flag
-* @param p MA file
-* @param filename of MA file
-* @param ma the transitions shall be added
+* @param lx lexer on the MA file
+* @param mrm true if rewards are stored
 */
-static void read_transitions(unsigned long *line_no, bool *error, FILE *p, const char *filename, SparseMatrix *ma, vector<unsigned long> deadlocks,bool mrm) {
-	unsigned long choice_index = 0;
-	unsigned long choice_size = 0;
-	unsigned long nz_index = 0;
-	unsigned long reward_index = 0;
-	Real max_markovian_reward = 0.0;
-	char src[MAX_LINE_LENGTH];
-	unsigned long from;
-	unsigned long last_from = 0;
-	char s[MAX_LINE_LENGTH];
-	char dst[MAX_LINE_LENGTH];
-	unsigned long to;
-	char act[MAX_LINE_LENGTH];
-	bool bad=false;
-	unsigned long last_to = -1;
-	//Real r=0;
-
-	Real tmp = 0;
-	unsigned int old_index;
-
-	if (!*error) {
-		Real *non_zeros = ma->non_zeros;
-		Real *rewards = ma->rewards;
-		unsigned long *cols = ma->cols;
-		unsigned long *choice_starts = (unsigned long *) ma->choice_counts;
-		unsigned long *row_starts = (unsigned long *) ma->row_counts;
-		map<string ,unsigned long> states = ma->states;
-		bool *isPS = ma->isPS;
-
-		/* go to Transitions */
-		if (!*error) {
-			if(fgets(s, MAX_LINE_LENGTH, p) == 0)
-			{
-				fprintf(stderr, COLOR_RED "Reading line %ld of file \"%s\" failed.\n" COLOR_END,*line_no, filename);
+static void read_transitions(MAReader *r, bool *error, Lexer *lx, bool mrm)
+{
+	const char *src;
+	const char *act;
+	const char *dst;
+	size_t src_length;
+	size_t act_length;
+	size_t dst_length;
+
+	for (; !*error && !lexer_eof(lx); lexer_next_line(lx)) {
+		if (*lx->pos == '*') {
+			Real value;
+			lx->pos++;
+			if (!lexer_token(lx, &dst, &dst_length) || !lexer_fraction(lx, &value)) {
+				fprintf(stderr, COLOR_RED "ERROR at line %ld, expected something like '* <dst_state> <rate/prob>'.\n" COLOR_END, lx->line_no);
+				*error = true;
+			} else if (!r->in_block) {
+				fprintf(stderr, COLOR_RED "Line %ld: Transition without source state.\n" COLOR_END, lx->line_no);
 				*error = true;
-			}
-			++(*line_no);
-			sscanf(s, "%s", src);
-			dbg_printf("%s\n", src);
-			while(strcmp(src,TRANSITIONS) != 0 && !*error) {
-				if(fgets(s, MAX_LINE_LENGTH, p) == 0)
-				{
-					fprintf(stderr, COLOR_RED "Reading line %ld of file \"%s\" failed.\n" COLOR_END,*line_no, filename);
-					*error = true;
-				}
-				sscanf(s, "%s", src);
-				++(*line_no);
-			}
-		}
-
-		while (fgets(s, MAX_LINE_LENGTH, p) != NULL) {
-			if (s[0] == '*') {
-				if(!bad)
-				{
-					Real rate;
-					Real denominator=1;
-					char star[MAX_LINE_LENGTH];
-					sscanf(s, "%s%s%lf/%lf", star, dst, &rate, &denominator);
-					dbg_printf("* %s %lf/%lf\n", dst, rate, denominator);
-					to=states.find(dst)->second;
-					if(to != last_to) {
-						non_zeros[nz_index] = rate/denominator;
-						cols[nz_index] = to;
-						old_index = nz_index;
-						nz_index++;
-						choice_size++;
-					}else if(to == last_to) {
-						non_zeros[old_index] += rate/denominator;
-					}
-					last_to = to;
-				}
 			} else {
-				last_to = -1;
-				/* just read a line "state act" */
-				// if mrm we also read in the reward
-				if(mrm){
-					Real reward=0;
-					Real denominator=1;
-					sscanf(s, "%s%s%lf/%lf", src, act, &reward, &denominator);
-					dbg_printf("reward index: %ld\n",reward_index);
-					rewards[reward_index] = reward/denominator;
-				}else {
-					sscanf(s, "%s%s", src, act);
-				}
-				dbg_printf("%s %s\n",src,act);
-				from=states.find(src)->second;
-				/* probabilistic transitions are choosen before markovian transitions */
-				if(strcmp(act,MARKOV_ACTION) == 0 && isPS[from])
-					bad=true;
-				else{
-					bad=false;
-					reward_index++;
-				}
-				if(!bad) {
-					if(mrm){
-					// Set maximum Markovian reward
-						if( strncmp(act,MARKOV_ACTION, 2) == 0 && max_markovian_reward < rewards[reward_index - 1] )
-							max_markovian_reward = rewards[reward_index - 1];
+				unsigned long to = intern_state(r, dst, dst_length, true);
+				/* successive transitions to the same state are merged */
+				if (r->in_ms_choice) {
+					if (to == r->last_to)
+						r->ms_non_zeros.back() += value;
+					else {
+						r->ms_cols.push_back(to);
+						r->ms_non_zeros.push_back(value);
 					}
-					if (from == last_from) {
-						row_starts[from + 1]++;
-					} else {
-						/* new state rows start after last one */
-						for (; last_from < from; last_from++) {
-							row_starts[last_from + 2] = row_starts[last_from + 1];
-						}
-						row_starts[from + 1]++;
-						last_from = from;
-					}
-					if (choice_index > 0) {
-						choice_starts[choice_index] =
-						choice_starts[choice_index - 1] + choice_size;
-					}
-					choice_size = 0;
-					choice_index++;
+				} else {
+					if (to == r->last_to)
+						r->non_zeros[r->nz_n - 1] += value;
+					else
+						add_successor(r, to, value, error);
 				}
+				r->last_to = to;
 			}
-		}
-
-		if(deadlocks.size() == 0) {
-			choice_starts[choice_index] = choice_starts[choice_index - 1] + choice_size;
-			for (; from+1 < ma->n; from++) {
-				row_starts[from+2] = row_starts[from+1];
-			}
-		}else {
-
-			if (choice_index > 0) {
-				choice_starts[choice_index] =
-				choice_starts[choice_index - 1] + choice_size;
+		} else if (!lexer_token(lx, &src, &src_length)) {
+			/* skip empty lines */
+		} else {
+			Real reward = 0;
+			if (!lexer_token(lx, &act, &act_length)) {
+				fprintf(stderr, COLOR_RED "ERROR at line %ld, expected something like '<src_state> <action> [<reward>]'.\n" COLOR_END, lx->line_no);
+				*error = true;
+				break;
 			}
-			choice_index++;
-			vector<unsigned long>::iterator it;
-			for(it=deadlocks.begin(); it<deadlocks.end(); it++) {
-				from=(*it);
-				to=(*it);
-				non_zeros[nz_index] = 1;
-				cols[nz_index] = to;
-				nz_index++;
-				choice_size=1;
-				for (; last_from < from; last_from++) {
-					row_starts[last_from + 2] = row_starts[last_from + 1];
-				}
-				row_starts[from + 1]++;
-				last_from = from;
-				if (choice_index > 0) {
-					choice_starts[choice_index] =
-					choice_starts[choice_index - 1] + choice_size;
-				}
-				if( mrm ) {
-					// Set zero reward for deadlock states
-					rewards[reward_index] = 0.0;
-					reward_index++;
+			if (!lexer_fraction(lx, &reward))
+				reward = 0;
+			unsigned long from = intern_state(r, src, src_length, false);
+			if (!r->in_block || from != r->from) {
+				flush_state(r, mrm, error);
+				/* test consistency of ma file */
+				if (r->source_nr[from] != NO_STATE) {
+					fprintf(stderr, COLOR_RED "Line %ld: State transitions must be given in continuous order for one state.\n" COLOR_END, lx->line_no);
+					*error = true;
 				}
-				choice_index++;
+				r->source_nr[from] = r->sources.size();
+				r->sources.push_back(from);
+				r->in_block = true;
+				r->from = from;
+				r->has_ps_choice = false;
+				r->has_ms_choice = false;
 			}
-
-			//choice_starts[choice_index] = choice_starts[choice_index - 1] + choice_size;
-			for (; from+1 < ma->n; from++) {
-				row_starts[from+2] = row_starts[from+1];
+			if (token_equals(act, act_length, MARKOV_ACTION)) {
+				if (r->has_ms_choice && !r->has_ps_choice) {
+					fprintf(stderr, COLOR_RED "Line %ld: Markovian state transitions of one state should not be divided.\n" COLOR_END, lx->line_no);
+					*error = true;
+				}
+				r->has_ms_choice = true;
+				r->in_ms_choice = true;
+				r->ms_cols.clear();
+				r->ms_non_zeros.clear();
+				r->ms_reward = reward;
+			} else {
+				r->has_ps_choice = true;
+				r->in_ms_choice = false;
+				add_choice(r, reward, mrm, error);
 			}
+			r->last_to = NO_STATE;
 		}
 	}
-    if(mrm){
-			ma -> max_markovian_reward=max_markovian_reward;  // Set maximum Markovian reward (reward of Markovian states)
-			std::cout<<"Maximum State Reward: "<<max_markovian_reward<<std::endl;
-		}
-
+	if (!*error)
+		flush_state(r, mrm, error);
 }
 
+
 void print_model(SparseMatrix *ma, bool mrm)
 {
 	unsigned long i;
 	unsigned long tau=1;
 	unsigned long state_nr;
 	unsigned long choice_nr;
-	map<unsigned long,string> states_nr = ma->states_nr;
-	unsigned long *row_starts = (unsigned long *) ma->row_counts;
-	unsigned long *rate_starts = (unsigned long *) ma->rate_counts;
-	unsigned long *choice_starts = (unsigned long *) ma->choice_counts;
+	sparse_index *row_starts = ma->row_starts;
+	sparse_index *rate_starts = ma->rate_starts;
+	sparse_index *choice_starts = ma->choice_starts;
 	Real *non_zeros = ma->non_zeros;
 	Real *rewards = ma->rewards;
 	Real *exit_rates = ma->exit_rates;
-	unsigned long *cols = ma->cols;
+	sparse_index *cols = ma->cols;
 	Real prob;
 	bool *initials = ma->initials;
 	bool *goals = ma->goals;
@@ -754,19 +409,19 @@ void print_model(SparseMatrix *ma, bool mrm)
 				for (unsigned long j = r_start; j < r_end; j++) {
 					prob /= exit_rates[j];
 				}
-				printf("%s - %lg -> %s\n",(states_nr.find(state_nr)->second).c_str(),prob,(states_nr.find(cols[i])->second).c_str());
+				printf("%s - %lg -> %s\n",state_name(ma->names, state_nr),prob,state_name(ma->names, cols[i]));
 			}
 		}
 		tau=1;
 		unsigned long i_start = rate_starts[state_nr];
 		unsigned long i_end = rate_starts[state_nr + 1];
 		for (i = i_start; i < i_end; i++) {
-			printf("ExitRate(%s): %lg\n",(states_nr.find(state_nr)->second).c_str(),exit_rates[i]);
+			printf("ExitRate(%s): %lg\n",state_name(ma->names, state_nr),exit_rates[i]);
 		}
 		if(initials[state_nr])
-			printf("initial state %s\n",(states_nr.find(state_nr)->second).c_str());
+			printf("initial state %s\n",state_name(ma->names, state_nr));
 		if(goals[state_nr])
-			printf("goal state %s\n",(states_nr.find(state_nr)->second).c_str());
+			printf("goal state %s\n",state_name(ma->names, state_nr));
 	}
 }
 
@@ -779,9 +434,9 @@ void print_model_info(SparseMatrix *ma)
 	unsigned long n_goal=0;
 	unsigned long n_trans=0;
 
-	unsigned long *row_starts = (unsigned long *) ma->row_counts;
-	//unsigned long *rate_starts = (unsigned long *) ma->rate_counts;
-	unsigned long *choice_starts = (unsigned long *) ma->choice_counts;
+	sparse_index *row_starts = ma->row_starts;
+	//sparse_index *rate_starts = ma->rate_starts;
+	sparse_index *choice_starts = ma->choice_starts;
 
 	unsigned long nd_states=0;
 	for (state_nr = 0; state_nr < ma->n; state_nr++) {
@@ -840,14 +495,13 @@ void witeToDot(SparseMatrix* ma, std::ostream& outStream)
     unsigned long tau=1;
     unsigned long state_nr;
     unsigned long choice_nr;
-    map<unsigned long,string> states_nr = ma->states_nr;
-    unsigned long *row_starts = (unsigned long *) ma->row_counts;
-    unsigned long *rate_starts = (unsigned long *) ma->rate_counts;
-    unsigned long *choice_starts = (unsigned long *) ma->choice_counts;
+    sparse_index *row_starts = ma->row_starts;
+    sparse_index *rate_starts = ma->rate_starts;
+    sparse_index *choice_starts = ma->choice_starts;
     Real *non_zeros = ma->non_zeros;
     Real *rewards = ma->rewards;
     Real *exit_rates = ma->exit_rates;
-    unsigned long *cols = ma->cols;
+    sparse_index *cols = ma->cols;
     Real prob;
     bool *initials = ma->initials;
     bool *goals = ma->goals;
@@ -858,7 +512,7 @@ void witeToDot(SparseMatrix* ma, std::ostream& outStream)
     for (state_nr = 0; state_nr < ma->n; state_nr++) {
         outStream << "\t" << state_nr;
         outStream << " [ ";
-        outStream << "label = \"" << (states_nr.find(state_nr)->second).c_str() << ": ";
+        outStream << "label = \"" << state_name(ma->names, state_nr) << ": ";
         
         outStream << "{";
         // Now print the state labeling to the stream if requested.
@@ -960,8 +614,88 @@ void witeToDot(SparseMatrix* ma, std::ostream& outStream)
     outStream << "}" << std::endl;
 }
 
+
+/**
+* Adds a selfloop to every deadlock state, renumbers the states and hands the
+* buffers of the reader over to a new MA.
+*
+* @param r the reader
+* @param mrm true if rewards are stored
+* @param error error flag
+* @return the new MA
+*/
+static SparseMatrix *build_model(MAReader *r, bool mrm, bool *error)
+{
+	unsigned long num_states = r->names->n;
+	unsigned long num_sources = r->sources.size();
+	unsigned long state_nr;
+	vector<unsigned long> final_nr(num_states);
+
+	/* deadlock states are numbered after all states with transitions */
+	unsigned long deadlock_nr = num_sources;
+	for (unsigned long i = 0; i < num_states; i++) {
+		if (r->source_nr[i] != NO_STATE) {
+			final_nr[i] = r->source_nr[i];
+		} else {
+			final_nr[i] = deadlock_nr++;
+			if (r->found_as_successor[i])
+				cout << "Deadlock: " << state_name(r->names, i) << "    State nr = " << final_nr[i] << endl;
+			add_choice(r, 0.0, mrm, error);
+			add_successor(r, i, 1, error);
+			r->row_ends.push_back(r->choice_n);
+		}
+	}
+	if (!*error && !SparseMatrix_fits(num_states, r->choice_n, r->nz_n))
+		*error = true;
+	if (*error)
+		return NULL;
+	r->choice_starts[r->choice_n] = r->nz_n;
+
+	for (unsigned long i = 0; i < r->nz_n; i++)
+		r->cols[i] = final_nr[r->cols[i]];
+
+	if (num_states > 0)
+		state_names_renumber(r->names, &final_nr[0]);
+	SparseMatrix *model = SparseMatrix_new(num_states, r->names);
+	r->names = NULL;
+	sparse_index *row_starts = model->row_starts;
+	sparse_index *rate_starts = model->rate_starts;
+	for (state_nr = 0; state_nr < num_states; state_nr++) {
+		model->isPS[state_nr] = (state_nr < num_sources) ? r->isPS[state_nr] : true;
+		row_starts[state_nr + 1] = r->row_ends[state_nr];
+		rate_starts[state_nr + 1] = rate_starts[state_nr] + (model->isPS[state_nr] ? 0 : 1);
+	}
+	for (unsigned long i = 0; i < num_states; i++) {
+		model->initials[final_nr[i]] = r->initials[i];
+		model->goals[final_nr[i]] = r->goals[i];
+	}
+
+	/* hand over the buffers */
+	model->ms_n = r->ms_n;
+	model->choices_n = r->choice_n;
+	model->non_zero_n = r->nz_n;
+	model->cols = r->cols;
+	model->non_zeros = r->non_zeros;
+	model->choice_starts = r->choice_starts;
+	model->exit_rates = r->exit_rates;
+	model->rewards = r->rewards;
+	model->max_exit_rate = r->max_exit_rate;
+	model->max_markovian_reward = r->max_markovian_reward;
+	r->cols = NULL;
+	r->non_zeros = NULL;
+	r->choice_starts = NULL;
+	r->exit_rates = NULL;
+	r->rewards = NULL;
+
+	if (mrm)
+		std::cout << "Maximum State Reward: " << model->max_markovian_reward << std::endl;
+
+	return model;
+}
+
 /**
-* Reads MA file @a filename.
+* Reads MA file @a filename. The file is mapped into memory and read in a
+* single pass, the transitions are stored in growable buffers while reading.
 *
 * @param filename file to read MA from
 * @return MA read from file
@@ -969,95 +703,61 @@ void witeToDot(SparseMatrix* ma, std::ostream& outStream)
 SparseMatrix *read_MA_SparseMatrix_file(const char *filename, bool mrm)
 {
 	bool error = false;
-	unsigned long line_no;
 	SparseMatrix *model = NULL;
-	FILE *p = NULL;
-	unsigned long num_states = 0;
-	unsigned long num_ms_states = 0;
-	map<string,unsigned long> states;
-	map<unsigned long,string> states_nr;
-	states.clear();
-	states_nr.clear();
+	Lexer lx;
+	MAReader reader;
+
+	reader.names = StateNames_new();
+	reader.cols = NULL;
+	reader.cols_size = 0;
+	reader.non_zeros = NULL;
+	reader.non_zeros_size = 0;
+	reader.nz_n = 0;
+	reader.choice_starts = NULL;
+	reader.choice_starts_size = 0;
+	reader.rewards = NULL;
+	reader.rewards_size = 0;
+	reader.choice_n = 0;
+	reader.exit_rates = NULL;
+	reader.exit_rates_size = 0;
+	reader.ms_n = 0;
+	reader.max_exit_rate = 0;
+	reader.max_markovian_reward = 0;
+	reader.in_block = false;
+	reader.in_ms_choice = false;
+	reader.last_to = NO_STATE;
 
 	if (filename == NULL) {
 		fprintf(stderr, COLOR_RED "Called with filename == NULL\n" COLOR_END);
 		error = true;
 	}
-	//cout << "first pass" << endl;
-	/* first pass on file: create a hash table with state names and get number of states. */
-	if (!error) {
-		p = fopen(filename, "r");
-		if (p == NULL) {
-			fprintf(stderr, COLOR_RED "Could not open file \"%s\"\n" COLOR_END, filename);
-			error = true;
-		}
-	}
-
-	line_no = 1;
-
-	if(!error)
-		read_states(&line_no, &error, p, filename, &num_states, &states, &states_nr);
-
-	if (p != NULL) {
-		rewind(p);
-	}
-
-	line_no = 1;
-	//cout << "deadlock pass" << endl;
-	vector<unsigned long> deadlocks;
-	deadlocks.clear();
-	// check for deadlock states and add a selfloop
-	if(!error)
-		check_dedlocks(&line_no, &error, p, filename, &num_states, &states, &states_nr, &deadlocks);
-
-	if (p != NULL) {
-		rewind(p);
+	if (!error && !Lexer_open(&lx, filename)) {
+		fprintf(stderr, COLOR_RED "Could not open file \"%s\"\n" COLOR_END, filename);
+		error = true;
 	}
 
-	line_no = 1;
-
-    //cout << "reserve memory" << endl;
 	if (!error) {
-		model = SparseMatrix_new(num_states, states, states_nr); /* create MA model and reserve state memory */
+		read_header(&reader, &error, &lx, filename);
+		if (!error)
+			read_transitions(&reader, &error, &lx, mrm);
+		Lexer_close(&lx);
 	}
-	//cout << "second pass" << endl;
-	/* second pass: count probabilistic states and store initial and goal states */
-	line_no = 1;
-	if(!error)
-		init_states(&line_no, &error, p, filename, &num_ms_states, states, model, deadlocks);
 
-	if (!error) {
-		rewind(p);
-	}
-	//cout << "third pass" << endl;
-	/* third pass on file: than reserve transition memory and store exit rates */
-	line_no = 1;
+	if (!error)
+		model = build_model(&reader, mrm, &error);
 
-	if (!error) {
-		reserve_transition_memory(&line_no, &error, p, filename, model, deadlocks, mrm);
-	}
+	/* free whatever was not handed over to the MA */
+	free(reader.cols);
+	free(reader.non_zeros);
+	free(reader.choice_starts);
+	free(reader.rewards);
+	free(reader.exit_rates);
+	StateNames_free(reader.names);
 
 	if (!error) {
-		rewind(p);
-	}
-	//cout << "fourth pass" << endl;
-	/* fourth pass on file: save transitions */
-	read_transitions(&line_no, &error, p, filename, model, deadlocks,mrm);
-
-	if (p != NULL) {
-		fclose(p);
-	}
-
-	if (error) {
-		/* free the halfly-complete MA structure if an error has occured */
-		SparseMatrix_free(model);
-		model = NULL;
-	}else{
 		//print_model(model,mrm);
 		print_model_info(model);
 	}
 
-	//print_model(model,mrm);
-
 	return model;
 }
@@ -33,138 +33,148 @@
 #include <map>
 #include <string>
 
+#include "lexer.h"
+
 using namespace std;
 
 /**
-* Read number of states and create a hash table for state names.
+* Goes to the first line after "#TRANSITIONS".
 *
-* @param line_no line number in file (should be 1 before)
 * @param error error flag
-* @param p MA file
-* @param filename filename of MA file
-* @param num_states will store number of states here
-* @param states will map the state names to state numbers 
+* @param lx lexer on the IMC file
+* @param filename filename of IMC file
 */
-static void read_states(unsigned long *line_no, bool *error, FILE *p, const char *filename, unsigned long *num_states, map<string,unsigned long> *states, map<unsigned long,string> *states_nr) 
+static void skip_to_transitions(bool *error, Lexer *lx, const char *filename)
 {
-	char s[MAX_LINE_LENGTH];
-	unsigned long state_nr = 0;
-	pair<map<string,unsigned long>::iterator,bool> ret;
-	char state[MAX_LINE_LENGTH];
-	char act[MAX_LINE_LENGTH];
-	map<string ,unsigned long> tmp;
-	map<unsigned long, string> tmp_nr;
+	const char *token;
+	size_t length;
 
-	/* go to Transitions */
-	if (!*error) {
-		if(fgets(s, MAX_LINE_LENGTH, p) == 0)
-		{
-			fprintf(stderr, "Reading line %ld of file \"%s\" failed.\n",*line_no, filename);
+	lexer_rewind(lx);
+	while (!*error) {
+		if (lexer_eof(lx)) {
+			fprintf(stderr, "Reading line %ld of file \"%s\" failed.\n", lx->line_no, filename);
 			*error = true;
+		} else if (lexer_token(lx, &token, &length) && token_equals(token, length, TRANSITIONS)) {
+			lexer_next_line(lx);
+			break;
+		} else {
+			lexer_next_line(lx);
 		}
-		++(*line_no);
-		sscanf(s, "%s", state);
-		while(strcmp(state,TRANSITIONS) != 0 && !*error) {
-			if(fgets(s, MAX_LINE_LENGTH, p) == 0)
-			{
-				fprintf(stderr, "Reading line %ld of file \"%s\" failed.\n",*line_no, filename);
-				*error = true;
-			}
-			sscanf(s, "%s", state);
-			++(*line_no);
+	}
+}
+
+/**
+* Reads a transition line "src dst rate" or "src dst action" and goes to the
+* next line.
+*
+* @param lx lexer on the IMC file
+* @param src source state
+* @param dst destination state
+* @param is_ms true if the transition is Markovian
+* @param rate the rate of a Markovian transition
+* @return false if the line is malformed
+*/
+static bool read_transition_line(Lexer *lx, string *src, string *dst, bool *is_ms, Real *rate)
+{
+	const char *token;
+	size_t length;
+	bool ok = false;
+
+	if (lexer_token(lx, &token, &length)) {
+		src->assign(token, length);
+		if (lexer_token(lx, &token, &length)) {
+			dst->assign(token, length);
+			*is_ms = lexer_real(lx, rate);
+			ok = *is_ms || lexer_token(lx, &token, &length);
 		}
 	}
-	
-	
+	lexer_next_line(lx);
+	return ok;
+}
+
+/**
+* Goes to the next line which is not empty.
+*
+* @param lx lexer on the IMC file
+* @return false if there are no more lines
+*/
+static bool skip_empty_lines(Lexer *lx)
+{
+	while (!lexer_eof(lx) && lexer_eol(lx))
+		lexer_next_line(lx);
+	return !lexer_eof(lx);
+}
+
+/**
+* Read number of states and create a hash table for state names.
+*
+* @param error error flag
+* @param lx lexer on the IMC file
+* @param filename filename of IMC file
+* @param num_states will store number of states here
+* @param names will map the state names to state numbers
+*/
+static void read_states(bool *error, Lexer *lx, const char *filename, unsigned long *num_states, StateNames *names)
+{
+	bool inserted;
+	const char *token;
+	size_t length;
+
+	/* go to Transitions */
+	skip_to_transitions(error, lx, filename);
+
 	/* TODO: also check lines */
-	while (fgets(s, MAX_LINE_LENGTH, p) != NULL && !*error) {
-		sscanf(s, "%s%s", state, act);
-		ret=tmp.insert(pair<string,unsigned long>(state,state_nr));
-		if(ret.second == true){
-			tmp_nr.insert(pair<unsigned long,string>(state_nr,state));
-			state_nr++;
-		} 
-		++(*line_no);
+	while (!*error && skip_empty_lines(lx)) {
+		lexer_token(lx, &token, &length);
+		state_names_insert(names, token, length, &inserted);
+		lexer_next_line(lx);
 	}
-	
-	(*num_states) = state_nr;	
-	(*states)=tmp;
-	(*states_nr)=tmp_nr;
+
+	(*num_states) = names->n;
 }
 
 /**
 * Check for deadlocks and add selfloop.
 *
-* @param line_no line number in file (should be 1 before)
 * @param error error flag
-* @param p MA file
-* @param filename filename of MA file
+* @param lx lexer on the IMC file
+* @param filename filename of IMC file
 * @param num_states will store number of states here
-* @param states will map the state names to state numbers 
+* @param names will map the state names to state numbers
 */
-static void check_dedlocks(unsigned long *line_no, bool *error, FILE *p, const char *filename, unsigned long *num_states, map<string,unsigned long> *states, map<unsigned long,string> *states_nr) 
+static void check_dedlocks(bool *error, Lexer *lx, const char *filename, unsigned long *num_states, StateNames *names)
 {
-	char s[MAX_LINE_LENGTH];
-	unsigned long state_nr = (*num_states);
-	pair<map<string,unsigned long>::iterator,bool> ret;
-	char state[MAX_LINE_LENGTH];
-	char star[MAX_LINE_LENGTH];
-	map<string ,unsigned long> tmp=*states;
-	map<unsigned long, string> tmp_nr=*states_nr;
+	bool inserted;
+	const char *token;
+	size_t length;
 
 	/* go to Transitions */
-	if (!*error) {
-		if(fgets(s, MAX_LINE_LENGTH, p) == 0)
-		{
-			fprintf(stderr, "Reading line %ld of file \"%s\" failed.\n",*line_no, filename);
-			*error = true;
-		}
-		++(*line_no);
-		sscanf(s, "%s", state);
-		while(strcmp(state,TRANSITIONS) != 0 && !*error) {
-			if(fgets(s, MAX_LINE_LENGTH, p) == 0)
-			{
-				fprintf(stderr, "Reading line %ld of file \"%s\" failed.\n",*line_no, filename);
-				*error = true;
-			}
-			sscanf(s, "%s", state);
-			++(*line_no);
-		}
-	}
-	
-	
+	skip_to_transitions(error, lx, filename);
+
 	/* TODO: also check lines */
-	while (fgets(s, MAX_LINE_LENGTH, p) != NULL && !*error) {
-		if (s[0] == '*') {
-			sscanf(s, "%s%s", star, state);
-			ret=tmp.insert(pair<string,unsigned long>(state,state_nr));
-			if(ret.second == true){
-				tmp_nr.insert(pair<unsigned long,string>(state_nr,state));
-				state_nr++;
-			} 
-			++(*line_no);
-		} else {
-			++(*line_no);
+	for (; !*error && !lexer_eof(lx); lexer_next_line(lx)) {
+		if (*lx->pos == '*') {
+			lx->pos++;
+			if (lexer_token(lx, &token, &length))
+				state_names_insert(names, token, length, &inserted);
 		}
 	}
-	
-	(*num_states) = state_nr;	
-	(*states)=tmp;
-	(*states_nr)=tmp_nr;
+
+	(*num_states) = names->n;
 }
 
-static void init_states(unsigned long *line_no, bool *error, FILE *p, const char *filename, unsigned long *num_ms_states, map<string,unsigned long> states, SparseMatrix *ma) {
-	char src[MAX_LINE_LENGTH];
-	char dst[MAX_LINE_LENGTH];
-	char act[MAX_LINE_LENGTH];
-	char s[MAX_LINE_LENGTH];
+static void init_states(bool *error, Lexer *lx, const char *filename, unsigned long *num_ms_states, SparseMatrix *ma) {
+	string src;
+	string dst;
+	const char *token;
+	size_t length;
 	unsigned long from;
 	unsigned long last_from = 0;
 	unsigned long ms_states=0;
 	bool *isPS;
 	bool isMs=false;
 	Real rate;
-	
+
 	if (!*error) {
 		bool *initials = (bool *) ma->initials;
 		bool *goals = (bool *)ma->goals;
@@ -176,89 +186,65 @@ static void init_states(unsigned long *line_no, bool *error, FILE *p, const char
 			goals[from]=false;
 			isPS[from]=false;
 		}
-		
+
 		/* store initials and goals */
-		if(fgets(s, MAX_LINE_LENGTH, p) == 0)
-		{
-			fprintf(stderr, "Reading line %ld of file \"%s\" failed.\n",*line_no, filename);
-			*error = true;
-		}
-		++(*line_no);
-		sscanf(s, "%s", src);
-		if(strcmp(src,INITIALS) != 0 && !*error) {
+		lexer_rewind(lx);
+		if(!lexer_token(lx, &token, &length) || !token_equals(token, length, INITIALS)) {
 			fprintf(stderr,"No declaration of initial states.\n");
 			*error = true;
 		} else {
-			++(*line_no);
-			if(fgets(s, MAX_LINE_LENGTH, p) == 0)
-			{
-				fprintf(stderr, "Reading line %ld of file \"%s\" failed.\n",*line_no, filename);
-				*error = true;
-			}
-			sscanf(s, "%s", src);
-			while(strcmp(src,GOALS) != 0 && !*error)
-			{
-				from=states.find(src)->second;
-				initials[from]=true;
-				if(fgets(s, MAX_LINE_LENGTH, p) == 0)
-				{
-					fprintf(stderr, "Reading line %ld of file \"%s\" failed.\n",*line_no, filename);
-					*error = true;
-				}
-				sscanf(s, "%s", src);
-				++(*line_no);
-			}
-			if(fgets(s, MAX_LINE_LENGTH, p) == 0)
-			{
-				fprintf(stderr, "Reading line %ld of file \"%s\" failed.\n",*line_no, filename);
-				*error = true;
-			}
-			sscanf(s, "%s", src);
-			while(strcmp(src,TRANSITIONS) != 0 && !*error) {
-				from=states.find(src)->second;
-				goals[from]=true;
-				if(fgets(s, MAX_LINE_LENGTH, p) == 0)
-				{
-					fprintf(stderr, "Reading line %ld of file \"%s\" failed.\n",*line_no, filename);
+			bool in_goals = false;
+			while (!*error) {
+				if (!lexer_next_line(lx)) {
+					fprintf(stderr, "Reading line %ld of file \"%s\" failed.\n", lx->line_no, filename);
 					*error = true;
+				} else if (!lexer_token(lx, &token, &length)) {
+					/* skip empty lines */
+				} else if (!in_goals && token_equals(token, length, GOALS)) {
+					in_goals = true;
+				} else if (in_goals && token_equals(token, length, TRANSITIONS)) {
+					lexer_next_line(lx);
+					break;
+				} else {
+					from=state_names_find(ma->names, token, length);
+					if (from == NO_STATE_NAME) {
+						fprintf(stderr, "Line %ld: Unknown state \"%.*s\".\n", lx->line_no, (int) length, token);
+						*error = true;
+					} else if (in_goals)
+						goals[from]=true;
+					else
+						initials[from]=true;
 				}
-				sscanf(s, "%s", src);
-				++(*line_no);
 			}
 		}
 	}
-	
-	while (!*error && (fgets(s, MAX_LINE_LENGTH, p) != NULL)) {
-		isMs=false;
-		if (sscanf(s, "%s%s%lf", src, dst, &rate) != 3) { /* check if all values are returned */
-			if(sscanf(s, "%s%s%s", src, dst, act) != 3)
-				*error = true;
+
+	while (!*error && skip_empty_lines(lx)) {
+		unsigned long line_no = lx->line_no;
+		if (!read_transition_line(lx, &src, &dst, &isMs, &rate)) { /* check if all values are returned */
+			*error = true;
 		} else {
-			isMs=true;
-		}
-		if(!*error) {
-			from=states.find(src)->second;
+			from=state_names_find(ma->names, src.c_str(), src.size());
 			/* test consistency of ma file */
 			if (from < last_from) {
-				fprintf(stderr, "Line %ld: State transitions must be given in continous order for one state.\n", *line_no);
-				*error = true;		
+				fprintf(stderr, "Line %ld: State transitions must be given in continous order for one state.\n", line_no);
+				*error = true;
 			} else {
 				if(!isMs)
 					isPS[from]=true;
-				
+
 				last_from = from;
 			}
 		}
-		++(*line_no);
 	}
-	
+
 	if(!*error) {
 		for(from=0; from<ma->n; from++) {
 			if(!isPS[from])
 				ms_states++;
 		}
 	}
-	
+
 	if(!*error) {
 		(*num_ms_states) = ms_states;
 		ma->ms_n = ms_states;
@@ -271,79 +257,55 @@ static void init_states(unsigned long *line_no, bool *error, FILE *p, const char
 /**
 * Allocate memory needed for MA data structures and stores rates for Markovian states.
 *
-* @param line_no line number in file
 * @param error error flag
-* @param p MA file
+* @param lx lexer on the IMC file
+* @param filename filename of IMC file
 * @param model MA for which allocations will be done
 */
-static void reserve_transition_memory(unsigned long *line_no, bool *error, FILE *p, const char *filename, SparseMatrix *model) {
-	char s[MAX_LINE_LENGTH];
-	char src[MAX_LINE_LENGTH];
-	char dst[MAX_LINE_LENGTH];
-	char act[MAX_LINE_LENGTH];
+static void reserve_transition_memory(bool *error, Lexer *lx, const char *filename, SparseMatrix *model) {
+	string src;
+	string dst;
 	Real exit_rate=0;
 	unsigned long exit_index = 0;
 	unsigned long num_choice = 0;
 	unsigned long num_non_zeros = 0;
 	bool isMs = false;
 	bool isMs_last = false;
-	Real *exit_rates;
-	unsigned long *rate_starts;
-	unsigned long from;
+	Real *exit_rates = NULL;
+	sparse_index *rate_starts = NULL;
+	unsigned long from = 0;
 	unsigned long last_from = 0;
-	map<string ,unsigned long> states;
-	bool *isPS;
+	bool *isPS = NULL;
 	Real rate;
 	bool first=true;
 
 	/* go to Transitions */
-	if (!*error) {
-		if(fgets(s, MAX_LINE_LENGTH, p) == 0)
-		{
-			fprintf(stderr, "Reading line %ld of file \"%s\" failed.\n",*line_no, filename);
-			*error = true;
-		}
-		++(*line_no);
-		sscanf(s, "%s", src);
-		while(strcmp(src,TRANSITIONS) != 0 && !*error) {
-			if(fgets(s, MAX_LINE_LENGTH, p) == 0)
-			{
-				fprintf(stderr, "Reading line %ld of file \"%s\" failed.\n",*line_no, filename);
-				*error = true;
-			}
-			sscanf(s, "%s", src);
-			++(*line_no);
-		}
-	}
+	skip_to_transitions(error, lx, filename);
 
 	if (!*error) {
 		exit_rates = model->exit_rates;
-		rate_starts = (unsigned long *) model->rate_counts;
-		states = model->states;
+		rate_starts = model->rate_starts;
 		isPS = model->isPS;
 	}
-	
 
-	while (!*error && (fgets(s, MAX_LINE_LENGTH, p) != NULL)) {
-		isMs=false;
-		if (sscanf(s, "%s%s%lf", src, dst, &rate) != 3) { /* check if all values are returned */
-			if (sscanf(s, "%s%s%s", src, dst, act) != 3)
-				*error = true;
-		} else {
-			isMs = true;
+
+	while (!*error && skip_empty_lines(lx)) {
+		unsigned long line_no = lx->line_no;
+		if (!read_transition_line(lx, &src, &dst, &isMs, &rate)) { /* check if all values are returned */
+			*error = true;
 		}
 		if(!*error)
 		{
-			from=states.find(src)->second;
+			from=state_names_find(model->names, src.c_str(), src.size());
 			/* test consistency of ma file */
 			if (from < last_from) {
-				fprintf(stderr, "Line %ld: State transitions must be given in continous order for one state.\n", *line_no);
+				fprintf(stderr, "Line %ld: State transitions must be given in continous order for one state.\n", line_no);
 				*error = true;
-			} else if(from == last_from){	
+			} else if(from == last_from){
 				if(isMs && !isPS[from]) {
 					exit_rate += rate;
 				}
-				
+
 				if(isPS[from]) {
 					num_choice++;
 					first=false;
@@ -351,7 +313,7 @@ static void reserve_transition_memory(unsigned long *line_no, bool *error, FILE
 					num_choice++;
 					first=false;
 				}
-				
+
 				isMs_last = isMs;
 				last_from = from;
 				/* probabilistic transitions are choosen before markovian transitions */
@@ -372,25 +334,23 @@ static void reserve_transition_memory(unsigned long *line_no, bool *error, FILE
 						rate_starts[last_from + 1] = rate_starts[last_from + 0];
 					}
 				}
-				
+
 				exit_rate=0;
 				isMs_last = isMs;
-				
+
 				if(isMs && !isPS[from]) {
 					exit_rate += rate;
 				}
-				
+
 				/* probabilistic transitions are choosen before markovian transitions */
 				if((isPS[from] && !isMs) || (!isPS[from] && isMs)) {
 					num_non_zeros++;
 					num_choice++;
 				}
-				
+
 				last_from = from;
 			}
 		}
-		//++(*line_no);
-		++(*line_no);
 	}
 	/* probabilistic transitions are choosen before markovian transitions */
 	if((isMs)) {
@@ -404,13 +364,15 @@ static void reserve_transition_memory(unsigned long *line_no, bool *error, FILE
 			rate_starts[last_from + 1] = rate_starts[last_from + 0];
 		}
 	}
-	
+
 	/* now allocate the memory needed */
+	if (!*error && !SparseMatrix_fits(model->n, num_choice, num_non_zeros))
+		*error = true;
 	if (!*error) {
-		unsigned long * choice_starts = (unsigned long *) calloc((size_t) (num_choice + 1), sizeof(unsigned long));
+		sparse_index *choice_starts = (sparse_index *) calloc((size_t) (num_choice + 1), sizeof(sparse_index));
 		Real * non_zeros = (Real *) malloc(num_non_zeros * sizeof(Real));
-		unsigned long * cols = (unsigned long *) malloc(num_non_zeros * sizeof(unsigned long));
-		model->choice_counts = (unsigned char *) choice_starts;
+		sparse_index *cols = (sparse_index *) malloc(num_non_zeros * sizeof(sparse_index));
+		model->choice_starts = choice_starts;
 		model->non_zeros = non_zeros;
 		model->cols = cols;
 	}
@@ -419,73 +381,52 @@ static void reserve_transition_memory(unsigned long *line_no, bool *error, FILE
 /**
 * Reads the transitions of a MA.
 *
-* @param line_no line number in file (should be 1 before)
 * @param error error flag
-* @param p MA file
-* @param filename of MA file
+* @param lx lexer on the IMC file
+* @param filename of IMC file
 * @param ma the transitions shall be added
 */
-static void read_transitions(unsigned long *line_no, bool *error, FILE *p, const char *filename, SparseMatrix *ma) {
+static void read_transitions(bool *error, Lexer *lx, const char *filename, SparseMatrix *ma) {
 	unsigned long choice_index = 0;
 	unsigned long choice_size = 0;
 	//unsigned long choice_size_old = 0;
 	unsigned long nz_index = 0;
-	char src[MAX_LINE_LENGTH];
-	unsigned long from;
+	string src;
+	string dst;
+	unsigned long from = 0;
 	unsigned long last_from = 0;
-	char s[MAX_LINE_LENGTH];
-	char dst[MAX_LINE_LENGTH];
 	unsigned long to;
-	char act[MAX_LINE_LENGTH];
 	bool bad=false;
 	bool first=true;
+	bool isMs;
 	Real rate;
 
 	if (!*error) {
 		Real *non_zeros = ma->non_zeros;
-		unsigned long *cols = ma->cols;
-		unsigned long *choice_starts = (unsigned long *) ma->choice_counts;
-		unsigned long *row_starts = (unsigned long *) ma->row_counts;
-		map<string ,unsigned long> states = ma->states;
+		sparse_index *cols = ma->cols;
+		sparse_index *choice_starts = ma->choice_starts;
+		sparse_index *row_starts = ma->row_starts;
+		const StateNames *names = ma->names;
 		bool *isPS = ma->isPS;
-		
+
 		/* go to Transitions */
-		if (!*error) {
-			if(fgets(s, MAX_LINE_LENGTH, p) == 0)
-			{
-				fprintf(stderr, "Reading line %ld of file \"%s\" failed.\n",*line_no, filename);
-				*error = true;
-			}
-			++(*line_no);
-			sscanf(s, "%s", src);
-			while(strcmp(src,TRANSITIONS) != 0 && !*error) {
-				if(fgets(s, MAX_LINE_LENGTH, p) == 0)
-				{
-					fprintf(stderr, "Reading line %ld of file \"%s\" failed.\n",*line_no, filename);
-					*error = true;
-				}
-				sscanf(s, "%s", src);
-				++(*line_no);
-			}
-		}
-		
+		skip_to_transitions(error, lx, filename);
 
-		while (fgets(s, MAX_LINE_LENGTH, p) != NULL) {
+		while (!*error && skip_empty_lines(lx)) {
 			bad=false;
-			if (sscanf(s, "%s%s%lf", src, dst, &rate) != 3) { /* check if all values are returned */
-				if (sscanf(s, "%s%s%s", src, dst, act) != 3)
-					*error = true;
-			} else {
-				int tmp=states.find(src)->second;
+			if (!read_transition_line(lx, &src, &dst, &isMs, &rate)) { /* check if all values are returned */
+				*error = true;
+			} else if (isMs) {
+				unsigned long tmp=state_names_find(names, src.c_str(), src.size());
 				/* probabilistic transitions are choosen before markovian transitions */
 				if(isPS[tmp])
 					bad=true;
 			}
 			if(!bad && !*error)
 			{
-				from=states.find(src)->second;
+				from=state_names_find(names, src.c_str(), src.size());
 				if(from==last_from) {
-					to=states.find(dst)->second;
+					to=state_names_find(names, dst.c_str(), dst.size());
 					if(!isPS[from]) {
 						non_zeros[nz_index] = rate;
 						choice_size++;
@@ -525,15 +466,15 @@ static void read_transitions(unsigned long *line_no, bool *error, FILE *p, const
 						choice_size = 0;
 						choice_index++;
 					}
-					
+
 					/* new state rows start after last one */
 					for (; last_from < from; last_from++) {
 						row_starts[last_from + 2] = row_starts[last_from + 1];
 					}
 					last_from = from;
 					row_starts[from + 1]++;
-					
-					to=states.find(dst)->second;
+
+					to=state_names_find(names, dst.c_str(), dst.size());
 					if(!isPS[from]) {
 						non_zeros[nz_index] = rate;
 						choice_size++;
@@ -551,11 +492,12 @@ static void read_transitions(unsigned long *line_no, bool *error, FILE *p, const
 			row_starts[from+2] = row_starts[from+1];
 		}
 	}
-	
+
 }
 
 /**
-* Reads MA file @a filename.
+* Reads IMC file @a filename. The file is mapped into memory once and each
+* pass starts again at its beginning.
 *
 * @param filename file to read MA from
 * @return MA read from file
@@ -563,95 +505,64 @@ static void read_transitions(unsigned long *line_no, bool *error, FILE *p, const
 SparseMatrix *read_IMC_SparseMatrix_file(const char *filename)
 {
 	bool error = false;
-	unsigned long line_no;
 	SparseMatrix *model = NULL;
-	FILE *p = NULL;
+	Lexer lx;
 	unsigned long num_states = 0;
 	unsigned long num_ms_states = 0;
-	map<string,unsigned long> states;
-	map<unsigned long,string> states_nr;
-	
+	StateNames *names;
+
 	if (filename == NULL) {
 		fprintf(stderr, "Called with filename == NULL\n");
 		error = true;
 	}
-	
-	/* first pass on file: create a hash table with state names and get number of states. */
-	if (!error) {
-		p = fopen(filename, "r");
-		if (p == NULL) {
-			fprintf(stderr, "Could not open file \"%s\"\n", filename);
-			error = true;
-		}
-	}
-	
-	line_no = 1;
-	
-	if(!error)
-		read_states(&line_no, &error, p, filename, &num_states, &states, &states_nr);
-	
-	if (p != NULL) {
-		rewind(p);
+
+	if (!error && !Lexer_open(&lx, filename)) {
+		fprintf(stderr, "Could not open file \"%s\"\n", filename);
+		error = true;
 	}
-	
-	line_no = 1;
-	
+
+	if (error)
+		return NULL;
+
+	/* first pass on file: create a hash table with state names and get number of states. */
+	names = StateNames_new();
+	read_states(&error, &lx, filename, &num_states, names);
+
 	// check for deadlock states and add a selfloop
 	if(!error)
-		check_dedlocks(&line_no, &error, p, filename, &num_states, &states, &states_nr);
-	
-	if (p != NULL) {
-		rewind(p);
-	}
-	
-	if (!error) {
-		model = SparseMatrix_new(num_states, states, states_nr); /* create MA model and reserve state memory */
-	}
-	
+		check_dedlocks(&error, &lx, filename, &num_states, names);
+
 	if (!error) {
-		model = SparseMatrix_new(num_states, states, states_nr); /* create MA model and reserve state memory */
+		model = SparseMatrix_new(num_states, names); /* create MA model and reserve state memory */
+	} else {
+		StateNames_free(names);
 	}
 
-	
 	/* second pass: count probabilistic states and store initial and goal states */
-	line_no = 1;
 	if(!error)
-		init_states(&line_no, &error, p, filename, &num_ms_states, states, model); 
-	
-	if (!error) {
-		rewind(p);
-	}
+		init_states(&error, &lx, filename, &num_ms_states, model);
 
-	
 	/* third pass on file: than reserve transition memory and store exit rates */
-	line_no = 1;
-	
 	if (!error) {
-		reserve_transition_memory(&line_no, &error, p, filename, model);
+		reserve_transition_memory(&error, &lx, filename, model);
 	}
-	
-	if (!error) {
-		rewind(p);
-	}
-	
-	
+
 	/* fourth pass on file: save transitions */
-	read_transitions(&line_no, &error, p, filename, model);
-	
-	if (p != NULL) {
-		fclose(p);
-	}
-	
+	read_transitions(&error, &lx, filename, model);
+
+	Lexer_close(&lx);
+
 	if (error) {
 		/* free the halfly-complete MDP structure if an error has occured */
 		SparseMatrix_free(model);
+		delete model;
 		model = NULL;
 	}else{
 		//print_model(model);
 		print_model_info(model);
 	}
-	
+
 	//print_model(model);
-	
+
 	return model;
 }
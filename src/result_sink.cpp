@@ -0,0 +1,147 @@
+/**
+* IMCA is a analyzing tool for unbounded reachability probabilities, expected-
+* time, and long-run averages for Interactive Markov Chains and Markov Automata.
+* Copyright (C) RWTH Aachen, 2012
+*				UTwente, 2013
+* 	Author: Dennis Guck
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*
+* Source description:
+*	Buffered CSV or JSON lines output of time series and state vectors.
+*	A CSV sink starts with a header line, a JSON lines sink writes one
+*	object per record.
+*/
+
+#include "result_sink.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+* Writes a state name as a CSV field, quoted if needed.
+*
+* @param file the output
+* @param name the state name
+*/
+static void write_csv_name(FILE *file, const char *name)
+{
+	if (strpbrk(name, ",\"\n") == NULL) {
+		fputs(name, file);
+		return;
+	}
+	fputc('"', file);
+	for (const char *c = name; *c != '\0'; c++) {
+		if (*c == '"')
+			fputc('"', file);
+		fputc(*c, file);
+	}
+	fputc('"', file);
+}
+
+/**
+* Writes a state name as a JSON string.
+*
+* @param file the output
+* @param name the state name
+*/
+static void write_json_name(FILE *file, const char *name)
+{
+	fputc('"', file);
+	for (const char *c = name; *c != '\0'; c++) {
+		if (*c == '"' || *c == '\\')
+			fputc('\\', file);
+		if ((unsigned char) *c < 0x20)
+			fprintf(file, "\\u%04x", *c);
+		else
+			fputc(*c, file);
+	}
+	fputc('"', file);
+}
+
+ResultSink* ResultSink_new(const char *path, bool json, bool initials, bool vector)
+{
+	ResultSink *sink = (ResultSink *) malloc(sizeof(ResultSink));
+
+	if (sink == NULL)
+		return NULL;
+	sink->is_stdout = (strcmp(path, "-") == 0);
+	sink->file = sink->is_stdout ? stdout : fopen(path, "w");
+	if (sink->file == NULL) {
+		free(sink);
+		return NULL;
+	}
+	sink->json = json;
+	sink->initials = initials;
+	sink->vector = vector;
+	sink->buffer = NULL;
+	/* the console output stays line buffered */
+	if (!sink->is_stdout) {
+		sink->buffer = (char *) malloc(RESULT_SINK_BUFFER_SIZE);
+		if (sink->buffer != NULL)
+			setvbuf(sink->file, sink->buffer, _IOFBF, RESULT_SINK_BUFFER_SIZE);
+	}
+	if (!json)
+		fputs("analysis,objective,time,state,value\n", sink->file);
+	return sink;
+}
+
+void ResultSink_free(ResultSink *sink)
+{
+	if (sink == NULL)
+		return;
+	if (sink->is_stdout)
+		fflush(sink->file);
+	else
+		fclose(sink->file);
+	free(sink->buffer);
+	free(sink);
+}
+
+void ResultSink_write(ResultSink *sink, const char *analysis, bool max, Real time, const char *state, Real value)
+{
+	FILE *file = sink->file;
+	const char *objective = max ? "max" : "min";
+
+	if (sink->json) {
+		fprintf(file, "{\"analysis\":\"%s\",\"objective\":\"%s\",\"time\":%.10g,", analysis, objective, time);
+		if (state != NULL) {
+			fputs("\"state\":", file);
+			write_json_name(file, state);
+			fputc(',', file);
+		}
+		fprintf(file, "\"value\":%.10g}\n", value);
+	} else {
+		fprintf(file, "%s,%s,%.10g,", analysis, objective, time);
+		if (state != NULL)
+			write_csv_name(file, state);
+		fprintf(file, ",%.10g\n", value);
+	}
+}
+
+void ResultSink_values(ResultSink *sink, const SparseMatrix *ma, const char *analysis, bool max, Real time,
+		const Real *u, unsigned long width, unsigned long slot, Real optimum, bool last)
+{
+	bool all = last && sink->vector;
+
+	ResultSink_write(sink, analysis, max, time, NULL, optimum);
+	if (!all && !sink->initials)
+		return;
+	for (unsigned long state_nr = 0; state_nr < ma->n; state_nr++) {
+		if (all || ma->initials[state_nr])
+			ResultSink_write(sink, analysis, max, time, state_name(ma->names, state_nr), u[width*state_nr + slot]);
+	}
+}
@@ -32,6 +32,7 @@
 
 #include "sccs2.h"
 #include "sccs.h"
+#include "sccs_parallel.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -47,170 +48,400 @@
 
 #include "debug.h"
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 using namespace std;
 
 /**
- * test if element is in vector
- * 
+ * Creates a search of @a ma. Both arrays are updated during the search
+ * according to @a rule.
+ *
+ * @param ma the MA
+ * @param bad_states states left out of the search
+ * @param bad_transitions choices left out of the search
+ * @param rule how bad states and transitions grow
+ * @return new search, nothing visited yet
  */
-bool isIn_copy(vector<unsigned long> set, unsigned long element)
-{
-    vector<unsigned long>::const_iterator e;
-    for(e=set.begin(); e != set.end(); e++)
-    {
-        if((*e) == element)
-            return true;
+SCCSearch* SCCSearch_new(const SparseMatrix *ma, bool *bad_states, bool *bad_transitions, SCCBadRule rule){
+    unsigned long n = ma->n > 0 ? ma->n : 1;
+    SCCSearch *search = (SCCSearch *) malloc(sizeof(SCCSearch));
+    search->ma = ma;
+    search->bad_states = bad_states;
+    search->bad_transitions = bad_transitions;
+    search->rule = rule;
+    search->index = (unsigned long *) malloc(n * sizeof(unsigned long));
+    search->lowlink = (unsigned long *) malloc(n * sizeof(unsigned long));
+    search->on_stack = (bool *) calloc(n, sizeof(bool));
+    search->next_choice = (sparse_index *) malloc(n * sizeof(sparse_index));
+    search->next_transition = (sparse_index *) malloc(n * sizeof(sparse_index));
+    search->bad_choices = (unsigned long *) malloc(n * sizeof(unsigned long));
+    search->scc_stack = (sparse_index *) malloc(n * sizeof(sparse_index));
+    search->call_stack = (sparse_index *) malloc(n * sizeof(sparse_index));
+    search->retry = (sparse_index *) malloc(n * sizeof(sparse_index));
+    search->retry_n = 0;
+    search->in_retry = (bool *) calloc(n, sizeof(bool));
+    search->completed = NULL;
+    search->completed_starts = NULL;
+    search->completed_n = 0;
+    SCCSearch_reset(search);
+    return search;
+}
+
+/**
+ * @param search the search to be freed
+ */
+void SCCSearch_free(SCCSearch *search){
+    if(search == NULL)
+        return;
+    free(search->index);
+    free(search->lowlink);
+    free(search->on_stack);
+    free(search->next_choice);
+    free(search->next_transition);
+    free(search->bad_choices);
+    free(search->scc_stack);
+    free(search->call_stack);
+    free(search->retry);
+    free(search->in_retry);
+    free(search);
+}
+
+/**
+ * Forgets all visited states, the bad states and transitions are kept.
+ *
+ * @param search the search
+ */
+void SCCSearch_reset(SCCSearch *search){
+    for(unsigned long i = 0; i < search->ma->n; i++){
+        search->index[i] = (unsigned long) -1;
     }
+    search->next_index = 0;
+}
+
+/**
+ * Records the SCCs completed from now on in the order they are completed,
+ * successors first, trivial ones included.
+ *
+ * @param search the search
+ * @param states gets the states of the SCCs, room for all states searched
+ * @param starts gets the first state of each SCC and the end of the last one, room for one more
+ */
+void SCCSearch_record(SCCSearch *search, sparse_index *states, sparse_index *starts){
+    search->completed = states;
+    search->completed_starts = starts;
+    search->completed_n = 0;
+    starts[0] = 0;
+}
+
+/**
+ * @param search the search
+ * @param state_nr the state
+ * @return true if @a state_nr was visited since the last reset
+ */
+bool SCCSearch_visited(const SCCSearch *search, unsigned long state_nr){
+    return search->index[state_nr] != (unsigned long) -1;
+}
+
+/**
+ * Moves the search of @a v past its current transition to @a dst, past the
+ * whole choice if it turns bad.
+ *
+ * @return true if the choice turned bad
+ */
+static bool SCCSearch_next(SCCSearch *search, unsigned long v, unsigned long dst){
+    if(search->rule != SCC_BAD_NONE && search->bad_states[dst]){
+        unsigned long choice_nr = search->next_choice[v];
+        search->bad_choices[v]++;
+        search->bad_transitions[choice_nr] = true;
+        search->next_choice[v] = choice_nr + 1;
+        search->next_transition[v] = search->ma->choice_starts[choice_nr + 1];
+        return true;
+    }
+    search->next_transition[v]++;
     return false;
 }
 
-void function_strongconnect(SparseMatrix *ma,unsigned long v, vector<unsigned long>& scc_states, vector<unsigned long>& stack, bool *stack_precense, bool* bad_states, bool* bad_transitions, unsigned long& i, vector<long>& index, vector<unsigned long>& lowlink,unsigned long& scc_nr){
-	// Set the depth index for v to the smallest unused index
-    index[v] = i; //v.index := index
-    lowlink[v] = i; //v.lowlink := index
-    i++; //index := index + 1
-    stack.push_back(v); //S.push(v) //stack.push_back(v);
-    stack_precense[v] = true;
-	
-	//printf("size: %ld\n",stack.size());
-	//printf("capacity: %ld\n",stack.capacity());
-	//printf("max size: %ld\n",stack.max_size());
-	dbg_printf("function_strongconnect for v: %lu.\n",v);
-    dbg_printf("size: %ld\n",stack.size());
-	dbg_printf("capacity: %ld\n",stack.capacity());
-	dbg_printf("max size: %ld\n",stack.max_size());
-    
-    //printf("function_strongconnect for v: %lu.\n",v);
-	// Consider successors of v
-    //for each (v,w) in E do:
-    unsigned long *row_starts = (unsigned long *) ma->row_counts;
-    unsigned long *choice_starts = (unsigned long *) ma->choice_counts;
-    unsigned long *cols = ma->cols;
-    unsigned long dst;
-    unsigned long row_start = row_starts[v]; //row_start = row_counts[i]
-    unsigned long row_end = row_starts[v + 1]; //row_end = row_counts[i+1]
-    unsigned long choice_start;
-    unsigned long choice_end;
-    while(row_start < row_end) {
-        //printf("a");
-        if(!bad_transitions[row_start]){
-            choice_start = choice_starts[row_start];
-            choice_end = choice_starts[row_start + 1];
-            //printf("b");
-            while(choice_start < choice_end){ 
-                //printf("c");
-                dst=cols[choice_start];
-                if(index[(long)dst]< 0 && !bad_states[dst]){
-                    //printf("d");
-                    // Successor w has not yet been visited; recurse on it
-                    function_strongconnect(ma,dst,scc_states,stack,stack_precense,bad_states,bad_transitions,i,index,lowlink,scc_nr); //stronglyconnect(w)
-                    if(lowlink[dst] < lowlink[v]){
-                        lowlink[v] = lowlink[dst]; //v.lowlink := min(v.lowlink, w.lowlink)
-                    }
-                }else if(stack_precense[dst] && !bad_states[dst]){ //isIn_copy(stack,dst)  is way too expensive! made the algorithm 200 times slower
-                    //printf("e");
-                    // Successor W is in stack S and hence in the current SCC
-                    if(index[dst] < (long)lowlink[v]){
-                        lowlink[v]=index[dst]; //v.lowlink := min(v.lowlink, v.index)
-                    }
+/**
+ * Starts the search of @a v.
+ */
+static void SCCSearch_open(SCCSearch *search, unsigned long v, unsigned long& scc_top, unsigned long& call_top){
+    search->index[v] = search->next_index;
+    search->lowlink[v] = search->next_index;
+    search->next_index++;
+    search->next_choice[v] = search->ma->row_starts[v];
+    search->next_transition[v] = search->ma->choice_starts[search->ma->row_starts[v]];
+    search->bad_choices[v] = 0;
+    search->scc_stack[scc_top++] = v;
+    search->on_stack[v] = true;
+    search->call_stack[call_top++] = v;
+}
+
+/**
+ * Marks the choices of the states scc_stack[@a scc_start..@a scc_end) bad
+ * which lead to states of different SCCs.
+ *
+ * @return true if a choice turned bad
+ */
+static bool SCCSearch_split(SCCSearch *search, unsigned long scc_start, unsigned long scc_end, const vector<unsigned long>& scc_states){
+    sparse_index *row_starts = search->ma->row_starts;
+    sparse_index *choice_starts = search->ma->choice_starts;
+    sparse_index *cols = search->ma->cols;
+    bool split = false;
+
+    for(unsigned long j = scc_start; j < scc_end; j++){
+        unsigned long v = search->scc_stack[j];
+        if(search->bad_states[v])
+            continue;
+        for(unsigned long choice_nr = row_starts[v]; choice_nr < row_starts[v + 1]; choice_nr++){
+            if(search->bad_transitions[choice_nr])
+                continue;
+            unsigned long i_start = choice_starts[choice_nr];
+            for(unsigned long i = i_start + 1; i < choice_starts[choice_nr + 1]; i++){
+                if(scc_states[cols[i]] != scc_states[cols[i_start]]){
+                    search->bad_transitions[choice_nr] = true;
+                    split = true;
+                    break;
                 }
-                choice_start++;
-            } 
+            }
         }
-        row_start++;
     }
-    
-    vector<unsigned long> scc;
-    scc.clear();
-    
-    // If v is a root node, pop the stack and generate an SCC
-    if(index[v] == (long)lowlink[v]){ // if (v.lowlink = v.index) then
-        //start a new strongly connected component
-        unsigned long w = stack.back();
-        stack.pop_back();
-        stack_precense[w] = false;
-        
-        while(w != v)
-        {
-                scc.push_back(w);
-                w = stack.back();
-                stack.pop_back();
-                stack_precense[w] = false;
+    return split;
+}
+
+/**
+ * Searches the states reachable from @a root which were not visited yet and
+ * numbers their nontrivial SCCs, starting with @a scc_nr. SCCs are numbered
+ * in the order they are completed, successors first.
+ *
+ * @param search the search
+ * @param root a state neither visited nor bad
+ * @param scc_states SCC number of each state, left as it is for states in no SCC
+ * @param scc_nr number of the next SCC, increased for every SCC found
+ * @return true if a state or a choice turned bad during the search
+ */
+bool SCCSearch_visit(SCCSearch *search, unsigned long root, vector<unsigned long>& scc_states, unsigned long& scc_nr){
+    const SparseMatrix *ma = search->ma;
+    sparse_index *row_starts = ma->row_starts;
+    sparse_index *choice_starts = ma->choice_starts;
+    sparse_index *cols = ma->cols;
+    bool *bad_states = search->bad_states;
+    bool *bad_transitions = search->bad_transitions;
+    unsigned long *index = search->index;
+    unsigned long *lowlink = search->lowlink;
+    unsigned long scc_top = 0, call_top = 0;
+    bool new_bad = false;
+
+    SCCSearch_open(search, root, scc_top, call_top);
+    while(call_top > 0 || search->retry_n > 0){
+        if(call_top == 0){
+            // states of a split SCC the search did not reach again
+            unsigned long u = search->retry[--search->retry_n];
+            search->in_retry[u] = false;
+            if(!SCCSearch_visited(search, u) && !bad_states[u])
+                SCCSearch_open(search, u, scc_top, call_top);
+            continue;
         }
-        scc.push_back(w);
-        
+        unsigned long v = search->call_stack[call_top - 1];
+        unsigned long row_end = row_starts[v + 1];
+        bool descended = false;
+        // Consider successors of v
+        while(search->next_choice[v] < row_end){
+            unsigned long choice_nr = search->next_choice[v];
+            if(bad_transitions[choice_nr] || search->next_transition[v] >= choice_starts[choice_nr + 1]){
+                search->next_choice[v] = choice_nr + 1;
+                search->next_transition[v] = choice_starts[choice_nr + 1];
+                continue;
+            }
+            unsigned long dst = cols[search->next_transition[v]];
+            if(!SCCSearch_visited(search, dst) && !bad_states[dst]){
+                // Successor has not yet been visited; descend, the transition is finished on return
+                SCCSearch_open(search, dst, scc_top, call_top);
+                descended = true;
+                break;
+            }else if(search->on_stack[dst] && !bad_states[dst]){
+                // Successor is on the stack and hence in the current SCC
+                if(index[dst] < lowlink[v])
+                    lowlink[v] = index[dst];
+            }
+            if(SCCSearch_next(search, v, dst))
+                new_bad = true;
+        }
+        if(descended)
+            continue;
 
-        bool selfloop=false;
-
-        if(scc.size()==1) {
-            row_start = row_starts[scc[0]];
-            row_end = row_starts[scc[0] + 1];
-            while (row_start < row_end) {
-                /* Add up all outgoing rates of the distribution */
-                choice_start = choice_starts[row_start];
-                choice_end = choice_starts[row_start + 1];
-                selfloop=true;
-                while (choice_start < choice_end) {
-                    dst=cols[choice_start];
-                    if(dst!=scc[0])
-                    {
-                            selfloop=false;
-                            break;
+        unsigned long nr_choices = row_end - row_starts[v];
+        if((search->rule == SCC_BAD_ALL_CHOICES && search->bad_choices[v] == nr_choices)
+                || (search->rule == SCC_BAD_ANY_CHOICE && search->bad_choices[v] > 0)){
+            bad_states[v] = true;
+            new_bad = true;
+        }
+
+        // If v is a root node, pop the stack and generate an SCC
+        if(index[v] == lowlink[v]){
+            unsigned long scc_start = scc_top;
+            do {
+                scc_start--;
+                search->on_stack[search->scc_stack[scc_start]] = false;
+            } while(search->scc_stack[scc_start] != v);
+            bool nontrivial = scc_top - scc_start > 1;
+            if(!nontrivial){
+                for(unsigned long choice_nr = row_starts[v]; choice_nr < row_end; choice_nr++){
+                    if(bad_transitions[choice_nr])
+                        continue;
+                    bool selfloop = true;
+                    for(unsigned long j = choice_starts[choice_nr]; j < choice_starts[choice_nr + 1]; j++){
+                        if(search->rule == SCC_BAD_ANY_CHOICE && cols[j] == v)
+                            nontrivial = true;
+                        if(cols[j] != v)
+                            selfloop = false;
                     }
-                    choice_start++;
+                    if(search->rule != SCC_BAD_ANY_CHOICE && selfloop)
+                        nontrivial = true;
                 }
-                row_start++;
             }
-            if(!selfloop)
-                scc.clear();
-        }            
-            
-        //output the current strongly connected component
-        for(unsigned long j=0; j<scc.size(); j++) {
-            scc_states[scc[j]]=scc_nr;		
+            if(search->rule != SCC_BAD_NONE){
+                bool split = false;
+                for(unsigned long j = scc_start; j < scc_top; j++){
+                    if(bad_states[search->scc_stack[j]])
+                        split = nontrivial;
+                }
+                if(!split){
+                    for(unsigned long j = scc_start; j < scc_top; j++){
+                        scc_states[search->scc_stack[j]] = nontrivial ? scc_nr : 0;
+                    }
+                    if(SCCSearch_split(search, scc_start, scc_top, scc_states)){
+                        new_bad = true;
+                        split = nontrivial;
+                    }
+                }
+                if(split){
+                    // search the SCC again, the parent of v descends into it once more
+                    for(unsigned long j = scc_start; j < scc_top; j++){
+                        unsigned long u = search->scc_stack[j];
+                        scc_states[u] = 0;
+                        index[u] = (unsigned long) -1;
+                        if(!search->in_retry[u]){
+                            search->in_retry[u] = true;
+                            search->retry[search->retry_n++] = u;
+                        }
+                    }
+                    scc_top = scc_start;
+                    call_top--;
+                    continue;
+                }
+            }
+            if(nontrivial && !bad_states[v]){
+                for(unsigned long j = scc_start; j < scc_top; j++){
+                    scc_states[search->scc_stack[j]] = scc_nr;
+                }
+                scc_nr++;
+            }
+            if(search->completed != NULL){
+                unsigned long end = search->completed_starts[search->completed_n];
+                for(unsigned long j = scc_start; j < scc_top; j++){
+                    search->completed[end++] = search->scc_stack[j];
+                }
+                search->completed_starts[++search->completed_n] = end;
+            }
+            scc_top = scc_start;
         }
-            
-	if(scc.size() > 0){
-            scc_nr++;
-            dbg_printf("SCC found by decomposition!");
+
+        call_top--;
+        if(call_top > 0){
+            unsigned long parent = search->call_stack[call_top - 1];
+            if(lowlink[v] < lowlink[parent])
+                lowlink[parent] = lowlink[v];
+            if(SCCSearch_next(search, parent, v))
+                new_bad = true;
         }
     }
+    return new_bad;
 }
 
 
 /**
- * Computes Tarjan SCC decomposition with respect to a set of bad states
+ * Computes Tarjan SCC decomposition with respect to a set of bad states.
+ * MAs of at least PARALLEL_MIN_STATES states are decomposed by the parallel
+ * forward-backward search instead if there are several OpenMP threads. Either
+ * way the SCCs are numbered in the order of their smallest state.
  * @param ma
  * @param answer, A return vector of length ma->n, with per state the SCC it belongs to.
  */
 void compute_SCC_decomposition_tarjan(SparseMatrix *ma, vector<unsigned long>& scc_states, bool* bad_states, bool* bad_transitions, unsigned long& scc_nr){
-    /* Initialize vectors needed for Tarjan SCC Decomposition algorithm */
-    vector<long> index(ma->n,-1); //init v.index
-    vector<unsigned long> lowlink(ma->n,0); //init v.lowlink
-	
-    unsigned long i=0; //index := 0
-    vector<unsigned long> stack; //S := empty
-    bool *stack_precense=(bool *) malloc(ma->n * sizeof(bool));
-    for(unsigned long i = 0; i < ma->n; i++){
-        stack_precense[i]=false;
+    int nr_threads = 1;
+#ifdef _OPENMP
+    nr_threads = omp_get_max_threads();
+#endif
+    if(nr_threads > 1 && ma->n >= PARALLEL_MIN_STATES){
+        SCCParallel *engine = SCCParallel_new(ma, bad_states, bad_transitions);
+        vector<unsigned long> all(ma->n);
+        for(unsigned long v = 0; v < ma->n; v++){
+            all[v] = v;
+        }
+        SCCParallel_decompose(engine, all, true, scc_states, scc_nr);
+        SCCParallel_free(engine);
+        return;
     }
-    unsigned long v = 0;
-	
-    while(v < ma->n){ //for each v in V do
-        
-        if(index[v]<0 && !bad_states[v]){
-            function_strongconnect(ma,v,scc_states, stack, stack_precense, bad_states, bad_transitions,i,index,lowlink,scc_nr); 
+
+    SCCSearch *search = SCCSearch_new(ma, bad_states, bad_transitions, SCC_BAD_NONE);
+    unsigned long first_nr = scc_nr;
+
+    for(unsigned long v = 0; v < ma->n; v++){ //for each v in V do
+        if(!SCCSearch_visited(search, v) && !bad_states[v]){
+            SCCSearch_visit(search, v, scc_states, scc_nr);
         }
-        v++;
     }
-	
-	free(stack_precense);
-    
-    /*
-    for(int j = 0; j < ma->n;j++){
-        printf("state %i has number %lu.\n",j,scc_states[j]);
-    }*/
-    
+
+    // renumber from completion order to the order of the smallest states
+    vector<unsigned long> number(scc_nr - first_nr, (unsigned long)-1);
+    unsigned long next_nr = first_nr;
+    for(unsigned long v = 0; v < ma->n; v++){
+        if(scc_states[v] < first_nr || scc_states[v] >= scc_nr || !SCCSearch_visited(search, v))
+            continue;
+        unsigned long& nr = number[scc_states[v] - first_nr];
+        if(nr == (unsigned long)-1)
+            nr = next_nr++;
+        scc_states[v] = nr;
+    }
+
+    SCCSearch_free(search);
+}
+
+/**
+ * Computes the SCC decomposition of @a ma in which no choice leaves an SCC
+ * partially, with the bad states and transitions growing according to
+ * @a rule. Split SCCs are searched again at once instead of restarting the
+ * whole search, so a pass normally finds all bad states and transitions.
+ * The SCCs are numbered by a last pass which finds nothing new.
+ *
+ * @param ma the MA
+ * @param scc_states gets the SCC number of each state, 0 for states in no SCC
+ * @param bad_states states left out, grows
+ * @param bad_transitions choices left out, grows
+ * @param rule how bad states and transitions grow
+ * @param scc_nr number of the first SCC, gets the number after the last SCC
+ */
+void compute_SCC_decomposition_stable(SparseMatrix *ma, vector<unsigned long>& scc_states, bool* bad_states, bool* bad_transitions, SCCBadRule rule, unsigned long& scc_nr){
+    SCCSearch *search = SCCSearch_new(ma, bad_states, bad_transitions, rule);
+    unsigned long first_nr = scc_nr;
+    bool changed = true;
+
+    while(changed){
+        changed = false;
+        SCCSearch_reset(search);
+        scc_states.assign(ma->n, 0);
+        scc_nr = first_nr;
+        for(unsigned long v = 0; v < ma->n; v++){
+            if(!SCCSearch_visited(search, v) && !bad_states[v]){
+                if(SCCSearch_visit(search, v, scc_states, scc_nr))
+                    changed = true;
+            }
+        }
+    }
+
+    SCCSearch_free(search);
 }
 
 /**
@@ -232,9 +463,9 @@ void check_mec(SparseMatrix *ma, bool* bad_states, bool* bad_transitions, bool*
     for(unsigned long v = 0; ((v < ma->n)); v++){ //(v < ma->n) && (scc_states[v] == scc_nr) does not work??
         if((scc_states[v] == scc_nr)){
             //lookup the edges going from this vertex:
-            unsigned long *row_starts = (unsigned long *) ma->row_counts;
-            unsigned long *choice_starts = (unsigned long *) ma->choice_counts;
-            unsigned long *cols = ma->cols;
+            sparse_index *row_starts = ma->row_starts;
+            sparse_index *choice_starts = ma->choice_starts;
+            sparse_index *cols = ma->cols;
             unsigned long dst;
             unsigned long row_start = row_starts[v]; //row_start = row_counts[i]
             unsigned long row_end = row_starts[v + 1]; //row_end = row_counts[i+1]
@@ -301,357 +532,425 @@ void check_mec(SparseMatrix *ma, bool* bad_states, bool* bad_transitions, bool*
     ////printf("check_scc done!\n");
 }
 
-void attractor_remove(SparseMatrix *ma, bool* u0_states, bool* bad_states, bool* new_bad_states,bool* bad_transitions,vector<unsigned long> scc_states,unsigned long scc_nr,unsigned long& nr_states_removed,bool remove_scc){
-    //This function has two modes, separated by boolean scc_remove
-    //remove_SCC == true means that the SCC defined by
-    //scc_states and scc_nr and its attractor set must be removed,
-    //remove_SCC == true then u0_states is the starting set and that only
-    // u0_states + its attractor set UNION SCC defined by scc_states and scc_nr must be removed.
-    
-    //The states that should be removed from bad_states are instead removed from
-    //new_bad_states, because if already removed from bad_States (on the end of the function)
-    //then the next mec_check would skip those states even though they where not bad in the
-    //previous iteration of the whole algorithm. So the bad states are only applied once the
-    //iteration is complete.
-    
-    //initializing the attractor set:
-    /*printf("bad_states array:\n");
-    for(int j = 0; j < ma->n; j++){
-        printf("|%s",bad_states[j]?"true":"false");
+/**
+ * A candidate for an MEC: an SCC of the states and choices which are not
+ * bad. Its choices leaving it turn bad, and so do its states without choices
+ * left; if it loses a choice it is split on its own until it stays strongly
+ * connected, then it is an MEC.
+ */
+typedef struct MECCandidate
+{
+    unsigned long nr;                       /* number of the candidate */
+    vector<unsigned long> states;           /* states of the candidate, also those which left it */
+} MECCandidate;
+
+/**
+ * Refinement of the MEC candidates. The candidates are disjoint and refined
+ * by several threads at once. A thread only writes the states and choices of
+ * its own candidate; it reads the candidate of other states, which may change
+ * meanwhile, but only to compare it with its own, which they never get.
+ */
+typedef struct MECRefinement
+{
+    SparseMatrix *ma;
+    const Predecessors *pred;
+    SCCParallel *engine;                    /* splits large candidates, NULL for a single thread */
+    bool *bad_states;                       /* states in no candidate */
+    bool *bad_transitions;                  /* choices leaving their candidate */
+    unsigned long *good_choices;            /* # of choices of each state which are not bad */
+    unsigned long *mark;                    /* last forward search which reached each state */
+    bool *in_lost;                          /* state is in the lost states of its worker */
+    vector<unsigned long> candidate;        /* candidate of each state, 0 for none */
+    unsigned long next_nr;                  /* next candidate number, taken atomically */
+    unsigned long next_mark;                /* next forward search number, taken atomically */
+} MECRefinement;
+
+/**
+ * What one thread needs to refine candidates.
+ */
+typedef struct MECWorker
+{
+    SCCSearch *search;                      /* SCC_BAD_NONE search splitting small candidates */
+    unsigned long mark_nr;                  /* number of the last forward search */
+    vector<unsigned long> lost;             /* states of the refined candidate which lost a choice */
+    vector<unsigned long> left;             /* states which left the refined candidate */
+    vector<unsigned long> reached;          /* states of the last forward search */
+    vector<unsigned long> dfs;              /* stack of the forward search */
+    vector<MECCandidate *> found;           /* new candidates */
+    vector<MECCandidate *> mecs;            /* candidates which are MECs */
+} MECWorker;
+
+/**
+ * Splits @a region, a set of states no choice which is not bad leaves, into
+ * its SCCs and adds them to the new candidates of @a w. States in no SCC turn
+ * bad. Large regions are split by the forward-backward search if there are
+ * several threads, using all of them if @a parallel is set.
+ */
+static void MECRefinement_split(MECRefinement *r, MECWorker *w, const vector<unsigned long>& region, bool parallel){
+    unsigned long first_nr = __sync_fetch_and_add(&r->next_nr, region.size());
+    unsigned long scc_nr = first_nr;
+
+    for(unsigned long i = 0; i < region.size(); i++){
+        r->candidate[region[i]] = 0;
+    }
+    if(r->engine != NULL && region.size() >= PARALLEL_MIN_STATES){
+        SCCParallel_decompose(r->engine, region, parallel, r->candidate, scc_nr);
+    }else{
+        for(unsigned long i = 0; i < region.size(); i++){
+            w->search->index[region[i]] = (unsigned long) -1;
+        }
+        for(unsigned long i = 0; i < region.size(); i++){
+            unsigned long u = region[i];
+            if(!r->bad_states[u] && !SCCSearch_visited(w->search, u))
+                SCCSearch_visit(w->search, u, r->candidate, scc_nr);
+        }
     }
-    printf("|\n");
 
-    printf("violating array:\n");
-    for(int j = 0; j < ma->n; j++){
-        printf("|%s",u0_states[j]?"true":"false");
+    vector<MECCandidate *> sccs(scc_nr - first_nr);
+    for(unsigned long k = 0; k < sccs.size(); k++){
+        sccs[k] = new MECCandidate;
+        sccs[k]->nr = first_nr + k;
     }
-    printf("|\n");
-    
-    printf("scc_states array:\n");
-    for(int j = 0; j < ma->n; j++){
-        printf("|%lu",scc_states[j]);
+    for(unsigned long i = 0; i < region.size(); i++){
+        unsigned long u = region[i];
+        if(r->bad_states[u])
+            continue;
+        if(r->candidate[u] == 0){
+            r->bad_states[u] = true;
+            continue;
+        }
+        sccs[r->candidate[u] - first_nr]->states.push_back(u);
     }
-    printf("| and scc_nr: %lu.\n",scc_nr);*/
-    
-    bool *attractor_set=(bool *) malloc(ma->n * sizeof(bool));
-    
-    if(remove_scc){
-        //initial set is the SCC
-        for(int i = 0; i < ma->n; i++){
-            if(scc_states[i] == scc_nr){
-                attractor_set[i] = true;
+    w->found.insert(w->found.end(), sccs.begin(), sccs.end());
+}
+
+/**
+ * Notes that @a u lost a choice, so a part of its candidate may be split off
+ * which contains @a u.
+ */
+static void MECRefinement_lose(MECRefinement *r, MECWorker *w, unsigned long u){
+    if(!r->in_lost[u]){
+        r->in_lost[u] = true;
+        w->lost.push_back(u);
+    }
+}
+
+/**
+ * Turns the choices of the states of candidate @a c bad which leave it. States
+ * without choices left turn bad.
+ *
+ * @param size # of states left in @a c, decreased
+ * @return # of transitions of the choices which are left
+ */
+static unsigned long MECRefinement_init(MECRefinement *r, MECWorker *w, const MECCandidate *c, unsigned long& size){
+    sparse_index *row_starts = r->ma->row_starts;
+    sparse_index *choice_starts = r->ma->choice_starts;
+    sparse_index *cols = r->ma->cols;
+    unsigned long nr_transitions = 0;
+
+    for(unsigned long i = 0; i < c->states.size(); i++){
+        unsigned long u = c->states[i];
+        unsigned long good = 0;
+        for(unsigned long choice_nr = row_starts[u]; choice_nr < row_starts[u + 1]; choice_nr++){
+            if(r->bad_transitions[choice_nr])
+                continue;
+            bool leaves = false;
+            for(unsigned long j = choice_starts[choice_nr]; j < choice_starts[choice_nr + 1]; j++){
+                if(r->bad_states[cols[j]] || r->candidate[cols[j]] != c->nr){
+                    leaves = true;
+                    break;
+                }
+            }
+            if(leaves){
+                r->bad_transitions[choice_nr] = true;
+                MECRefinement_lose(r, w, u);
             }else{
-                attractor_set[i] = false;
+                good++;
+                nr_transitions += choice_starts[choice_nr + 1] - choice_starts[choice_nr];
             }
         }
-    }else{
-        for(int i = 0; i < ma->n; i++){
-                attractor_set[i] = u0_states[i];           
+        r->good_choices[u] = good;
+        if(good == 0){
+            r->bad_states[u] = true;
+            size--;
+            w->left.push_back(u);
         }
     }
-    
-    bool attracted_new_state = true;
-    
-    while(attracted_new_state){ //continue until no new states have been found
-        attracted_new_state = false;
-        
-        for(unsigned long v = 0; v < ma->n; v++){
-            if(!attractor_set[v] && !bad_states[v]){
-                //lookup the edges going from this vertex:
-                unsigned long *row_starts = (unsigned long *) ma->row_counts;
-                unsigned long *choice_starts = (unsigned long *) ma->choice_counts;
-                unsigned long *cols = ma->cols;
-                unsigned long dst;
-                unsigned long row_start = row_starts[v]; //row_start = row_counts[i]
-                unsigned long row_end = row_starts[v + 1]; //row_end = row_counts[i+1]
-                unsigned long choice_start;
-                unsigned long choice_end;
-
-
-                bool each_transition_choice_to_ui = true;
-
-                while(row_start < row_end) {
-                    if(!bad_transitions[row_start]){
-                        bool choice_to_ui_found = false;
-
-                        choice_start = choice_starts[row_start];
-                        choice_end = choice_starts[row_start + 1];
-                        while(choice_start < choice_end){
-                            dst=cols[choice_start];
-                            //printf("Investigating transition from %lu to %lu\n",v,dst);
-
-                            if(!bad_states[dst] && attractor_set[dst]){
-                                choice_to_ui_found = true;
-                                //printf("choice_to_ui_found\n");
-                            }
+    return nr_transitions;
+}
 
-                            choice_start++;
-                        }
+/**
+ * Turns the choices of candidate @a c bad which lead to the states which left
+ * it, until no more states leave it.
+ *
+ * @param size # of states left in @a c, decreased
+ */
+static void MECRefinement_propagate(MECRefinement *r, MECWorker *w, const MECCandidate *c, unsigned long& size){
+    const Predecessors *pred = r->pred;
 
-                        if(!choice_to_ui_found){
-                            each_transition_choice_to_ui = false;
-                            //printf("each_transition_choice_to_ui = false\n");
-                        }
+    while(!w->left.empty()){
+        unsigned long u = w->left.back();
+        w->left.pop_back();
+        for(unsigned long p = pred->starts[u]; p < pred->starts[u + 1]; p++){
+            unsigned long choice_nr = pred->choices[p];
+            unsigned long v = pred->states[choice_nr];
+            if(r->bad_states[v] || r->candidate[v] != c->nr || r->bad_transitions[choice_nr])
+                continue;
+            r->bad_transitions[choice_nr] = true;
+            MECRefinement_lose(r, w, v);
+            if(--r->good_choices[v] == 0){
+                r->bad_states[v] = true;
+                size--;
+                w->left.push_back(v);
+            }
+        }
+    }
+}
 
-                    }
-                    row_start++;
-                }
+/**
+ * Collects the states reachable from @a root by choices which are not bad in
+ * the reached states of @a w, looking at @a budget transitions at most.
+ *
+ * @return false if the budget ran out first
+ */
+static bool MECRefinement_reach(MECRefinement *r, MECWorker *w, unsigned long root, unsigned long& budget){
+    sparse_index *row_starts = r->ma->row_starts;
+    sparse_index *choice_starts = r->ma->choice_starts;
+    sparse_index *cols = r->ma->cols;
 
-                if(each_transition_choice_to_ui){
-                    attractor_set[v] = true;
-                    attracted_new_state = true;
+    w->mark_nr = __sync_add_and_fetch(&r->next_mark, 1);
+    w->reached.clear();
+    w->dfs.clear();
+    r->mark[root] = w->mark_nr;
+    w->reached.push_back(root);
+    w->dfs.push_back(root);
+    while(!w->dfs.empty()){
+        unsigned long v = w->dfs.back();
+        w->dfs.pop_back();
+        for(unsigned long choice_nr = row_starts[v]; choice_nr < row_starts[v + 1]; choice_nr++){
+            if(r->bad_transitions[choice_nr])
+                continue;
+            for(unsigned long j = choice_starts[choice_nr]; j < choice_starts[choice_nr + 1]; j++){
+                if(budget == 0)
+                    return false;
+                budget--;
+                unsigned long dst = cols[j];
+                if(r->mark[dst] != w->mark_nr){
+                    r->mark[dst] = w->mark_nr;
+                    w->reached.push_back(dst);
+                    w->dfs.push_back(dst);
                 }
             }
         }
-                
     }
-    
-    
-    
-    //now throw away all vertices attracted
-    if(remove_scc){
-        for(unsigned long i = 0; i < ma->n; i++){
-            if(attractor_set[i] && !new_bad_states[i]){
-                new_bad_states[i] = true;
-                nr_states_removed++;
-            }
-        }
-    }else{
-        for(unsigned long i = 0; i < ma->n; i++){
-            if(attractor_set[i] && (scc_states[i] == scc_nr) && !new_bad_states[i]){
-                new_bad_states[i] = true;
-                nr_states_removed++;
-            }
+    return true;
+}
+
+/**
+ * Refines candidate @a c, which is then freed or kept as an MEC. A bottom SCC
+ * of what is left of it must contain a state which lost a choice, so forward
+ * searches from those states are run, each limited to about the square root
+ * of its transitions. A search which ends without reaching all states found
+ * a closed set, whose SCCs are split off. If all searches reach everything
+ * the candidate is an MEC; if they run out of budget it is split by a full
+ * SCC search instead.
+ *
+ * @param parallel split large candidates with all threads
+ */
+static void MECRefinement_refine(MECRefinement *r, MECWorker *w, MECCandidate *c, bool parallel){
+    unsigned long size = c->states.size();
+    unsigned long nr_transitions = MECRefinement_init(r, w, c, size);
+    unsigned long limit = (unsigned long) sqrt((double) nr_transitions) + 1;
+    unsigned long spent = 0;
+    bool deferred = false;
+
+    MECRefinement_propagate(r, w, c, size);
+    while(size > 0 && !w->lost.empty() && spent <= nr_transitions){
+        unsigned long u = w->lost.back();
+        w->lost.pop_back();
+        r->in_lost[u] = false;
+        if(r->bad_states[u] || r->candidate[u] != c->nr)
+            continue;
+        unsigned long budget = limit;
+        bool complete = MECRefinement_reach(r, w, u, budget);
+        spent += limit - budget;
+        if(!complete){
+            deferred = true;
+            continue;
         }
+        if(w->reached.size() == size)
+            continue;
+        // the reached states are closed, so their SCCs are SCCs of the candidate
+        size -= w->reached.size();
+        MECRefinement_split(r, w, w->reached, parallel);
+        w->left.insert(w->left.end(), w->reached.begin(), w->reached.end());
+        MECRefinement_propagate(r, w, c, size);
     }
-	
-	free(attractor_set);
-    
-    /*printf("attractor_set:\n");
-    for(int j = 0; j < ma->n; j++){
-        printf("|%s",attractor_set[j]?"true":"false");
+    if(!w->lost.empty())
+        deferred = true;
+    while(!w->lost.empty()){
+        r->in_lost[w->lost.back()] = false;
+        w->lost.pop_back();
     }
-    printf("|\n");
-    
-    printf("new_bad_states:\n");
-    for(int j = 0; j < ma->n; j++){
-        printf("|%s",new_bad_states[j]?"true":"false");
+
+    // unless a search ran out of budget, what is left is an MEC; so is a single
+    // state left over, the choices it kept only lead to itself
+    if(size > 0 && deferred){
+        vector<unsigned long> region;
+        for(unsigned long i = 0; i < c->states.size(); i++){
+            unsigned long u = c->states[i];
+            if(!r->bad_states[u] && r->candidate[u] == c->nr)
+                region.push_back(u);
+        }
+        MECRefinement_split(r, w, region, parallel);
+    }else if(size > 0){
+        w->mecs.push_back(c);
+        return;
     }
-    printf("|\n");*/
+    delete c;
 }
 
 /**
- * MEC Decomposition as described by Chatterjee and Henzinger as the ¨Old algorithm¨:
- * 
- * while(vertices left){
- * compute SCC decomposition
- *      foreach(SCC C){
- *              if(There are vertices (X) in C with random edges leaving SCC){
- *                      Remove Attr_R(X) U C from the graph
- *              }else{
- *                      Store MEC C, remove Attr_R(C) from the graph
- *              }
- *      }
- * }
- * @param ma
- * @return 
+ * MEC decomposition by refining each SCC on its own: the SCCs of the MA are
+ * the first candidates, and refining a candidate only looks at its own
+ * states and choices and at the predecessors of the states it loses. The
+ * candidates of a round are refined by the OpenMP threads at once if they
+ * are large enough together; a round with a single candidate splits it with
+ * the parallel forward-backward search instead. The MECs are numbered in the
+ * order of their smallest state.
+ *
+ * @param ma the MA
+ * @return the MECs
  */
-SparseMatrixMEC* mEC_decomposition_previous_algorithm(SparseMatrix *ma){
-    //printf("sccs2.ccp: mEC_decomposition_old_algorithm Start!\n");
-    
-    /*
-     double dtstart, dtstop, ttime;
-     dtstart = (double)clock()/CLOCKS_PER_SEC;
-     */
-	 
-	 vector<unsigned long> mec_states(ma->n,0);
-    
-    /* Initialize boolean array bad, signifying which vertices are left to look at */
-    
-    bool *bad_states=(bool *) malloc(ma->n * sizeof(bool));
-    bool *new_bad_states=(bool *) malloc(ma->n * sizeof(bool));
-    bool *violating=(bool *) malloc(ma->n * sizeof(bool));
-    
-    for(unsigned long i=0; i<ma->n; i++) {
-        bad_states[i]=false;
-        new_bad_states[i]=false;
+static SparseMatrixMEC* compute_mEC_decomposition(SparseMatrix *ma){
+    unsigned long n = ma->n;
+    unsigned long nr_choices = ma->row_starts[n];
+    MECRefinement r;
+
+    r.ma = ma;
+    r.pred = SparseMatrix_predecessors(ma);
+    r.bad_states = (bool *) calloc(n > 0 ? n : 1, sizeof(bool));
+    r.bad_transitions = (bool *) calloc(nr_choices > 0 ? nr_choices : 1, sizeof(bool));
+    r.good_choices = (unsigned long *) malloc((n > 0 ? n : 1) * sizeof(unsigned long));
+    r.mark = (unsigned long *) calloc(n > 0 ? n : 1, sizeof(unsigned long));
+    r.in_lost = (bool *) calloc(n > 0 ? n : 1, sizeof(bool));
+    r.candidate.assign(n, 0);
+    r.next_nr = 1;
+    r.next_mark = 0;
+
+    int nr_workers = 1;
+#ifdef _OPENMP
+    nr_workers = omp_get_max_threads();
+#endif
+    r.engine = nr_workers > 1 ? SCCParallel_new(ma, r.bad_states, r.bad_transitions) : NULL;
+    vector<MECWorker> workers(nr_workers);
+    for(int t = 0; t < nr_workers; t++){
+        workers[t].search = SCCSearch_new(ma, r.bad_states, r.bad_transitions, SCC_BAD_NONE);
+        workers[t].mark_nr = 0;
     }
-    /* vector to store bad transition information */
-    
-    unsigned long *dist_starts = (unsigned long *) ma->row_counts;
-    unsigned long nr_transitions = dist_starts[ma->n];
-	
-    bool *bad_transitions=(bool *) malloc(nr_transitions * sizeof(bool));
-    
-    for(unsigned long i=0; i<nr_transitions; i++) {
-            bad_transitions[i]=false;
+
+    vector<unsigned long> all(n);
+    for(unsigned long i = 0; i < n; i++){
+        all[i] = i;
     }
-    /* vector to store the SCC Decomposition answer */
-    vector<unsigned long> scc_states(ma->n,0); //vector to store found SCC
-    unsigned long scc_nr = 1;
-    unsigned long nr_states_removed = 0;
-    
-    /* vector to store found mecs */
-    //vector<unsigned long> mec_states(ma->n,0);
-    
-    unsigned long mec_nr = 1; //amount of mecs stored
-    
-	//printf("lets start\n");
-    
-    //Start of actual algorithm:
-    while(nr_states_removed < ma->n){
-        //printf("start main while: nr_states_removed: %lu/%lu\n",nr_states_removed,ma->n);
-        
-        //reset SCC decomposition answer variables.
-        for(unsigned long i = 0; i < ma->n; i++){
-            scc_states[i] = 0;
-        }
-        scc_nr = 1;
-        //printf("start SCCD\n");
-        compute_SCC_decomposition_tarjan(ma,scc_states,bad_states,bad_transitions,scc_nr);
-        //printf("stop SCCD\n");
-        
-        for(unsigned long z = 1; z < scc_nr; z++){
-            bool bad = false; //in order to know if there was a vertex that had a questionable bad transition
-            unsigned long nr_violating = 0; //in order to know if violating set is empty
-            
-            //printf("start MECcheck\n");
-            check_mec(ma,bad_states,bad_transitions,violating,scc_states,z,bad,nr_violating);
-            //printf("stop MECcheck, nr_violating = %lu, bad = %s \n",nr_violating,(bad)?"true":"false");
-            if((nr_violating == 0) && !bad){ //X is empty and bad == false
-                //Each vertex in SCC only has good transitions; SCC is an MEC:
-                //Store MEC C, 
-                /*printf("scc array for scc: %lu\n",i);
-                for(int j = 0; j < ma->n; j++){
-                    printf("%lu",scc_states[j]);
-                }*/
-                
-                for(int j = 0; j < ma->n; j++){
-                    if(scc_states[j]==z){
-                        mec_states[j] = mec_nr;
-                    }
-                }
-                mec_nr++;
-                
-                //remove Attr_R(C) from the graph
-                //printf("start attractor remove SCC\n");
-                attractor_remove(ma,violating,bad_states,new_bad_states,bad_transitions,scc_states,z,nr_states_removed,true);
-                //printf("stop attractor remove SCC\n");
-                
-                /*/temp
-                for(unsigned long i = 0; i < ma->n; i++){
-                        bad_states[i] = new_bad_states[i];
-                }*/
-            }else if(nr_violating > 0){ //X != empty
-                //the SCC found called C is not an MEC due to violating vertex set X
-                //Remove Attr_R(X) U (set union) C from the graph (add to bad states and bad vector).
-                //printf("start attractor remove set union scc\n");
-                attractor_remove(ma,violating,bad_states,new_bad_states,bad_transitions,scc_states,z,nr_states_removed,false);
-                //printf("stop attractor remove set union scc\n");
-                /*/temp
-                for(unsigned long i = 0; i < ma->n; i++){
-                        bad_states[i] = new_bad_states[i];
-                }*/
-            }                  
+    MECRefinement_split(&r, &workers[0], all, true);
+
+    vector<MECCandidate *> todo;
+    vector<MECCandidate *> mecs;
+    todo.swap(workers[0].found);
+    while(!todo.empty()){
+        unsigned long nr_states = 0;
+        for(unsigned long k = 0; k < todo.size(); k++){
+            nr_states += todo[k]->states.size();
         }
-        //iteration complete, apply newly found bad states, if done in the attractor function then check_mec function will not work correct
-        //as it then has problems detecting violating vertexes (those that only have bad transitions), because the destination of such a bad transition
-        //possibly is already marked as bad, which should only be the case in the next iteration.
-        for(unsigned long i = 0; i < ma->n; i++){
-            bad_states[i] = new_bad_states[i];
+        bool concurrent = todo.size() > 1 && nr_states >= PARALLEL_MIN_STATES;
+        #pragma omp parallel for schedule(dynamic) if(concurrent)
+        for(unsigned long k = 0; k < todo.size(); k++){
+            int t = 0;
+#ifdef _OPENMP
+            t = omp_get_thread_num();
+#endif
+            MECRefinement_refine(&r, &workers[t], todo[k], !concurrent);
         }
-        
-        //Also remove all vertices that do not belong to any SCC, as the attractor now works correctly this should not remove any nodes.
-        unsigned long counter = 0;
-        for(unsigned long i = 0; i < ma->n; i++){
-            if(scc_states[i] == 0 && !bad_states[i]){
-                bad_states[i] = true;
-                nr_states_removed++;
-                counter++;
-            }
+        todo.clear();
+        for(int t = 0; t < nr_workers; t++){
+            todo.insert(todo.end(), workers[t].found.begin(), workers[t].found.end());
+            workers[t].found.clear();
+            mecs.insert(mecs.end(), workers[t].mecs.begin(), workers[t].mecs.end());
+            workers[t].mecs.clear();
         }
-        //printf("Number of vertices removed that do not belong to any SCC %lu\n",counter);
-        
-        //printf("stop main while: nr_states_removed: %lu/%lu\n",nr_states_removed,ma->n);
     }
-    
-    unsigned long mec_states_nr = 0;
-    for(unsigned long i = 0; i < ma->n; i++){
-        if(mec_states[i]!=0){
-            mec_states_nr++;
+
+    /* number the MECs by their smallest state and store them */
+    vector<unsigned long> mec_of(n, (unsigned long) -1);
+    for(unsigned long k = 0; k < mecs.size(); k++){
+        for(unsigned long i = 0; i < mecs[k]->states.size(); i++){
+            unsigned long u = mecs[k]->states[i];
+            if(!r.bad_states[u] && r.candidate[u] == mecs[k]->nr)
+                mec_of[u] = k;
         }
+        delete mecs[k];
     }
-    //printf("Storing MECs, contents of mec_states:\n");
-    /*
-    for(unsigned long i = 0; i < ma->n; i++){
-        printf("%lu|",mec_states[i]);
-    }*/
-    //printf(" -- contents of mec_nr: %lu, mec_states_nr: %lu\n",mec_nr,mec_states_nr);
-    
-    /* Store MECs in a new MA,  this is copied from sccs.cpp*/
-    /* allocate memory for BSCCs and store them */
-    SparseMatrixMEC *mec;
-	
-	//printf("creating MEC");
-    
-    mec=SparseMatrixMEC_new(mec_states_nr,mec_nr-1);
-    unsigned long * cols = mec->cols;
-    unsigned long *row_starts = (unsigned long *) mec->row_counts;
-
-    vector<unsigned long>::const_iterator it;
-    unsigned long pos=0;
-    unsigned long scc_index=0;
-    unsigned long scc_size=0;
-    unsigned long tmp=0;
-    for(int idx=0; idx<mec->n; idx++) {
-            unsigned long i=0;
-            for(it=mec_states.begin(); it != mec_states.end(); it++)
-            {
-                    if((*it)==idx+1){
-                            cols[pos]=i;
-                            pos++;
-                            tmp++;
-                    }
-                    i++;
-            }
-            if (scc_index > 0) {
-                    row_starts[scc_index] =
-                    row_starts[scc_index - 1] + scc_size;
-            }
-            scc_size = tmp;
-            tmp=0;
-            scc_index++;
+    vector<unsigned long> mec_nr(mecs.size(), 0);
+    unsigned long nr_mecs = 0;
+    unsigned long nr_states = 0;
+    for(unsigned long i = 0; i < n; i++){
+        if(mec_of[i] == (unsigned long) -1)
+            continue;
+        if(mec_nr[mec_of[i]] == 0)
+            mec_nr[mec_of[i]] = ++nr_mecs;
+        nr_states++;
     }
-    row_starts[scc_index] = row_starts[scc_index - 1] + scc_size;
 
+    SparseMatrixMEC *mec = SparseMatrixMEC_new(nr_states, nr_mecs);
+    sparse_index *row_starts = mec->row_starts;
+    sparse_index *cols = mec->cols;
+    for(unsigned long i = 0; i < n; i++){
+        if(mec_of[i] != (unsigned long) -1)
+            row_starts[mec_nr[mec_of[i]]]++;
+    }
+    for(unsigned long k = 0; k < nr_mecs; k++){
+        row_starts[k + 1] += row_starts[k];
+    }
+    vector<sparse_index> next(row_starts, row_starts + nr_mecs);
+    for(unsigned long i = 0; i < n; i++){
+        if(mec_of[i] != (unsigned long) -1)
+            cols[next[mec_nr[mec_of[i]] - 1]++] = i;
+    }
 
-    unsigned long *row = (unsigned long *) mec->row_counts;
-    unsigned long *col = mec->cols;
+    for(unsigned long k = 0; k < mec->n; k++){
+        dbg_printf("MEC %ld: ", k + 1);
+        for(unsigned long i = row_starts[k]; i < row_starts[k + 1]; i++){
+            dbg_printf("%s ", state_name(ma->names, cols[i]));
+        }
+        dbg_printf("\n");
+    }
 
-    for(unsigned long mec_nr=0; mec_nr < mec->n; mec_nr++) {
-            unsigned long mec_start = row[mec_nr];
-            unsigned long mec_end = row[mec_nr + 1];
-            dbg_printf("MEC %ld: ",mec_nr+1);
-            for(unsigned long state_nr=mec_start; state_nr < mec_end; state_nr++) {
-                    //if(ma->goals[col[state_nr]])
-                            dbg_printf("%s ",ma->states_nr.find(col[state_nr])->second.c_str());
-            }
-            dbg_printf("\n");
+    for(int t = 0; t < nr_workers; t++){
+        SCCSearch_free(workers[t].search);
     }
-    
-    //free allocated memory:
-    free(bad_states);
-    free(new_bad_states);
-    free(violating);
-    free(bad_transitions);
-    /*
-    dtstop = (double)clock()/CLOCKS_PER_SEC;
-    ttime = dtstop-dtstart;
-    */
-    //printf("sccs2.ccp: mEC_decomposition_old_algorithm Done! Time: detailed: %f.\n",ttime);
+    SCCParallel_free(r.engine);
+    free(r.bad_states);
+    free(r.bad_transitions);
+    free(r.good_choices);
+    free(r.mark);
+    free(r.in_lost);
     return mec;
 }
 
+/**
+ * MEC decomposition of @a ma. The MECs do not depend on the goal states, so
+ * they are computed only once and kept with the MA.
+ * 
+ * @param ma
+ * @return a copy of the MECs, to be freed by the caller
+ */
+SparseMatrixMEC* mEC_decomposition_previous_algorithm(SparseMatrix *ma){
+    if(ma->mecs == NULL)
+        ma->mecs = compute_mEC_decomposition(ma);
+    return SparseMatrixMEC_copy(ma->mecs);
+}
+
 SparseMatrixMEC* mEC_decomposition_previous_algorithm_without_attractor(SparseMatrix *ma,vector<unsigned long>& mec_states){
     //printf("sccs2.ccp: mEC_decomposition_old_algorithm Start!\n");
     
@@ -673,7 +972,7 @@ SparseMatrixMEC* mEC_decomposition_previous_algorithm_without_attractor(SparseMa
     }
     /* vector to store bad transition information */
     
-    unsigned long *dist_starts = (unsigned long *) ma->row_counts;
+    sparse_index *dist_starts = ma->row_starts;
     unsigned long nr_transitions = dist_starts[ma->n];
 	
     bool *bad_transitions=(bool *) malloc(nr_transitions * sizeof(bool));
@@ -787,8 +1086,8 @@ SparseMatrixMEC* mEC_decomposition_previous_algorithm_without_attractor(SparseMa
     SparseMatrixMEC *mec;
     
     mec=SparseMatrixMEC_new(mec_states_nr,mec_nr-1);
-    unsigned long * cols = mec->cols;
-    unsigned long *row_starts = (unsigned long *) mec->row_counts;
+    sparse_index *cols = mec->cols;
+    sparse_index *row_starts = mec->row_starts;
 
     vector<unsigned long>::const_iterator it;
     unsigned long pos=0;
@@ -817,8 +1116,8 @@ SparseMatrixMEC* mEC_decomposition_previous_algorithm_without_attractor(SparseMa
     row_starts[scc_index] = row_starts[scc_index - 1] + scc_size;
 
 
-    unsigned long *row = (unsigned long *) mec->row_counts;
-    unsigned long *col = mec->cols;
+    sparse_index *row = mec->row_starts;
+    sparse_index *col = mec->cols;
 
     for(unsigned long mec_nr=0; mec_nr < mec->n; mec_nr++) {
             unsigned long mec_start = row[mec_nr];
@@ -826,7 +1125,7 @@ SparseMatrixMEC* mEC_decomposition_previous_algorithm_without_attractor(SparseMa
             dbg_printf("MEC %ld: ",mec_nr+1);
             for(unsigned long state_nr=mec_start; state_nr < mec_end; state_nr++) {
                     //if(ma->goals[col[state_nr]])
-                            dbg_printf("%s ",ma->states_nr.find(col[state_nr])->second.c_str());
+                            dbg_printf("%s ",state_name(ma->names, col[state_nr]));
             }
             dbg_printf("\n");
     }
@@ -0,0 +1,335 @@
+/**
+* IMCA is a analyzing tool for unbounded reachability probabilities, expected-
+* time, and long-run averages for Interactive Markov Chains and Markov Automata.
+* Copyright (C) RWTH Aachen, 2012
+*				UTwente, 2013
+* 	Author: Dennis Guck
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*
+*
+*
+* Source description:
+*	Forward-backward SCC decomposition with trimming. The subproblems of a
+*	decomposition are disjoint, so large ones are searched by OpenMP tasks
+*	of their own. A task reads the colour of states outside its subproblem,
+*	which other tasks may change meanwhile, but such a state never has the
+*	colour of the task.
+*/
+
+#include "sccs_parallel.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+/* subproblems of at least this many states are searched by tasks of their own */
+#define SCC_TASK_MIN_STATES 1024
+
+#define REACHED_FORWARD 1
+#define REACHED_BACKWARD 2
+
+using namespace std;
+
+/**
+* States of one subproblem, all of colour @a color.
+*/
+typedef struct SCCTask
+{
+	unsigned long color;
+	vector<unsigned long> states;
+} SCCTask;
+
+SCCParallel* SCCParallel_new(SparseMatrix *ma, const bool *bad_states, const bool *bad_transitions)
+{
+	unsigned long n = ma->n > 0 ? ma->n : 1;
+	SCCParallel *engine = (SCCParallel *) malloc(sizeof(SCCParallel));
+
+	engine->ma = ma;
+	engine->pred = SparseMatrix_predecessors(ma);
+	engine->bad_states = bad_states;
+	engine->bad_transitions = bad_transitions;
+	engine->next_color = 1;
+	engine->color = (unsigned long *) calloc(n, sizeof(unsigned long));
+	engine->in_degree = (unsigned long *) malloc(n * sizeof(unsigned long));
+	engine->out_degree = (unsigned long *) malloc(n * sizeof(unsigned long));
+	engine->reached = (unsigned char *) calloc(n, sizeof(unsigned char));
+	engine->root = (unsigned long *) malloc(n * sizeof(unsigned long));
+	engine->number = (unsigned long *) malloc(n * sizeof(unsigned long));
+	memset(engine->number, 0xff, n * sizeof(unsigned long));
+	return engine;
+}
+
+void SCCParallel_free(SCCParallel *engine)
+{
+	if (engine == NULL)
+		return;
+	free(engine->color);
+	free(engine->in_degree);
+	free(engine->out_degree);
+	free(engine->reached);
+	free(engine->root);
+	free(engine->number);
+	free(engine);
+}
+
+/**
+* @return true if a choice of @a state_nr which is not bad only leads to
+* itself, so it is an SCC on its own
+*/
+static bool SCCParallel_self_loop(const SCCParallel *engine, unsigned long state_nr)
+{
+	const SparseMatrix *ma = engine->ma;
+	sparse_index *row_starts = ma->row_starts;
+	sparse_index *choice_starts = ma->choice_starts;
+
+	for (unsigned long choice_nr = row_starts[state_nr]; choice_nr < row_starts[state_nr + 1]; choice_nr++) {
+		if (engine->bad_transitions[choice_nr])
+			continue;
+		bool self_loop = true;
+		for (unsigned long i = choice_starts[choice_nr]; i < choice_starts[choice_nr + 1]; i++) {
+			if (ma->cols[i] != state_nr) {
+				self_loop = false;
+				break;
+			}
+		}
+		if (self_loop)
+			return true;
+	}
+	return false;
+}
+
+/**
+* Removes the states of @a task without transitions from or into the other
+* states of @a task, until there are none. They are single states.
+*/
+static void SCCParallel_trim(SCCParallel *engine, SCCTask *task)
+{
+	const SparseMatrix *ma = engine->ma;
+	const Predecessors *pred = engine->pred;
+	sparse_index *row_starts = ma->row_starts;
+	sparse_index *choice_starts = ma->choice_starts;
+	sparse_index *cols = ma->cols;
+	unsigned long *color = engine->color;
+	unsigned long k = task->color;
+	vector<unsigned long> queue;
+
+	for (unsigned long i = 0; i < task->states.size(); i++) {
+		unsigned long u = task->states[i];
+		unsigned long out = 0, in = 0;
+		for (unsigned long choice_nr = row_starts[u]; choice_nr < row_starts[u + 1]; choice_nr++) {
+			if (engine->bad_transitions[choice_nr])
+				continue;
+			for (unsigned long j = choice_starts[choice_nr]; j < choice_starts[choice_nr + 1]; j++) {
+				if (cols[j] != u && color[cols[j]] == k)
+					out++;
+			}
+		}
+		for (unsigned long p = pred->starts[u]; p < pred->starts[u + 1]; p++) {
+			unsigned long choice_nr = pred->choices[p];
+			unsigned long v = pred->states[choice_nr];
+			if (v != u && !engine->bad_transitions[choice_nr] && color[v] == k)
+				in++;
+		}
+		engine->out_degree[u] = out;
+		engine->in_degree[u] = in;
+		if (out == 0 || in == 0)
+			queue.push_back(u);
+	}
+	for (unsigned long i = 0; i < queue.size(); i++) {
+		color[queue[i]] = 0;
+	}
+	for (unsigned long q = 0; q < queue.size(); q++) {
+		unsigned long u = queue[q];
+		engine->root[u] = (unsigned long) -1;
+		for (unsigned long choice_nr = row_starts[u]; choice_nr < row_starts[u + 1]; choice_nr++) {
+			if (engine->bad_transitions[choice_nr])
+				continue;
+			for (unsigned long j = choice_starts[choice_nr]; j < choice_starts[choice_nr + 1]; j++) {
+				unsigned long v = cols[j];
+				if (v != u && color[v] == k && --engine->in_degree[v] == 0) {
+					color[v] = 0;
+					queue.push_back(v);
+				}
+			}
+		}
+		for (unsigned long p = pred->starts[u]; p < pred->starts[u + 1]; p++) {
+			unsigned long choice_nr = pred->choices[p];
+			unsigned long v = pred->states[choice_nr];
+			if (v != u && !engine->bad_transitions[choice_nr] && color[v] == k && --engine->out_degree[v] == 0) {
+				color[v] = 0;
+				queue.push_back(v);
+			}
+		}
+	}
+	if (queue.empty())
+		return;
+
+	unsigned long left = 0;
+	for (unsigned long i = 0; i < task->states.size(); i++) {
+		if (color[task->states[i]] == k)
+			task->states[left++] = task->states[i];
+	}
+	task->states.resize(left);
+}
+
+/**
+* Marks the states of @a task reached from @a pivot with @a flag, forwards or
+* backwards.
+*/
+static void SCCParallel_reach(SCCParallel *engine, SCCTask *task, unsigned long pivot, bool forward, unsigned char flag)
+{
+	const SparseMatrix *ma = engine->ma;
+	const Predecessors *pred = engine->pred;
+	sparse_index *row_starts = ma->row_starts;
+	sparse_index *choice_starts = ma->choice_starts;
+	sparse_index *cols = ma->cols;
+	unsigned long *color = engine->color;
+	unsigned char *reached = engine->reached;
+	unsigned long k = task->color;
+	vector<unsigned long> queue;
+
+	reached[pivot] |= flag;
+	queue.push_back(pivot);
+	for (unsigned long q = 0; q < queue.size(); q++) {
+		unsigned long u = queue[q];
+		if (forward) {
+			for (unsigned long choice_nr = row_starts[u]; choice_nr < row_starts[u + 1]; choice_nr++) {
+				if (engine->bad_transitions[choice_nr])
+					continue;
+				for (unsigned long j = choice_starts[choice_nr]; j < choice_starts[choice_nr + 1]; j++) {
+					unsigned long v = cols[j];
+					if (color[v] == k && !(reached[v] & flag)) {
+						reached[v] |= flag;
+						queue.push_back(v);
+					}
+				}
+			}
+		} else {
+			for (unsigned long p = pred->starts[u]; p < pred->starts[u + 1]; p++) {
+				unsigned long choice_nr = pred->choices[p];
+				unsigned long v = pred->states[choice_nr];
+				if (!engine->bad_transitions[choice_nr] && color[v] == k && !(reached[v] & flag)) {
+					reached[v] |= flag;
+					queue.push_back(v);
+				}
+			}
+		}
+	}
+}
+
+/**
+* Finds the SCCs of @a task and of the subproblems split off from it. The
+* large subproblems are given to new tasks.
+*/
+static void SCCParallel_solve(SCCParallel *engine, SCCTask *task)
+{
+	vector<SCCTask *> stack;
+
+	stack.push_back(task);
+	while (!stack.empty()) {
+		SCCTask *t = stack.back();
+		stack.pop_back();
+		SCCParallel_trim(engine, t);
+		if (t->states.empty()) {
+			delete t;
+			continue;
+		}
+
+		unsigned long pivot = t->states[t->states.size() / 2];
+		SCCParallel_reach(engine, t, pivot, true, REACHED_FORWARD);
+		SCCParallel_reach(engine, t, pivot, false, REACHED_BACKWARD);
+
+		// 0: neither, 1: only forward, 2: only backward, 3: the SCC of the pivot
+		SCCTask *parts[3];
+		for (int i = 0; i < 3; i++) {
+			parts[i] = new SCCTask;
+		}
+		unsigned long scc_size = 0;
+		for (unsigned long i = 0; i < t->states.size(); i++) {
+			unsigned long u = t->states[i];
+			unsigned char r = engine->reached[u];
+			engine->reached[u] = 0;
+			if (r == (REACHED_FORWARD | REACHED_BACKWARD)) {
+				engine->color[u] = 0;
+				engine->root[u] = pivot;
+				scc_size++;
+			} else {
+				parts[r]->states.push_back(u);
+			}
+		}
+		if (scc_size == 1)
+			engine->root[pivot] = (unsigned long) -1;
+		delete t;
+
+		for (int i = 0; i < 3; i++) {
+			SCCTask *part = parts[i];
+			if (part->states.empty()) {
+				delete part;
+				continue;
+			}
+			part->color = __sync_fetch_and_add(&engine->next_color, 1);
+			for (unsigned long j = 0; j < part->states.size(); j++) {
+				engine->color[part->states[j]] = part->color;
+			}
+			if (part->states.size() >= SCC_TASK_MIN_STATES) {
+				#pragma omp task firstprivate(engine, part)
+				SCCParallel_solve(engine, part);
+			} else {
+				stack.push_back(part);
+			}
+		}
+	}
+}
+
+void SCCParallel_decompose(SCCParallel *engine, const vector<unsigned long>& region, bool parallel, vector<unsigned long>& scc_states, unsigned long& scc_nr)
+{
+	SCCTask *task = new SCCTask;
+
+	task->color = __sync_fetch_and_add(&engine->next_color, 1);
+	for (unsigned long i = 0; i < region.size(); i++) {
+		unsigned long u = region[i];
+		if (!engine->bad_states[u]) {
+			engine->color[u] = task->color;
+			task->states.push_back(u);
+		}
+	}
+
+	#pragma omp parallel if(parallel && task->states.size() >= PARALLEL_MIN_STATES)
+	{
+		#pragma omp single
+		SCCParallel_solve(engine, task);
+	}
+
+	for (unsigned long i = 0; i < region.size(); i++) {
+		unsigned long u = region[i];
+		if (engine->bad_states[u])
+			continue;
+		unsigned long r = engine->root[u];
+		if (r == (unsigned long) -1) {
+			if (SCCParallel_self_loop(engine, u))
+				scc_states[u] = scc_nr++;
+		} else {
+			if (engine->number[r] == (unsigned long) -1)
+				engine->number[r] = scc_nr++;
+			scc_states[u] = engine->number[r];
+		}
+	}
+	for (unsigned long i = 0; i < region.size(); i++) {
+		unsigned long u = region[i];
+		if (!engine->bad_states[u] && engine->root[u] != (unsigned long) -1)
+			engine->number[engine->root[u]] = (unsigned long) -1;
+	}
+}
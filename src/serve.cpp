@@ -0,0 +1,591 @@
+/**
+* IMCA is a analyzing tool for unbounded reachability probabilities, expected-
+* time, and long-run averages for Interactive Markov Chains and Markov Automata.
+* Copyright (C) RWTH Aachen, 2012
+*				UTwente, 2013
+* 	Author: Dennis Guck
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*
+* Source description:
+*	Answers queries on a loaded model, read line by line from stdin or
+*	from the clients of a Unix domain socket.
+*/
+
+#include "serve.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <vector>
+
+#include "unbounded.h"
+#include "expected_time.h"
+#include "expected_reward.h"
+#include "long_run_average.h"
+#include "long_run_reward.h"
+#include "bounded.h"
+#include "bounded_reward.h"
+#include "interval_iteration.h"
+#include "topological.h"
+#include "policy_iteration.h"
+
+// Coloured output
+#define COLOR_RED "\x1b[31m" // Color Start
+#define COLOR_END "\x1b[0m" // To flush out prev settings
+
+using namespace std;
+
+/* what a connection should do after a query */
+enum ServeAction { SERVE_CONTINUE, SERVE_QUIT, SERVE_SHUTDOWN };
+
+/**
+* @return wall clock time in seconds
+*/
+static double now(void)
+{
+	#ifndef __APPLE__
+	struct timespec ts;
+	clock_gettime(CLOCK_REALTIME, &ts);
+	return ts.tv_sec + 1e-9 * ts.tv_nsec;
+	#else
+	return (double) clock() / CLOCKS_PER_SEC;
+	#endif
+}
+
+/**
+* Reads a real number of the form "<key>=<value>".
+*
+* @param token the token
+* @param value the number
+* @return false if the value is not a number
+*/
+static bool parse_value(const char *token, Real *value)
+{
+	char *end;
+	const char *start = strchr(token, '=') + 1;
+	*value = strtod(start, &end);
+	return end != start && *end == '\0';
+}
+
+/**
+* Initialises a query with the default options.
+*
+* @param q the query
+* @param analysis ub, et, er, lra, lrr, tb or tr
+* @return false if the analysis is unknown
+*/
+bool query_init(Query *q, const char *analysis)
+{
+	memset(q, 0, sizeof(Query));
+	q->epsilon = 1e-6;
+	strncpy(q->analysis, analysis, sizeof(q->analysis) - 1);
+	return strcmp(analysis, "ub") == 0 || strcmp(analysis, "et") == 0 || strcmp(analysis, "er") == 0
+			|| strcmp(analysis, "lra") == 0 || strcmp(analysis, "lrr") == 0 || strcmp(analysis, "tb") == 0
+			|| strcmp(analysis, "tr") == 0;
+}
+
+/**
+* @return true if the analysis of the query needs rewards
+*/
+static bool needs_rewards(const Query *q)
+{
+	return strcmp(q->analysis, "er") == 0 || strcmp(q->analysis, "lrr") == 0 || strcmp(q->analysis, "tr") == 0;
+}
+
+/**
+* Parses a query line.
+*
+* @param line the line (is changed)
+* @param q the query
+* @param error will point to the reason if the query is invalid
+* @return false if the query is invalid
+*/
+bool parse_query(char *line, Query *q, const char **error)
+{
+	char *save;
+	char *token = strtok_r(line, " \t\r\n", &save);
+
+	if (token == NULL || !query_init(q, token)) {
+		*error = "unknown analysis";
+		return false;
+	}
+
+	while ((token = strtok_r(NULL, " \t\r\n", &save)) != NULL) {
+		bool valid = true;
+		if (strcmp(token, "max") == 0) {
+			q->max = true;
+		} else if (strcmp(token, "min") == 0) {
+			q->min = true;
+		} else if (strcmp(token, "val") == 0) {
+			q->val = true;
+		} else if (strcmp(token, "sound") == 0) {
+			q->sound = true;
+		} else if (strcmp(token, "topo") == 0) {
+			q->topo = true;
+		} else if (strcmp(token, "pi") == 0) {
+			q->pi = true;
+		} else if (strncmp(token, "T=", 2) == 0) {
+			valid = parse_value(token, &q->tb) && q->tb > 0;
+			q->has_tb = true;
+		} else if (strncmp(token, "F=", 2) == 0) {
+			valid = parse_value(token, &q->ta) && q->ta >= 0;
+		} else if (strncmp(token, "e=", 2) == 0) {
+			valid = parse_value(token, &q->epsilon) && q->epsilon > 0;
+		} else if (strncmp(token, "i=", 2) == 0) {
+			valid = parse_value(token, &q->interval) && q->interval > 0;
+		} else if (strncmp(token, "b=", 2) == 0) {
+			valid = parse_value(token, &q->interval_start) && q->interval_start >= 0;
+		} else {
+			*error = "unknown option";
+			return false;
+		}
+		if (!valid) {
+			*error = "invalid value";
+			return false;
+		}
+	}
+
+	if (!q->max && !q->min) {
+		*error = "no min or max";
+		return false;
+	}
+	if ((strcmp(q->analysis, "tb") == 0 || strcmp(q->analysis, "tr") == 0) && !q->has_tb) {
+		*error = "no upper bound T";
+		return false;
+	}
+	if (q->has_tb && q->ta >= q->tb) {
+		*error = "lower bound F not below upper bound T";
+		return false;
+	}
+	return true;
+}
+
+/**
+* Long-run reward as computed by main: if there are no goal states, all
+* states count as goal states.
+*
+* @param ma the MA
+* @param max maximum/minimum
+* @return long-run reward
+*/
+static Real serve_long_run_reward(SparseMatrix *ma, bool max)
+{
+	bool has_goal = false;
+	for (unsigned long state_nr = 0; state_nr < ma->n && !has_goal; state_nr++)
+		has_goal = ma->goals[state_nr];
+	if (has_goal)
+		return compute_long_run_reward(ma, max);
+
+	for (unsigned long state_nr = 0; state_nr < ma->n; state_nr++)
+		ma->goals[state_nr] = true;
+	SparseMatrix_goals_changed(ma);
+	Real result = compute_long_run_reward(ma, max);
+	for (unsigned long state_nr = 0; state_nr < ma->n; state_nr++)
+		ma->goals[state_nr] = false;
+	SparseMatrix_goals_changed(ma);
+	return result;
+}
+
+/**
+* Computes one optimum of a query.
+*
+* @param ma the MA
+* @param q the query
+* @param max maximum/minimum
+* @param is_imc true if the MA is an IMC
+* @return the result
+*/
+static Real run_query(SparseMatrix *ma, const Query *q, bool max, bool is_imc)
+{
+	const char *a = q->analysis;
+	Real interval = (q->interval == 0) ? q->tb : q->interval;
+	Real lower, upper;
+
+	if (q->sound && strcmp(a, "ub") == 0)
+		return interval_iteration(ma, OBJECTIVE_REACHABILITY, max, q->epsilon, &lower, &upper);
+	if (q->sound && strcmp(a, "et") == 0)
+		return interval_iteration(ma, OBJECTIVE_EXPECTED_TIME, max, q->epsilon, &lower, &upper);
+	if (q->sound && strcmp(a, "er") == 0)
+		return interval_iteration(ma, OBJECTIVE_EXPECTED_REWARD, max, q->epsilon, &lower, &upper);
+	if (q->topo && strcmp(a, "ub") == 0)
+		return topological_value_iteration(ma, OBJECTIVE_REACHABILITY, max);
+	if (q->topo && strcmp(a, "et") == 0)
+		return topological_value_iteration(ma, OBJECTIVE_EXPECTED_TIME, max);
+	if (q->topo && strcmp(a, "er") == 0)
+		return topological_value_iteration(ma, OBJECTIVE_EXPECTED_REWARD, max);
+	if (q->pi && strcmp(a, "ub") == 0)
+		return policy_iteration(ma, OBJECTIVE_REACHABILITY, max);
+	if (q->pi && strcmp(a, "et") == 0)
+		return policy_iteration(ma, OBJECTIVE_EXPECTED_TIME, max);
+	if (q->pi && strcmp(a, "er") == 0)
+		return policy_iteration(ma, OBJECTIVE_EXPECTED_REWARD, max);
+	if (strcmp(a, "ub") == 0)
+		return q->val ? unbounded_value_iteration(ma, max) : compute_unbounded_reachability(ma, max);
+	if (strcmp(a, "et") == 0)
+		return q->val ? expected_time_value_iteration(ma, max) : compute_expected_time(ma, max);
+	if (strcmp(a, "er") == 0)
+		return expected_reward_value_iteration(ma, max);
+	if (strcmp(a, "lra") == 0)
+		return compute_long_run_average(ma, max);
+	if (strcmp(a, "lrr") == 0)
+		return serve_long_run_reward(ma, max);
+	if (strcmp(a, "tb") == 0)
+		return compute_time_bounded_reachability(ma, max, q->epsilon, q->ta, q->tb, is_imc, interval, q->interval_start, NULL);
+	return compute_time_bounded_accumulated_reward(ma, max, q->epsilon, q->ta, q->tb, is_imc, interval, q->interval_start);
+}
+
+/**
+* Computes the maximum and the minimum of a query at once, if its analysis
+* supports it.
+*
+* @param ma the MA
+* @param q the query, with max and min
+* @param is_imc true if the MA is an IMC
+* @param max_result the maximum
+* @param min_result the minimum
+* @return false if the optima have to be computed one by one
+*/
+static bool run_query_both(SparseMatrix *ma, const Query *q, bool is_imc, Real *max_result, Real *min_result)
+{
+	Real interval = (q->interval == 0) ? q->tb : q->interval;
+
+	if (strcmp(q->analysis, "tb") != 0)
+		return false;
+	compute_time_bounded_reachability_both(ma, q->epsilon, q->ta, q->tb, is_imc, interval, q->interval_start, max_result, min_result, NULL);
+	return true;
+}
+
+/**
+* Answers one query line.
+*
+* @param line the line (is changed)
+* @param out where the answers are written to
+* @param ma the MA
+* @param mrm true if the MA has rewards
+* @param is_imc true if the MA is an IMC
+* @return what the connection should do next
+*/
+static ServeAction answer_line(char *line, FILE *out, SparseMatrix *ma, bool mrm, bool is_imc)
+{
+	Query q;
+	const char *error = NULL;
+	char *start = line + strspn(line, " \t\r\n");
+
+	/* skip empty lines and comments */
+	if (*start == '\0' || *start == '#')
+		return SERVE_CONTINUE;
+	if (strncmp(start, "quit", 4) == 0 && start[4 + strspn(start + 4, " \t\r\n")] == '\0')
+		return SERVE_QUIT;
+	if (strncmp(start, "shutdown", 8) == 0 && start[8 + strspn(start + 8, " \t\r\n")] == '\0')
+		return SERVE_SHUTDOWN;
+	if (strncmp(start, "info", 4) == 0 && start[4 + strspn(start + 4, " \t\r\n")] == '\0') {
+		fprintf(out, "states %lu ms %lu choices %lu transitions %lu\nok\n", ma->n, ma->ms_n, ma->choices_n, ma->non_zero_n);
+		return SERVE_CONTINUE;
+	}
+
+	if (!parse_query(start, &q, &error)) {
+		fprintf(out, "error %s\n", error);
+		return SERVE_CONTINUE;
+	}
+	if (!mrm && needs_rewards(&q)) {
+		fprintf(out, "error model has no rewards\n");
+		return SERVE_CONTINUE;
+	}
+
+	Real max_result, min_result;
+	double begin = now();
+	if (q.max && q.min && run_query_both(ma, &q, is_imc, &max_result, &min_result)) {
+		double end = now();
+		fprintf(out, "%s max %.10g %f\n", q.analysis, max_result, end - begin);
+		fprintf(out, "%s min %.10g %f\n", q.analysis, min_result, end - begin);
+		fflush(out);
+	} else {
+		for (int i = 0; i < 2; i++) {
+			bool max = (i == 0);
+			if ((max && !q.max) || (!max && !q.min))
+				continue;
+			begin = now();
+			Real result = run_query(ma, &q, max, is_imc);
+			double end = now();
+			fprintf(out, "%s %s %.10g %f\n", q.analysis, max ? "max" : "min", result, end - begin);
+			fflush(out);
+		}
+	}
+	fprintf(out, "ok\n");
+	return SERVE_CONTINUE;
+}
+
+/**
+* Answers the queries of one connection.
+*
+* @param in where the queries are read from
+* @param out where the answers are written to
+* @param ma the MA
+* @param mrm true if the MA has rewards
+* @param is_imc true if the MA is an IMC
+* @return SERVE_SHUTDOWN if the server should stop
+*/
+static ServeAction serve_connection(FILE *in, FILE *out, SparseMatrix *ma, bool mrm, bool is_imc)
+{
+	char line[MAX_QUERY_LENGTH];
+	ServeAction action = SERVE_CONTINUE;
+
+	while (action == SERVE_CONTINUE && fgets(line, MAX_QUERY_LENGTH, in) != NULL) {
+		if (strchr(line, '\n') == NULL && !feof(in)) {
+			/* skip the rest of the overlong line */
+			int c;
+			while ((c = fgetc(in)) != EOF && c != '\n')
+				;
+			fprintf(out, "error query too long\n");
+		} else {
+			action = answer_line(line, out, ma, mrm, is_imc);
+		}
+		fflush(out);
+	}
+	return action;
+}
+
+/**
+* Answers queries on MA @a ma, see serve.h.
+*
+* @param ma the MA
+* @param mrm true if the MA has rewards
+* @param is_imc true if the MA is an IMC
+* @param socket_path Unix domain socket, stdin if NULL
+* @return EXIT_SUCCESS, or EXIT_FAILURE if the socket or the output could not be opened
+*/
+int serve_queries(SparseMatrix *ma, bool mrm, bool is_imc, const char *socket_path)
+{
+	/* the analyses report their progress on stdout, keep it apart from the answers */
+	fflush(stdout);
+	if (socket_path == NULL) {
+		int out_fd = dup(STDOUT_FILENO);
+		FILE *out = (out_fd < 0) ? NULL : fdopen(out_fd, "w");
+		if (out == NULL) {
+			fprintf(stderr, COLOR_RED "Could not open the output for the answers: %s\n" COLOR_END, strerror(errno));
+			if (out_fd >= 0)
+				close(out_fd);
+			return EXIT_FAILURE;
+		}
+		dup2(STDERR_FILENO, STDOUT_FILENO);
+		serve_connection(stdin, out, ma, mrm, is_imc);
+		fclose(out);
+		return EXIT_SUCCESS;
+	}
+
+	struct sockaddr_un addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	if (strlen(socket_path) >= sizeof(addr.sun_path)) {
+		fprintf(stderr, COLOR_RED "The socket path \"%s\" is too long.\n" COLOR_END, socket_path);
+		return EXIT_FAILURE;
+	}
+	strcpy(addr.sun_path, socket_path);
+
+	int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0) {
+		fprintf(stderr, COLOR_RED "Could not create socket: %s\n" COLOR_END, strerror(errno));
+		return EXIT_FAILURE;
+	}
+	unlink(socket_path);
+	if (bind(fd, (struct sockaddr *) &addr, sizeof(addr)) != 0 || listen(fd, 8) != 0) {
+		fprintf(stderr, COLOR_RED "Could not listen on socket \"%s\": %s\n" COLOR_END, socket_path, strerror(errno));
+		close(fd);
+		return EXIT_FAILURE;
+	}
+
+	/* a client leaving early must not kill the server */
+	signal(SIGPIPE, SIG_IGN);
+	printf("Waiting for queries on socket '%s'.\n", socket_path);
+	fflush(stdout);
+
+	ServeAction action = SERVE_CONTINUE;
+	while (action != SERVE_SHUTDOWN) {
+		int client = accept(fd, NULL, NULL);
+		if (client < 0) {
+			if (errno == EINTR)
+				continue;
+			fprintf(stderr, COLOR_RED "Could not accept connection: %s\n" COLOR_END, strerror(errno));
+			break;
+		}
+		/* a connection which cannot be set up is dropped, the others are still served */
+		FILE *in = fdopen(client, "r");
+		if (in == NULL) {
+			fprintf(stderr, COLOR_RED "Could not open connection: %s\n" COLOR_END, strerror(errno));
+			close(client);
+			continue;
+		}
+		int out_fd = dup(client);
+		FILE *out = (out_fd < 0) ? NULL : fdopen(out_fd, "w");
+		if (out == NULL) {
+			fprintf(stderr, COLOR_RED "Could not open connection: %s\n" COLOR_END, strerror(errno));
+			if (out_fd >= 0)
+				close(out_fd);
+			fclose(in);
+			continue;
+		}
+		action = serve_connection(in, out, ma, mrm, is_imc);
+		fclose(out);
+		fclose(in);
+	}
+
+	close(fd);
+	unlink(socket_path);
+	return EXIT_SUCCESS;
+}
+
+/**
+* Reads the queries of a batch file, one query per line. Empty lines and
+* lines starting with '#' are skipped.
+*
+* @param filename the batch file, stdin for "-"
+* @param queries the queries are appended here
+* @return false if the file could not be read or contains an invalid query
+*/
+bool read_query_file(const char *filename, vector<Query> &queries)
+{
+	char line[MAX_QUERY_LENGTH];
+	unsigned long line_no = 0;
+	bool error = false;
+	FILE *in = (strcmp(filename, "-") == 0) ? stdin : fopen(filename, "r");
+
+	if (in == NULL) {
+		fprintf(stderr, COLOR_RED "Could not open file \"%s\"\n" COLOR_END, filename);
+		return false;
+	}
+	while (!error && fgets(line, MAX_QUERY_LENGTH, in) != NULL) {
+		Query q;
+		const char *reason = NULL;
+		char *start = line + strspn(line, " \t\r\n");
+		line_no++;
+		if (strchr(line, '\n') == NULL && !feof(in)) {
+			fprintf(stderr, COLOR_RED "Line %lu: query too long.\n" COLOR_END, line_no);
+			error = true;
+		} else if (*start == '\0' || *start == '#') {
+			/* skip empty lines and comments */
+		} else if (!parse_query(start, &q, &reason)) {
+			fprintf(stderr, COLOR_RED "Line %lu: %s.\n" COLOR_END, line_no, reason);
+			error = true;
+		} else {
+			queries.push_back(q);
+		}
+	}
+	if (in != stdin)
+		fclose(in);
+	return !error;
+}
+
+/**
+* @return true if the query can be answered by a shared sweep over time bounds
+*/
+static bool is_sweepable(const Query *q)
+{
+	return strcmp(q->analysis, "tb") == 0 && q->ta == 0 && q->interval == 0;
+}
+
+/**
+* Answers all queries of a batch, see serve.h.
+*
+* @param ma the MA
+* @param mrm true if the MA has rewards
+* @param is_imc true if the MA is an IMC
+* @param queries the queries
+* @param out where the results are written to
+* @return EXIT_SUCCESS, or EXIT_FAILURE if a query can not be answered
+*/
+int run_batch(SparseMatrix *ma, bool mrm, bool is_imc, const vector<Query> &queries, FILE *out)
+{
+	unsigned long num_queries = queries.size();
+	vector<Real> max_results(num_queries, 0);
+	vector<Real> min_results(num_queries, 0);
+	vector<double> max_times(num_queries, 0);
+	vector<double> min_times(num_queries, 0);
+	vector<bool> done(num_queries, false);
+
+	for (unsigned long k = 0; k < num_queries; k++) {
+		if (!mrm && needs_rewards(&queries[k])) {
+			fprintf(stderr, COLOR_RED "The query '%s' needs a model with rewards.\n" COLOR_END, queries[k].analysis);
+			return EXIT_FAILURE;
+		}
+	}
+
+	/* time-bounded reachability on [0,T] with the same error bound shares one sweep */
+	for (unsigned long k = 0; k < num_queries; k++) {
+		if (done[k] || !is_sweepable(&queries[k]))
+			continue;
+		vector<unsigned long> group;
+		vector<Real> tbs;
+		bool max = false;
+		bool min = false;
+		for (unsigned long j = k; j < num_queries; j++) {
+			if (!done[j] && is_sweepable(&queries[j]) && queries[j].epsilon == queries[k].epsilon) {
+				group.push_back(j);
+				tbs.push_back(queries[j].tb);
+				max = max || queries[j].max;
+				min = min || queries[j].min;
+				done[j] = true;
+			}
+		}
+		vector<Real> max_probs, min_probs;
+		vector<double> max_secs, min_secs;
+		compute_time_bounded_reachability_sweep(ma, queries[k].epsilon, tbs, is_imc, max, min, max_probs, min_probs, max_secs, min_secs);
+		for (unsigned long g = 0; g < group.size(); g++) {
+			max_results[group[g]] = max_probs[g];
+			min_results[group[g]] = min_probs[g];
+			max_times[group[g]] = max_secs[g];
+			min_times[group[g]] = min_secs[g];
+		}
+	}
+
+	/* everything else is answered one by one */
+	for (unsigned long k = 0; k < num_queries; k++) {
+		if (done[k])
+			continue;
+		double begin = now();
+		if (queries[k].max && queries[k].min
+				&& run_query_both(ma, &queries[k], is_imc, &max_results[k], &min_results[k])) {
+			max_times[k] = min_times[k] = now() - begin;
+			continue;
+		}
+		if (queries[k].max) {
+			double begin = now();
+			max_results[k] = run_query(ma, &queries[k], true, is_imc);
+			max_times[k] = now() - begin;
+		}
+		if (queries[k].min) {
+			double begin = now();
+			min_results[k] = run_query(ma, &queries[k], false, is_imc);
+			min_times[k] = now() - begin;
+		}
+	}
+
+	fprintf(out, "analysis,objective,F,T,e,value,seconds\n");
+	for (unsigned long k = 0; k < num_queries; k++) {
+		const Query *q = &queries[k];
+		if (q->max)
+			fprintf(out, "%s,max,%g,%g,%g,%.10g,%f\n", q->analysis, q->ta, q->tb, q->epsilon, max_results[k], max_times[k]);
+		if (q->min)
+			fprintf(out, "%s,min,%g,%g,%g,%.10g,%f\n", q->analysis, q->ta, q->tb, q->epsilon, min_results[k], min_times[k]);
+	}
+	fflush(out);
+	return EXIT_SUCCESS;
+}
@@ -24,8 +24,12 @@
 */
 
 #include "sparse.h"
+#include "sccs2.h"
 
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
 
 #include "debug.h"
 
@@ -33,33 +37,40 @@
 * Creates a new MA with given number of states.
 *
 * @param num_states number of states of new MA
+* @param names state names, the MA takes over the reference
 * @return new MA
 */
-SparseMatrix *SparseMatrix_new(unsigned long num_states, map<string,unsigned long> states, map<unsigned long,string> states_nr)
+SparseMatrix *SparseMatrix_new(unsigned long num_states, StateNames *names)
 {
-	unsigned long *row_starts = (unsigned long *) calloc((size_t) (num_states + 1),sizeof(unsigned long));
-	unsigned long *rate_starts = (unsigned long *) calloc((size_t) (num_states + 1),sizeof(unsigned long));
+	sparse_index *row_starts = (sparse_index *) calloc((size_t) (num_states + 1),sizeof(sparse_index));
+	sparse_index *rate_starts = (sparse_index *) calloc((size_t) (num_states + 1),sizeof(sparse_index));
 	bool * initials = (bool *) malloc(num_states * sizeof(bool));
 	bool * goals = (bool *) malloc(num_states * sizeof(bool));
 	bool * isPS = (bool *) malloc(num_states * sizeof(bool));
 	//SparseMatrix *model = (SparseMatrix*)malloc(sizeof(SparseMatrix));
     SparseMatrix *model=new SparseMatrix;
 	model->n = num_states;
-	//cout << "" ; // This line currently prevents a segmentation fault under OSX. Do not delete it! TODO: fix this.
-    model->states = states;
-	model->states_nr = states_nr;
-    //model->states.insert(states.begin(),states.end());
-    //model->states_nr.insert(states_nr.begin(),states_nr.end());
+	model->names = names;
 	model->initials = initials;
 	model->goals = goals;
 	model->isPS = isPS;
 	model->rewards = NULL;
 	model->non_zeros = NULL;
 	model->exit_rates = NULL;
-	model->row_counts = (unsigned char *) row_starts;
-	model->rate_counts = (unsigned char *) rate_starts;
+	model->row_starts = row_starts;
+	model->rate_starts = rate_starts;
 	model->cols = NULL;
-	model->choice_counts = NULL;
+	model->choice_starts = NULL;
+	model->branching = NULL;
+	model->state_rates = NULL;
+	model->mapping = NULL;
+	model->mapping_size = 0;
+	model->locks_strong = NULL;
+	model->locks_weak = NULL;
+	model->mecs = NULL;
+	model->pred = NULL;
+	model->discrete = NULL;
+	model->discrete_tau = 0;
 	return model;
 }
 
@@ -71,16 +82,32 @@ SparseMatrix *SparseMatrix_new(unsigned long num_states, map<string,unsigned lon
 */
 SparseMatrixMEC *SparseMatrixMEC_new(unsigned long num_states, unsigned long num_mecs)
 {
-	unsigned long *row_starts = (unsigned long *) calloc((size_t) (num_mecs + 1),sizeof(unsigned long));
-	unsigned long * cols = (unsigned long *) malloc(num_states * sizeof(unsigned long));
+	sparse_index *row_starts = (sparse_index *) calloc((size_t) (num_mecs + 1),sizeof(sparse_index));
+	sparse_index *cols = (sparse_index *) malloc(num_states * sizeof(sparse_index));
 	//SparseMatrixMEC *mec = (SparseMatrixMEC*)malloc(sizeof(SparseMatrixMEC));
     SparseMatrixMEC *mec =new SparseMatrixMEC;
 	mec->n = num_mecs;
-	mec->row_counts = (unsigned char *) row_starts;
+	mec->row_starts = row_starts;
 	mec->cols = cols;
 	return mec;
 }
 
+/**
+* Creates a copy of a MEC decomposition.
+*
+* @param mecs the MECs
+* @return new MECs
+*/
+SparseMatrixMEC *SparseMatrixMEC_copy(const SparseMatrixMEC *mecs)
+{
+	sparse_index *row_starts = mecs->row_starts;
+	unsigned long num_states = (mecs->n > 0) ? row_starts[mecs->n] : 0;
+	SparseMatrixMEC *copy = SparseMatrixMEC_new(num_states, mecs->n);
+	memcpy(copy->row_starts, mecs->row_starts, (mecs->n + 1) * sizeof(sparse_index));
+	memcpy(copy->cols, mecs->cols, num_states * sizeof(sparse_index));
+	return copy;
+}
+
 /**
 * Creates a new MA with given number of states.
 *
@@ -93,9 +120,9 @@ SparseMatrix *SparseMatrixDiscrete_new(SparseMatrix *ma)
 	unsigned long num_ms=ma->ms_n;
 	unsigned long num_states = ma->n;
 	unsigned long num_choices = ma->choices_n;
-	unsigned long *row_starts = (unsigned long *) calloc((size_t) (num_states + 1),sizeof(unsigned long));
-	unsigned long *rate_starts = (unsigned long *) calloc((size_t) (num_states + 1),sizeof(unsigned long));
-	unsigned long * choice_starts = (unsigned long *) calloc((size_t) (num_choices + 1), sizeof(unsigned long));
+	sparse_index *row_starts = (sparse_index *) calloc((size_t) (num_states + 1),sizeof(sparse_index));
+	sparse_index *rate_starts = (sparse_index *) calloc((size_t) (num_states + 1),sizeof(sparse_index));
+	sparse_index *choice_starts = (sparse_index *) calloc((size_t) (num_choices + 1), sizeof(sparse_index));
 	bool * initials = (bool *) malloc(num_states * sizeof(bool));
 	bool * goals = (bool *) malloc(num_states * sizeof(bool));
 	bool * isPS = (bool *) malloc(num_states * sizeof(bool));
@@ -105,29 +132,40 @@ SparseMatrix *SparseMatrixDiscrete_new(SparseMatrix *ma)
 	model->n = num_states;
 	model->ms_n = num_ms;
 	model->choices_n = num_choices;
-	// Copy maps
-	model->states = ma->states;
-	model->states_nr = ma->states_nr;
+	// Share state names
+	model->names = ma->names;
+	if (model->names != NULL)
+		model->names->refs++;
 	model->initials = initials;
 	model->goals = goals;
 	model->isPS = isPS;
 	model->exit_rates = exit_rates;
 	model->max_exit_rate=ma->max_exit_rate;
-	model->row_counts = (unsigned char *) row_starts;
-	model->rate_counts = (unsigned char *) rate_starts;
-	model->choice_counts = (unsigned char *) choice_starts;
+	model->row_starts = row_starts;
+	model->rate_starts = rate_starts;
+	model->choice_starts = choice_starts;
 	model->rewards = NULL;
+	model->branching = NULL;
+	model->state_rates = NULL;
+	model->mapping = NULL;
+	model->mapping_size = 0;
+	model->locks_strong = NULL;
+	model->locks_weak = NULL;
+	model->mecs = NULL;
+	model->pred = NULL;
+	model->discrete = NULL;
+	model->discrete_tau = 0;
 	
 	// values to assign
 	initials = (bool *) model->initials;
 	goals = (bool *)model->goals;
 	isPS = (bool *)model->isPS;
 	exit_rates = model->exit_rates;
-	rate_starts = (unsigned long *) model->rate_counts;
-	row_starts = (unsigned long *) model->row_counts;
+	rate_starts = model->rate_starts;
+	row_starts = model->row_starts;
 	// help values from MA
-	unsigned long *ma_row_starts = (unsigned long *) ma->row_counts;
-	//unsigned long *ma_rate_starts = (unsigned long *) ma->rate_counts;
+	sparse_index *ma_row_starts = ma->row_starts;
+	//sparse_index *ma_rate_starts = ma->rate_starts;
 	// copy values
 	for(unsigned long state_nr=0; state_nr < num_states; state_nr++){
 		// copy bool values for initials, goals and isPS
@@ -156,15 +194,15 @@ SparseMatrix *SparseMatrixDiscrete_new(SparseMatrix *ma)
 	// detect new number of non_zeros and choice_counts entries
 	unsigned long num_non_zeros = ma->non_zero_n + num_ms;
 	Real * non_zeros = (Real *) malloc(num_non_zeros * sizeof(Real));
-	unsigned long * cols = (unsigned long *) malloc(num_non_zeros * sizeof(unsigned long));
+	sparse_index *cols = (sparse_index *) malloc(num_non_zeros * sizeof(sparse_index));
 	Real * rewards = (Real *) malloc(num_choices * sizeof(Real));
 	model->non_zeros = non_zeros;
 	model->rewards = rewards;
 	model->cols = cols;
 	model->non_zero_n = num_non_zeros;
-	choice_starts = (unsigned long *) model->choice_counts;
+	choice_starts = model->choice_starts;
 	int offset=0;
-	unsigned long *ma_choice_starts = (unsigned long *) ma->choice_counts;
+	sparse_index *ma_choice_starts = ma->choice_starts;
 	for (unsigned long state_nr = 0; state_nr < ma->n; state_nr++) {
 		unsigned long state_start = ma_row_starts[state_nr];
 		unsigned long state_end = ma_row_starts[state_nr + 1];
@@ -212,6 +250,19 @@ void SparseMatrix_free(SparseMatrix *sparse) {
 		dbg_printf("Sparse is free\n");
 		return;
 	}
+	if (sparse->mapping != NULL) {
+		/* the transitions point into the mapped compiled model */
+		dbg_printf("unmap compiled model\n");
+		munmap(sparse->mapping, sparse->mapping_size);
+		sparse->mapping = NULL;
+		sparse->non_zeros = NULL;
+		sparse->rewards = NULL;
+		sparse->exit_rates = NULL;
+		sparse->cols = NULL;
+		sparse->row_starts = NULL;
+		sparse->rate_starts = NULL;
+		sparse->choice_starts = NULL;
+	}
 	if (sparse->initials != NULL) {
 		dbg_printf("free initials\n");
 		free(sparse->initials);
@@ -240,26 +291,334 @@ void SparseMatrix_free(SparseMatrix *sparse) {
 		dbg_printf("free cols\n");
 		free(sparse->cols);
 	}
-	if (NULL != sparse->row_counts) {
+	if (NULL != sparse->row_starts) {
 		dbg_printf("free row counts\n");
-		free(sparse->row_counts);
+		free(sparse->row_starts);
 	}
-	if (NULL != sparse->rate_counts) {
+	if (NULL != sparse->rate_starts) {
 		dbg_printf("free rate counts\n");
-		free(sparse->rate_counts);
+		free(sparse->rate_starts);
 	}
-	if (NULL != sparse->choice_counts) {
+	if (NULL != sparse->choice_starts) {
 		dbg_printf("free choice counts\n");
-		free(sparse->choice_counts);
+		free(sparse->choice_starts);
 	}
-    
-    sparse->states.clear();
-    sparse->states_nr.clear();
-	
+	free(sparse->branching);
+	free(sparse->state_rates);
+	sparse->branching = NULL;
+	sparse->state_rates = NULL;
+	if (sparse->pred != NULL) {
+		free(sparse->pred->starts);
+		free(sparse->pred->choices);
+		free(sparse->pred->states);
+		free(sparse->pred);
+		sparse->pred = NULL;
+	}
+	StateNames_free(sparse->names);
+	sparse->names = NULL;
+	if (sparse->discrete != NULL) {
+		dbg_printf("free discretised model\n");
+		SparseMatrix_free(sparse->discrete);
+		delete sparse->discrete;
+		sparse->discrete = NULL;
+	}
+	SparseMatrix_goals_changed(sparse);
+	if (sparse->mecs != NULL) {
+		dbg_printf("free MECs\n");
+		SparseMatrixMEC_free(sparse->mecs);
+		delete sparse->mecs;
+		sparse->mecs = NULL;
+	}
+
 	//dbg_printf("free sparse matrix\n");
 	//free(sparse);
 }
 
+/**
+* Checks that a MA of the given size can be indexed with sparse_index. One
+* transition per state is kept in reserve for the self-loops added by the
+* discretisation.
+*
+* @param num_states # of states
+* @param num_choices # of choices
+* @param num_non_zeros # of transitions
+* @return false if the MA is too large
+*/
+bool SparseMatrix_fits(unsigned long num_states, unsigned long num_choices, unsigned long num_non_zeros)
+{
+	if (num_states > SPARSE_INDEX_MAX || num_choices > SPARSE_INDEX_MAX
+			|| num_non_zeros > SPARSE_INDEX_MAX - num_states) {
+		fprintf(stderr, "The model has too many transitions for %lu bit indices, build IMCA with -DIMCA_LONG_INDEX.\n",
+				(unsigned long) (8 * sizeof(sparse_index)));
+		return false;
+	}
+	return true;
+}
+
+/**
+* Computes the branching probabilities and the exit rate of every state, once
+* per MA. The kernels over Markovian states can then multiply with the
+* branching probabilities instead of dividing by the exit rate in every sweep.
+* Has to be called before the kernels are run, and again after the
+* transitions of @a ma were changed (which makes the old values invalid).
+*
+* @param ma the MA
+*/
+void SparseMatrix_prepare(SparseMatrix *ma)
+{
+	if (ma->branching != NULL)
+		return;
+	sparse_index *row_starts = ma->row_starts;
+	sparse_index *rate_starts = ma->rate_starts;
+	sparse_index *choice_starts = ma->choice_starts;
+	Real *non_zeros = ma->non_zeros;
+	Real *branching = (Real *) malloc((ma->non_zero_n > 0 ? ma->non_zero_n : 1) * sizeof(Real));
+	Real *state_rates = (Real *) malloc((ma->n > 0 ? ma->n : 1) * sizeof(Real));
+
+	for (unsigned long state_nr = 0; state_nr < ma->n; state_nr++) {
+		unsigned long r_start = rate_starts[state_nr];
+		unsigned long r_end = rate_starts[state_nr + 1];
+		bool markovian = !ma->isPS[state_nr] && r_start < r_end;
+		Real exit_rate = markovian ? ma->exit_rates[r_start] : 0;
+		state_rates[state_nr] = exit_rate;
+		for (unsigned long choice_nr = row_starts[state_nr]; choice_nr < row_starts[state_nr + 1]; choice_nr++) {
+			for (unsigned long i = choice_starts[choice_nr]; i < choice_starts[choice_nr + 1]; i++)
+				branching[i] = markovian ? non_zeros[i] / exit_rate : non_zeros[i];
+		}
+	}
+	ma->branching = branching;
+	ma->state_rates = state_rates;
+}
+
+/**
+* Gives the predecessor choices of every state, computed on the first call
+* and kept with the MA for all further backward searches. They depend on the
+* transitions only, not on the goal states.
+*
+* @param ma the MA
+* @return the predecessor choices of the states of @a ma
+*/
+const Predecessors *SparseMatrix_predecessors(SparseMatrix *ma)
+{
+	if (ma->pred != NULL)
+		return ma->pred;
+	unsigned long n = ma->n;
+	sparse_index *row_starts = ma->row_starts;
+	sparse_index *choice_starts = ma->choice_starts;
+	sparse_index *cols = ma->cols;
+	unsigned long choices_n = row_starts[n];
+	unsigned long transitions_n = choice_starts[choices_n];
+
+	Predecessors *pred = (Predecessors *) malloc(sizeof(Predecessors));
+	pred->starts = (sparse_index *) calloc(n + 1, sizeof(sparse_index));
+	pred->choices = (sparse_index *) malloc((transitions_n > 0 ? transitions_n : 1) * sizeof(sparse_index));
+	pred->states = (sparse_index *) malloc((choices_n > 0 ? choices_n : 1) * sizeof(sparse_index));
+	sparse_index *next = (sparse_index *) malloc((n > 0 ? n : 1) * sizeof(sparse_index));
+
+	for (unsigned long state_nr = 0; state_nr < n; state_nr++) {
+		for (unsigned long choice_nr = row_starts[state_nr]; choice_nr < row_starts[state_nr + 1]; choice_nr++)
+			pred->states[choice_nr] = state_nr;
+	}
+	for (unsigned long i = 0; i < transitions_n; i++)
+		pred->starts[cols[i] + 1]++;
+	for (unsigned long state_nr = 0; state_nr < n; state_nr++) {
+		pred->starts[state_nr + 1] += pred->starts[state_nr];
+		next[state_nr] = pred->starts[state_nr];
+	}
+	for (unsigned long choice_nr = 0; choice_nr < choices_n; choice_nr++) {
+		for (unsigned long i = choice_starts[choice_nr]; i < choice_starts[choice_nr + 1]; i++)
+			pred->choices[next[cols[i]]++] = choice_nr;
+	}
+	free(next);
+	ma->pred = pred;
+	return pred;
+}
+
+/**
+* Partitions the states of @a ma by their class, see StateClass. The value
+* iteration kernels loop over the ranges of the classes they touch instead
+* of testing every state in every sweep. Has to be computed again whenever
+* the goal states or the locks change.
+*
+* @param ma the MA
+* @param locks lock states, or NULL if there are none
+* @return new partition
+*/
+StatePartition *StatePartition_new(const SparseMatrix *ma, const bool *locks)
+{
+	StatePartition *part = new StatePartition;
+	unsigned long counts[NUM_STATE_CLASSES] = { 0 };
+	unsigned char *classes = (unsigned char *) malloc((ma->n > 0 ? ma->n : 1) * sizeof(unsigned char));
+
+	for (unsigned long state_nr = 0; state_nr < ma->n; state_nr++) {
+		bool ps = ma->isPS[state_nr];
+		if (ma->goals[state_nr])
+			classes[state_nr] = ps ? CLASS_PS_GOAL : CLASS_MS_GOAL;
+		else if (locks != NULL && locks[state_nr])
+			classes[state_nr] = ps ? CLASS_PS_LOCK : CLASS_MS_LOCK;
+		else
+			classes[state_nr] = ps ? CLASS_PS : CLASS_MS;
+		counts[classes[state_nr]]++;
+	}
+	part->starts[0] = 0;
+	for (int c = 0; c < NUM_STATE_CLASSES; c++)
+		part->starts[c + 1] = part->starts[c] + counts[c];
+
+	unsigned long next[NUM_STATE_CLASSES];
+	for (int c = 0; c < NUM_STATE_CLASSES; c++)
+		next[c] = part->starts[c];
+	part->states = (sparse_index *) malloc((ma->n > 0 ? ma->n : 1) * sizeof(sparse_index));
+	for (unsigned long state_nr = 0; state_nr < ma->n; state_nr++)
+		part->states[next[classes[state_nr]]++] = state_nr;
+
+	free(classes);
+	return part;
+}
+
+/**
+* Frees the partition.
+*
+* @param part the partition
+*/
+void StatePartition_free(StatePartition *part)
+{
+	if (part == NULL)
+		return;
+	free(part->states);
+	delete part;
+}
+
+/**
+* Orders the states @a updated_states for the sweeps, see SweepOrder. The
+* strongly connected components of the transitions between these states are
+* found by the Tarjan search of SCCSearch, which completes the successors of
+* a component first. Consecutive acyclic components are merged into one block.
+*
+* @param ma the MA
+* @param updated_states the updated states
+* @param num_updated # of updated states
+* @param first value of SweepOrder::first
+* @return new order
+*/
+static SweepOrder *sweep_order(const SparseMatrix *ma, const sparse_index *updated_states, unsigned long num_updated, unsigned long first)
+{
+	sparse_index *row_starts = ma->row_starts;
+	sparse_index *choice_starts = ma->choice_starts;
+	sparse_index *cols = ma->cols;
+	unsigned long n = ma->n > 0 ? ma->n : 1;
+	unsigned long m = num_updated > 0 ? num_updated : 1;
+	unsigned long nr_choices = row_starts[ma->n] > 0 ? row_starts[ma->n] : 1;
+
+	SweepOrder *order = new SweepOrder;
+	order->first = first;
+	order->n = 0;
+	order->states = (sparse_index *) malloc(m * sizeof(sparse_index));
+	order->block_starts = (sparse_index *) malloc((m + 1) * sizeof(sparse_index));
+	order->cyclic = (bool *) malloc(m * sizeof(bool));
+
+	/* the fixed states are left out of the search */
+	bool *fixed = (bool *) malloc(n * sizeof(bool));
+	bool *no_choices = (bool *) calloc(nr_choices, sizeof(bool));
+	sparse_index *comp_starts = (sparse_index *) malloc((m + 1) * sizeof(sparse_index));
+	for (unsigned long state_nr = 0; state_nr < ma->n; state_nr++)
+		fixed[state_nr] = true;
+	for (unsigned long k = 0; k < num_updated; k++)
+		fixed[updated_states[k]] = false;
+
+	SCCSearch *search = SCCSearch_new(ma, fixed, no_choices, SCC_BAD_NONE);
+	SCCSearch_record(search, order->states, comp_starts);
+	vector<unsigned long> scc_states(ma->n, 0);
+	unsigned long scc_nr = 1;
+	for (unsigned long k = 0; k < num_updated; k++) {
+		if (!SCCSearch_visited(search, updated_states[k]))
+			SCCSearch_visit(search, updated_states[k], scc_states, scc_nr);
+	}
+
+	bool last_cyclic = true;
+	for (unsigned long c = 0; c < search->completed_n; c++) {
+		unsigned long state_nr = order->states[comp_starts[c]];
+		bool cyclic = comp_starts[c + 1] - comp_starts[c] > 1;
+		if (!cyclic) {
+			for (unsigned long t = choice_starts[row_starts[state_nr]]; t < choice_starts[row_starts[state_nr + 1]]; t++) {
+				if (cols[t] == state_nr)
+					cyclic = true;
+			}
+		}
+		if (cyclic || last_cyclic) {
+			order->block_starts[order->n] = comp_starts[c];
+			order->cyclic[order->n] = cyclic;
+			order->n++;
+		}
+		last_cyclic = cyclic;
+	}
+	order->block_starts[order->n] = comp_starts[search->completed_n];
+
+	SCCSearch_free(search);
+	free(fixed);
+	free(no_choices);
+	free(comp_starts);
+	return order;
+}
+
+/**
+* Orders the states at positions @a first and later of @a part for the
+* probabilistic sweeps, see SweepOrder.
+*
+* @param ma the MA
+* @param part the state partition of the MA
+* @param first first position in the partition of the updated states
+* @return new order
+*/
+SweepOrder *SweepOrder_new(const SparseMatrix *ma, const StatePartition *part, unsigned long first)
+{
+	return sweep_order(ma, part->states + first, part->starts[NUM_STATE_CLASSES] - first, first);
+}
+
+/**
+* Orders arbitrary states of @a ma, Markovian and probabilistic alike, into
+* strongly connected components, successors first. SweepOrder::first is 0.
+*
+* @param ma the MA
+* @param states the updated states
+* @param num_states # of updated states
+* @return new order
+*/
+SweepOrder *SweepOrder_states_new(const SparseMatrix *ma, const sparse_index *states, unsigned long num_states)
+{
+	return sweep_order(ma, states, num_states, 0);
+}
+
+/**
+* Frees the order.
+*
+* @param order the order
+*/
+void SweepOrder_free(SweepOrder *order)
+{
+	if (order == NULL)
+		return;
+	free(order->states);
+	free(order->block_starts);
+	free(order->cyclic);
+	delete order;
+}
+
+/**
+* Drops the results of the graph analyses which depend on the goal states
+* and passes the goal states on to the discretised model. Has to be called
+* whenever the goal states of @a sparse are changed.
+*
+* @param sparse the MA
+*/
+void SparseMatrix_goals_changed(SparseMatrix *sparse) {
+	free(sparse->locks_strong);
+	free(sparse->locks_weak);
+	sparse->locks_strong = NULL;
+	sparse->locks_weak = NULL;
+	if (sparse->discrete != NULL)
+		memcpy(sparse->discrete->goals, sparse->goals, sparse->n * sizeof(bool));
+}
+
 /**
 * This function frees the sparse matrix.
 * @param sparse the matrix to be freed
@@ -271,9 +630,181 @@ void SparseMatrixMEC_free(SparseMatrixMEC *sparse) {
 	if (sparse->cols != NULL) {
 		free(sparse->cols);
 	}
-	if (NULL != sparse->row_counts) {
-		free(sparse->row_counts);
+	if (NULL != sparse->row_starts) {
+		free(sparse->row_starts);
 	}
 	
 	//free(sparse);
 }
+
+/* FNV-1a hash of a state name */
+static unsigned long hash_name(const char *name, size_t length)
+{
+	unsigned long long hash = 14695981039346656037ULL;
+	for (size_t i = 0; i < length; i++) {
+		hash ^= (unsigned char) name[i];
+		hash *= 1099511628211ULL;
+	}
+	return (unsigned long) hash;
+}
+
+/**
+* Creates an empty set of state names.
+*
+* @return new state names
+*/
+StateNames *StateNames_new(void)
+{
+	StateNames *names = new StateNames;
+	names->n = 0;
+	names->arena_n = 0;
+	names->arena_size = 4096;
+	names->arena = (char *) malloc(names->arena_size);
+	names->offsets_size = 1024;
+	names->offsets = (unsigned long *) malloc(names->offsets_size * sizeof(unsigned long));
+	names->hashes = (unsigned long *) malloc(names->offsets_size * sizeof(unsigned long));
+	names->table_size = 2048;
+	names->table = (unsigned long *) calloc(names->table_size, sizeof(unsigned long));
+	names->refs = 1;
+	return names;
+}
+
+/**
+* Drops one reference to the state names and frees them if it was the last.
+*
+* @param names the state names to be freed
+*/
+void StateNames_free(StateNames *names)
+{
+	if (names == NULL || --names->refs > 0)
+		return;
+	free(names->arena);
+	free(names->offsets);
+	free(names->hashes);
+	free(names->table);
+	delete names;
+}
+
+/**
+* Doubles the hash table and inserts all names again.
+*
+* @param names the state names
+*/
+static void state_names_rehash(StateNames *names)
+{
+	unsigned long size = names->table_size * 2;
+	unsigned long mask = size - 1;
+	unsigned long *table = (unsigned long *) calloc(size, sizeof(unsigned long));
+	for (unsigned long nr = 0; nr < names->n; nr++) {
+		unsigned long slot = names->hashes[nr] & mask;
+		while (table[slot] != 0)
+			slot = (slot + 1) & mask;
+		table[slot] = nr + 1;
+	}
+	free(names->table);
+	names->table = table;
+	names->table_size = size;
+}
+
+/**
+* Looks up the slot of a name in the hash table.
+*
+* @return slot of the name, or the free slot where it belongs
+*/
+static unsigned long state_names_slot(const StateNames *names, const char *name, size_t length, unsigned long hash)
+{
+	unsigned long mask = names->table_size - 1;
+	unsigned long slot = hash & mask;
+	for (;;) {
+		unsigned long entry = names->table[slot];
+		if (entry == 0)
+			return slot;
+		unsigned long nr = entry - 1;
+		if (names->hashes[nr] == hash) {
+			const char *other = names->arena + names->offsets[nr];
+			if (memcmp(other, name, length) == 0 && other[length] == '\0')
+				return slot;
+		}
+		slot = (slot + 1) & mask;
+	}
+}
+
+/**
+* Returns the number of a state name, the name gets the next free number if
+* it is not known yet.
+*
+* @param names the state names
+* @param name the name (need not be terminated)
+* @param length length of the name
+* @param inserted set to true if the name was not known before
+* @return number of the name
+*/
+unsigned long state_names_insert(StateNames *names, const char *name, size_t length, bool *inserted)
+{
+	unsigned long hash = hash_name(name, length);
+	unsigned long slot = state_names_slot(names, name, length, hash);
+	if (names->table[slot] != 0) {
+		*inserted = false;
+		return names->table[slot] - 1;
+	}
+	*inserted = true;
+
+	/* keep the load factor of the table below 1/2 */
+	if (2 * (names->n + 1) > names->table_size) {
+		state_names_rehash(names);
+		slot = state_names_slot(names, name, length, hash);
+	}
+	if (names->n == names->offsets_size) {
+		names->offsets_size *= 2;
+		names->offsets = (unsigned long *) realloc(names->offsets, names->offsets_size * sizeof(unsigned long));
+		names->hashes = (unsigned long *) realloc(names->hashes, names->offsets_size * sizeof(unsigned long));
+	}
+	while (names->arena_n + length + 1 > names->arena_size) {
+		names->arena_size *= 2;
+		names->arena = (char *) realloc(names->arena, names->arena_size);
+	}
+	unsigned long nr = names->n++;
+	memcpy(names->arena + names->arena_n, name, length);
+	names->arena[names->arena_n + length] = '\0';
+	names->offsets[nr] = names->arena_n;
+	names->hashes[nr] = hash;
+	names->arena_n += length + 1;
+	names->table[slot] = nr + 1;
+	return nr;
+}
+
+/**
+* @param names the state names
+* @param name the name (need not be terminated)
+* @param length length of the name
+* @return number of the name, or NO_STATE_NAME if it is unknown
+*/
+unsigned long state_names_find(const StateNames *names, const char *name, size_t length)
+{
+	unsigned long slot = state_names_slot(names, name, length, hash_name(name, length));
+	return names->table[slot] - 1;
+}
+
+/**
+* Gives every state a new number.
+*
+* @param names the state names
+* @param new_nr maps the old number of each state to its new number (a permutation)
+*/
+void state_names_renumber(StateNames *names, const unsigned long *new_nr)
+{
+	unsigned long *offsets = (unsigned long *) malloc(names->offsets_size * sizeof(unsigned long));
+	unsigned long *hashes = (unsigned long *) malloc(names->offsets_size * sizeof(unsigned long));
+	for (unsigned long nr = 0; nr < names->n; nr++) {
+		offsets[new_nr[nr]] = names->offsets[nr];
+		hashes[new_nr[nr]] = names->hashes[nr];
+	}
+	for (unsigned long slot = 0; slot < names->table_size; slot++) {
+		if (names->table[slot] != 0)
+			names->table[slot] = new_nr[names->table[slot] - 1] + 1;
+	}
+	free(names->offsets);
+	free(names->hashes);
+	names->offsets = offsets;
+	names->hashes = hashes;
+}
@@ -0,0 +1,118 @@
+/**
+* IMCA is a analyzing tool for unbounded reachability probabilities, expected-
+* time, and long-run averages for Interactive Markov Chains and Markov Automata.
+* Copyright (C) RWTH Aachen, 2012
+*				UTwente, 2013
+* 	Author: Dennis Guck
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*
+*
+* Source description:
+*	Topological value iteration for unbounded reachability, expected time
+*	and expected reward. The non-goal states are split into their strongly
+*	connected components, which are solved successors first. A state of an
+*	acyclic component only depends on states which already have their
+*	final value, so it is done after a single backup. A cyclic component is
+*	iterated until it is stable and is never visited again afterwards.
+*/
+
+#include "topological.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <iostream>
+#include <vector>
+
+#include "debug.h"
+#include "interval_iteration.h"
+
+using namespace std;
+
+Real topological_value_iteration(SparseMatrix *ma, ValueObjective objective, bool max)
+{
+	SparseMatrix_prepare(ma);
+	unsigned long n = ma->n;
+	sparse_index *row_starts = ma->row_starts;
+	sparse_index *choice_starts = ma->choice_starts;
+	sparse_index *cols = ma->cols;
+	Real *branching = ma->branching;
+	bool reachability = (objective == OBJECTIVE_REACHABILITY);
+
+	// probabilities are approached from below, times and rewards from above
+	vector<Real> u(n, reachability ? 0 : infinity);
+	sparse_index *states = (sparse_index *) malloc((n > 0 ? n : 1) * sizeof(sparse_index));
+	unsigned long num_states = 0;
+	for (unsigned long state_nr = 0; state_nr < n; state_nr++) {
+		if (ma->goals[state_nr])
+			u[state_nr] = reachability ? 1 : 0;
+		else
+			states[num_states++] = state_nr;
+	}
+	SweepOrder *order = SweepOrder_states_new(ma, states, num_states);
+	free(states);
+
+	// time or reward of each choice until the next state
+	vector<Real> cost;
+	choice_costs(ma, objective, cost);
+
+	unsigned long num_cyclic = 0;
+	unsigned long backups = 0;
+	cout << "start topological value iteration" << endl;
+	for (unsigned long b = 0; b < order->n; b++) {
+		unsigned long b_start = order->block_starts[b];
+		unsigned long b_end = order->block_starts[b + 1];
+		bool cyclic = order->cyclic[b];
+		if (cyclic)
+			num_cyclic++;
+		// an acyclic block is done after one pass, a cyclic one once a pass changes none of its values
+		bool done;
+		do {
+			done = true;
+			for (unsigned long k = b_start; k < b_end; k++) {
+				unsigned long state_nr = order->states[k];
+				bool any = false;
+				Real best = reachability ? 0 : infinity;
+				for (unsigned long choice_nr = row_starts[state_nr]; choice_nr < row_starts[state_nr + 1]; choice_nr++) {
+					Real tmp = cost[choice_nr];
+					unsigned long i_start = choice_starts[choice_nr];
+					unsigned long i_end = choice_starts[choice_nr + 1];
+					for (unsigned long i = i_start; i < i_end; i++)
+						tmp += branching[i] * u[cols[i]];
+					if (!any || (max ? tmp > best : tmp < best))
+						best = tmp;
+					any = true;
+				}
+				if (cyclic && best != u[state_nr])
+					done = false;
+				u[state_nr] = best;
+			}
+			backups += b_end - b_start;
+		} while (!done);
+	}
+	cout << "topological order: " << order->block_starts[order->n] << " states in " << order->n << " blocks, " << num_cyclic << " cyclic" << endl;
+	cout << "backups: " << backups << endl;
+	SweepOrder_free(order);
+
+	// find the value of the initial states and return
+	Real obj = max ? 0 : infinity;
+	for (unsigned long state_nr = 0; state_nr < n; state_nr++) {
+		if (ma->initials[state_nr]) {
+			if (max ? u[state_nr] > obj : u[state_nr] < obj)
+				obj = u[state_nr];
+		}
+	}
+	return obj;
+}
@@ -90,12 +90,11 @@ static void set_constraints_unb(SoPlex& lp_model, SparseMatrix *ma, bool max, bo
 	unsigned long states = ma->n;
 	bool *goals = ma->goals;
 	//map<unsigned long,string> states_nr = ma->states_nr;
-	unsigned long *row_starts = (unsigned long *) ma->row_counts;
-	unsigned long *rate_starts = (unsigned long *) ma->rate_counts;
-	unsigned long *choice_starts = (unsigned long *) ma->choice_counts;
-	Real *non_zeros = ma->non_zeros;
-	Real *exit_rates = ma->exit_rates;
-	unsigned long *cols = ma->cols;
+	SparseMatrix_prepare(ma);
+	sparse_index *row_starts = ma->row_starts;
+	sparse_index *choice_starts = ma->choice_starts;
+	Real *branching = ma->branching;
+	sparse_index *cols = ma->cols;
 	Real prob;
 	
 	int m=0; // greater equal 0
@@ -117,12 +116,7 @@ static void set_constraints_unb(SoPlex& lp_model, SparseMatrix *ma, bool max, bo
 				unsigned long i_start = choice_starts[choice_nr];
 				unsigned long i_end = choice_starts[choice_nr + 1];
 				for (i = i_start; i < i_end; i++) {
-					prob=non_zeros[i];
-					unsigned long r_start = rate_starts[state_nr];
-					unsigned long r_end = rate_starts[state_nr + 1];
-					for (unsigned long j = r_start; j < r_end; j++) {
-						prob /= exit_rates[j];
-					}
+					prob=branching[i];
 					//printf("%s - %lf -> %s\n",(states_nr.find(state_nr)->second).c_str(),prob,(states_nr.find(cols[i])->second).c_str());
 					if(state_nr==cols[i]) {
 						loop=true;
@@ -148,125 +142,113 @@ static void set_constraints_unb(SoPlex& lp_model, SparseMatrix *ma, bool max, bo
 * @param ma the MA
 * @param v Markovian vector
 * @param u result vector
+* @param part state partition of the MA
 */
-void compute_ub_markovian_vector(SparseMatrix* ma, vector<Real>& v, const vector<Real> &u, bool* locks){
-	unsigned long *row_starts = (unsigned long *) ma->row_counts;
-	unsigned long *choice_starts = (unsigned long *) ma->choice_counts;
-	unsigned long *rate_starts = (unsigned long *) ma->rate_counts;
-	unsigned long *cols = ma->cols;
-	Real *non_zeros = ma->non_zeros;
-	Real *exit_rates = ma->exit_rates;
-	bool *goals = ma->goals;
-	for (unsigned long state_nr = 0; state_nr < ma->n; state_nr++) {
+void compute_ub_markovian_vector(SparseMatrix* ma, vector<Real>& v, const vector<Real> &u, const StatePartition *part){
+	SparseMatrix_prepare(ma);
+	sparse_index *row_starts = ma->row_starts;
+	sparse_index *choice_starts = ma->choice_starts;
+	sparse_index *cols = ma->cols;
+	Real *branching = ma->branching;
+	const sparse_index *states = part->states;
+	// Look at Markovian states
+	#pragma omp parallel for schedule(static) if(part->starts[CLASS_MS_LOCK] - part->starts[CLASS_MS] >= PARALLEL_MIN_STATES)
+	for (unsigned long k = part->starts[CLASS_MS]; k < part->starts[CLASS_MS_LOCK]; k++) {
+		unsigned long state_nr = states[k];
 		unsigned long state_start = row_starts[state_nr];
 		unsigned long state_end = row_starts[state_nr + 1];
-		// Look at Markovian states
-		if(goals[state_nr]){
-			v[state_nr]=1.0;
-		}else if(locks[state_nr]){
-			v[state_nr]=0.0;
-		}else {
-			if(!ma->isPS[state_nr])
-			{
-				for (unsigned long choice_nr = state_start; choice_nr < state_end; choice_nr++) {
-					// Add up all outgoing rates of the distribution
-					unsigned long i_start = choice_starts[choice_nr];
-					unsigned long i_end = choice_starts[choice_nr + 1];
-					Real exit_rate;
-					unsigned long r_start = rate_starts[state_nr];
-					unsigned long r_end = rate_starts[state_nr + 1];
-					for (unsigned long j = r_start; j < r_end; j++) {
-						 exit_rate = ma->exit_rates[j];
-					}
-					v[state_nr] = 0;
-					for (unsigned long i = i_start; i < i_end; i++) {
-						v[state_nr] += (non_zeros[i]/exit_rate) * u[cols[i]];
-					}
-				}
-			}else {
-					v[state_nr] = u[state_nr];
+		for (unsigned long choice_nr = state_start; choice_nr < state_end; choice_nr++) {
+			// Add up all outgoing rates of the distribution
+			unsigned long i_start = choice_starts[choice_nr];
+			unsigned long i_end = choice_starts[choice_nr + 1];
+			v[state_nr] = 0;
+			for (unsigned long i = i_start; i < i_end; i++) {
+				v[state_nr] += branching[i] * u[cols[i]];
 			}
 		}
 	}
+	// lock states
+	for (unsigned long k = part->starts[CLASS_MS_LOCK]; k < part->starts[CLASS_MS_GOAL]; k++) {
+		v[states[k]]=0.0;
+	}
+	for (unsigned long k = part->starts[CLASS_PS_LOCK]; k < part->starts[CLASS_PS]; k++) {
+		v[states[k]]=0.0;
+	}
+	// goal states
+	for (unsigned long k = part->starts[CLASS_MS_GOAL]; k < part->starts[CLASS_PS_LOCK]; k++) {
+		v[states[k]]=1.0;
+	}
+	// probabilistic states
+	for (unsigned long k = part->starts[CLASS_PS]; k < part->starts[NUM_STATE_CLASSES]; k++) {
+		v[states[k]] = u[states[k]];
+	}
 }
 
 /**
 * computes one step for probabilistic states
 *
 * @param ma the MA
-* @param v Markovian vector (we use it as temporary variable for u vector elements as well, so its value after calling of the function is not valid)
-* @param u result vector
+* @param v Markovian vector
+* @param u result vector, holds the values of the last sweep
+* @param part state partition of the MA
+* @param order order of the interactive states
 * @param max maximum/minimum
 */
-void compute_ub_probabilistic_vector(SparseMatrix* ma, vector<Real>& v, vector<Real>& u, bool max, bool* locks){
+void compute_ub_probabilistic_vector(SparseMatrix* ma, vector<Real>& v, vector<Real>& u, const StatePartition *part, const SweepOrder *order, bool max){
 
 	const Real precision = 1e-7;
-	unsigned long statecount = ma-> n;
-	unsigned long *row_starts = (unsigned long *) ma->row_counts;
-	unsigned long *choice_starts = (unsigned long *) ma->choice_counts;
-	unsigned long *cols = ma->cols;
+	sparse_index *row_starts = ma->row_starts;
+	sparse_index *choice_starts = ma->choice_starts;
+	sparse_index *cols = ma->cols;
 	Real* non_zeros = ma->non_zeros;
+	const sparse_index *states = part->states;
+	const sparse_index *order_states = order->states;
 
-	// Initialization
-	for (unsigned long s_idx = 0; s_idx < statecount; s_idx++) {
-		if ( ma -> isPS[s_idx] && !ma -> goals[s_idx] )
-			v[s_idx] = 0;
-		else
-			u[s_idx] = v[s_idx];
-
+	// Initialization: the states before the interactive ones keep their values
+	for (unsigned long k = 0; k < order->first; k++) {
+		u[states[k]] = v[states[k]];
 	}
-	// main loop
-	bool done = false;
-	// done will set to true inside the while loop when we reach fixed point
-	while (! done) {
-		done = true;
-
-
-		// do one step of fixed point, it is applied on interactive states
-		for (unsigned long s_idx = 0; s_idx < statecount; s_idx++) {
-			unsigned long state_start = row_starts[s_idx];
-			unsigned long state_end = row_starts[s_idx + 1];
-			if ( ma -> isPS[s_idx] && !ma -> goals[s_idx] && !locks[s_idx]){  // do processing only if the state is interactive
-				if (max)
-					u[s_idx] = 0.0;
-				else
-					u[s_idx] = 1.0;
+	// solve one block after another, the successors of a block are solved before it
+	for (unsigned long b = 0; b < order->n; b++) {
+		unsigned long b_start = order->block_starts[b];
+		unsigned long b_end = order->block_starts[b + 1];
+		bool cyclic = order->cyclic[b];
+		// an acyclic block is done after one pass, a cyclic one when it is close enough to the fixed point.
+		// A cyclic block goes on from its values of the last sweep: solved from scratch each time, it
+		// could keep moving by less than the precision and the sweeps would never become stable.
+		bool done;
+		do {
+			done = true;
+			for (unsigned long k = b_start; k < b_end; k++) {
+				unsigned long s_idx = order_states[k];
+				unsigned long state_start = row_starts[s_idx];
+				unsigned long state_end = row_starts[s_idx + 1];
+				Real best = max ? 0.0 : 1.0;
 
-				// find the max/min prob. to reach Markovians and store it to tmp
+				// find the max/min prob. to reach Markovians and store it to best
 				for (unsigned long choice_nr = state_start; choice_nr < state_end; choice_nr++) {
 					Real tmp = 0;
 					// Add up all outgoing rates of the distribution
 					unsigned long i_start = choice_starts[choice_nr];
 					unsigned long i_end = choice_starts[choice_nr + 1];
 					for (unsigned long i = i_start; i < i_end; i++) {
-						tmp += non_zeros[i] * v[cols[i]];
+						tmp += non_zeros[i] * u[cols[i]];
 					}
 					if( max ) {
-						if(tmp > u[s_idx] )
-							u[s_idx] = tmp;
+						if(tmp > best )
+							best = tmp;
 					}
 					else {
-						if(tmp < u[s_idx] )
-							u[s_idx] = tmp;
+						if(tmp < best )
+							best = tmp;
 					}
 				}
-				if( fabs(u[s_idx] - v[s_idx]) >= precision )
+				if( cyclic && fabs(best - u[s_idx]) >= precision )
 					done = false;
-					
-
+				u[s_idx] = best;
 			}
-		}
-
- 		bool *initials = ma->initials;
-		// write back u to v, only for interactive elements
-		for (unsigned long s_idx = 0; s_idx < statecount; s_idx++) {
-			if ( ma -> isPS[s_idx] && !ma -> goals[s_idx] ){
-				v[s_idx] = u[s_idx];
-			}
-		}
-
+		} while (! done);
 	}
-	
 }
 
 /**
@@ -294,17 +276,18 @@ Real unbounded_value_iteration(SparseMatrix* ma, bool max) {
 		}
 	}
 	
-	bool *locks=(bool *)malloc(ma->n * sizeof(bool));
+	// no lock states in value iteration, all flags are false
+	bool *locks=(bool *)calloc(ma->n > 0 ? ma->n : 1, sizeof(bool));
 	/*
 	if(max) {
 		locks=compute_locks_weak(ma);
 	} else {
 		locks=compute_locks_strong(ma);
 	}*/
-	
-	for(unsigned long i=0; i<ma->n; i++) {
-		locks[i]=false;
-	}
+
+	// Markovian, probabilistic, goal and lock states as contiguous index ranges
+	StatePartition *part = StatePartition_new(ma, locks);
+	SweepOrder *order = SweepOrder_new(ma, part, part->starts[CLASS_PS]);
 	
 	cout << "start value iteration" << endl;
 	
@@ -314,12 +297,15 @@ Real unbounded_value_iteration(SparseMatrix* ma, bool max) {
 		tmp=u;
 		//done=true;
 		// compute v for Markovian states: from b dwon to a, we make discrete model absorbing
-		compute_ub_markovian_vector(ma,v,u,locks);
+		compute_ub_markovian_vector(ma,v,u,part);
 		// compute u for Probabilistic states
-		compute_ub_probabilistic_vector(ma,v,u,max,locks);
+		compute_ub_probabilistic_vector(ma,v,u,part,order,max);
 		if(tmp==u)
 			done=true;
 	}
+	SweepOrder_free(order);
+	StatePartition_free(part);
+	free(locks);
 
 	// find prob. for initial state and return
 	Real obj;
@@ -329,7 +315,7 @@ Real unbounded_value_iteration(SparseMatrix* ma, bool max) {
 		obj=1;
 	bool *initials = ma->initials;
 	for (unsigned long state_nr = 0; state_nr < num_states; state_nr++) {
-		//cout << (ma->states_nr.find(state_nr)->second).c_str() << ": " << u[state_nr] << endl;
+		//cout << state_name(ma->names, state_nr) << ": " << u[state_nr] << endl;
 		if(initials[state_nr]){
 			if(max){
 				if(obj<u[state_nr])